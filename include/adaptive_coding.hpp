@@ -0,0 +1,227 @@
+
+#pragma once
+
+#include "bit_packing.hpp"
+#include "delta_coding.hpp"
+#include "io_span.hpp"
+#include "run_length.hpp"
+#include "varint.hpp"
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+/*
+    Kernels of the adaptive encoding of integer containers.
+
+    Each block of up to 'adaptive_block' values is written with the cheapest codec for it,
+    after a byte holding the codec :
+        - raw                : the values.
+        - varint             : the values (zigzag-encoded if signed) as varints.
+        - frame_of_reference : the minimum, the width in bits (1 byte) and the packed offsets.
+        - runs               : the number of runs (1 byte), then the length (1 byte) and the value of each run.
+        - delta              : the first value, then the zigzag-encoded deltas as a frame_of_reference block.
+    The sizes of all the codecs are computed exactly, the blocks being small.
+*/
+
+namespace tom {
+
+namespace detail::adaptive {
+
+    constexpr size_t adaptive_block = 128;
+
+    enum class block_codec : std::uint8_t { raw, varint, frame_of_reference, runs, delta, count };
+
+    // The span a block is decoded from : it fails on corrupted blocks.
+    using block_span = input_span<span_policy::error>;
+
+    template <class T>
+    using unsigned_t = std::make_unsigned_t<T>;
+
+    // The value written by the varint codec.
+    template <class T>
+    unsigned_t<T> varint_value(T value) noexcept {
+        auto const bits = static_cast<unsigned_t<T>>(value);
+        if constexpr (std::is_signed_v<T>) return delta_coding::zigzag_encode(bits);
+        else return bits;
+    }
+
+    template <class T>
+    T from_varint_value(unsigned_t<T> value) noexcept {
+        if constexpr (std::is_signed_v<T>) return static_cast<T>(delta_coding::zigzag_decode(value));
+        else return value;
+    }
+
+    template <class T>
+    void delta_terms(T const* values, size_t count, unsigned_t<T>* terms) noexcept {
+        for (size_t i = 1; i < count; ++i) terms[i - 1] = delta_coding::term<1>(values, i);
+    }
+
+    template <class T>
+    size_t packed_block_size(unsigned width, size_t count) noexcept {
+        return sizeof(T) + 1 + packing::packed_size(count, width);
+    }
+
+    // Chooses the cheapest codec for 'count' (> 0) values, and gives it's size without the codec byte.
+    template <class T>
+    block_codec choose_codec(T const* values, size_t count, size_t& encoded) noexcept {
+        using U = unsigned_t<T>;
+        auto const bytes = reinterpret_cast<std::uint8_t const*>(values);
+
+        size_t varint = 0;
+        for (size_t i = 0; i < count; ++i) varint += varint_size(varint_value(values[i]));
+
+        T min{};
+        auto const width = packing::block_width(values, count, min);
+        auto const runs = count - run_length::count_equal(bytes + sizeof(T), bytes, count - 1, sizeof(T));
+
+        size_t delta = sizeof(T);
+        if (count > 1) {
+            U terms[adaptive_block];
+            U term_min{};
+            delta_terms(values, count, terms);
+            delta += packed_block_size<U>(packing::block_width(terms, count - 1, term_min), count - 1);
+        }
+
+        size_t const sizes[] = {
+            count * sizeof(T),
+            varint,
+            packed_block_size<T>(width, count),
+            1 + runs * (1 + sizeof(T)),
+            delta
+        };
+        auto codec = block_codec::raw;
+        encoded = sizes[0];
+        for (std::uint8_t i = 1; i < static_cast<std::uint8_t>(block_codec::count); ++i) {
+            if (sizes[i] < encoded) {
+                encoded = sizes[i];
+                codec = static_cast<block_codec>(i);
+            }
+        }
+        return codec;
+    }
+
+    // Writes the packed values after their minimum and width, returns the end of the bytes.
+    template <class T>
+    std::uint8_t* encode_packed(T const* values, size_t count, std::uint8_t* out) noexcept {
+        T min{};
+        auto const width = packing::block_width(values, count, min);
+        std::memcpy(out, &min, sizeof(T));
+        out[sizeof(T)] = static_cast<std::uint8_t>(width);
+        packing::encode_block(values, count, min, width, out + sizeof(T) + 1);
+        return out + packed_block_size<T>(width, count);
+    }
+
+    // Writes the values with the chosen codec, in exactly the size given by 'choose_codec'.
+    template <class T>
+    void encode(block_codec codec, T const* values, size_t count, std::uint8_t* out) noexcept {
+        switch (codec) {
+            case block_codec::raw:
+                std::memcpy(out, values, count * sizeof(T));
+                break;
+            case block_codec::varint:
+                for (size_t i = 0; i < count; ++i) out += encode_varint(out, varint_value(values[i]));
+                break;
+            case block_codec::frame_of_reference:
+                encode_packed(values, count, out);
+                break;
+            case block_codec::runs: {
+                auto const runs = out++;
+                *runs = 0;
+                for (size_t i = 0, end; i < count; i = end) {
+                    for (end = i + 1; end < count && values[end] == values[i]; ++end);
+                    *out++ = static_cast<std::uint8_t>(end - i);
+                    std::memcpy(out, values + i, sizeof(T));
+                    out += sizeof(T);
+                    ++*runs;
+                }
+                break;
+            }
+            case block_codec::delta: {
+                std::memcpy(out, values, sizeof(T));
+                if (count == 1) break;
+                unsigned_t<T> terms[adaptive_block];
+                delta_terms(values, count, terms);
+                encode_packed(terms, count - 1, out + sizeof(T));
+                break;
+            }
+            default: break;
+        }
+    }
+
+    template <class T>
+    void decode_raw(block_span& span, size_t count, T* values) {
+        span.read(values, count * sizeof(T));
+    }
+
+    template <class T>
+    void decode_varint(block_span& span, size_t count, T* values) {
+        for (size_t i = 0; i < count; ++i) {
+            std::uint64_t value;
+            read_varint(span, value);
+            if (span.failed()) return;
+            if (value > std::numeric_limits<unsigned_t<T>>::max()) {
+                span.fail("tapeworm : invalid varint");
+                return;
+            }
+            values[i] = from_varint_value<T>(static_cast<unsigned_t<T>>(value));
+        }
+    }
+
+    template <class T>
+    void decode_packed(block_span& span, size_t count, T* values) {
+        T min{};
+        std::uint8_t width = 0;
+        span.read_value(min);
+        span.read_value(width);
+        if (span.failed()) return;
+        if (width > 8 * sizeof(T)) {
+            span.fail("tapeworm : invalid bit width");
+            return;
+        }
+        auto const size = packing::packed_size(count, width);
+        if (!span.check(size)) return;
+        packing::decode_block(reinterpret_cast<std::uint8_t const*>(span.advance(size)), count, min, width, values);
+    }
+
+    template <class T>
+    void decode_runs(block_span& span, size_t count, T* values) {
+        std::uint8_t runs = 0;
+        span.read_value(runs);
+        if (!span.check(runs * (1 + sizeof(T)))) return;
+        size_t filled = 0;
+        for (size_t i = 0; i < runs; ++i) {
+            auto const length = static_cast<std::uint8_t>(*span.advance(1));
+            T value;
+            std::memcpy(&value, span.advance(sizeof(T)), sizeof(T));
+            if (length == 0 || length > count - filled) break;
+            for (size_t j = 0; j < length; ++j) values[filled++] = value;
+        }
+        if (filled != count) span.fail("tapeworm : invalid block");
+    }
+
+    template <class T>
+    void decode_delta(block_span& span, size_t count, T* values) {
+        using U = unsigned_t<T>;
+        span.read_value(values[0]);
+        if (span.failed() || count == 1) return;
+        U terms[adaptive_block];
+        decode_packed(span, count - 1, terms);
+        if (span.failed()) return;
+        for (size_t i = 0; i < count - 1; ++i) terms[i] = delta_coding::zigzag_decode(terms[i]);
+        delta_coding::prefix_sum(terms, count - 1, static_cast<U>(values[0]));
+        std::memcpy(values + 1, terms, (count - 1) * sizeof(T));
+    }
+
+    // The decoders indexed by codec.
+    template <class T>
+    using decoder = void (*)(block_span&, size_t, T*);
+
+    template <class T>
+    constexpr decoder<T> decoders[] = {
+        &decode_raw<T>, &decode_varint<T>, &decode_packed<T>, &decode_runs<T>, &decode_delta<T>
+    };
+
+} // ::detail::adaptive
+
+} // ::tom
@@ -1,7 +1,9 @@
 
 #pragma once
 
-#include <meta.hpp>
+#include "meta.hpp"
+#include <tuple>
+#include <type_traits>
 
 namespace tom {
 
@@ -46,7 +48,7 @@ constexpr bool is_brace_constructible_v = impl::is_brace_constructible_v<T, std:
 
 constexpr int max_arity = 10;
 
-#define fwd(x) static_cast<std::conditional_t<std::is_reference_v<T>, decltype(x) &, decltype(x)>>(x)
+#define fwd(x) static_cast<std::conditional_t<std::is_reference_v<T>, decltype(x) &, decltype(x) &&>>(x)
 
 template <class T>
 constexpr auto as_tuple_impl(T && val, std::integral_constant<int, 0>) {
@@ -54,7 +56,7 @@ constexpr auto as_tuple_impl(T && val, std::integral_constant<int, 0>) {
 }
 template <class T>
 constexpr auto as_tuple_impl(T && val, std::integral_constant<int, 1>) {
-    auto && [v1, v2, v3, v4, v5] = val;
+    auto && [v1] = val;
     return std::forward_as_tuple(fwd(v1));
 }
 template <class T>
@@ -127,10 +129,18 @@ constexpr int get_airity() {
 // Returns the number of elements in an aggregate, or -1 if the type can't
 // be destructured.
 
+namespace detail {
+    template <class T>
+    constexpr int airity() {
+        if constexpr (std::is_aggregate_v<T> && !std::is_union_v<T>) {
+            return get_airity<T, 0>();
+        }
+        else return -1;
+    }
+} // ::detail
+
 template <class T>
-constexpr int airity_v =
-    (std::is_aggregate_v<T> && !std::is_union_v<T>)
-    ? detail::get_airity<T, 0>() : -1;
+constexpr int airity_v = detail::airity<T>();
 
 template <class T>
 constexpr bool is_aggregate_v = airity_v<T> >= 0;
@@ -140,7 +150,7 @@ template <class T, class = std::enable_if_t<
 >>
 constexpr auto as_tuple(T && aggregate) noexcept {
     using tag = std::integral_constant<int, airity_v<remove_cvref_t<T>>>;
-    return detail::as_tuple(TOM_FWD(aggregate), tag{});
+    return detail::as_tuple_impl(TOM_FWD(aggregate), tag{});
 }
 
 template <class Aggregate>
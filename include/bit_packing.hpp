@@ -0,0 +1,288 @@
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define TAPEWORM_SSE2
+#endif
+
+#ifdef _MSC_VER
+    #define TAPEWORM_FORCE_INLINE __forceinline
+#else
+    #define TAPEWORM_FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+/*
+    Bit packing kernels of the frame-of-reference encoding.
+
+    A block of 'packed_block' 32 bits values of 'width' bits is packed in 4 * width words,
+    in the vertical layout of FastPFor's SIMD-BP128 : the value i goes to the lane i % 4,
+    and each lane packs it's 32 values from the lowest bits of it's words.
+    The SSE2 and scalar kernels produce the same bytes.
+
+    The smaller tails are packed horizontally, from the lowest bits of each byte.
+    Offsets of 64 bits wider than 32 bits are split in two planes : the 32 low bits, then the others.
+*/
+
+namespace tom {
+
+namespace detail::packing {
+
+    constexpr size_t packed_block = 128;
+
+    // The number of bits needed to write 'value'.
+    template <class U>
+    constexpr unsigned bit_width(U value) noexcept {
+        unsigned width = 0;
+        for (; value != 0; value >>= 1) ++width;
+        return width;
+    }
+
+    constexpr std::uint32_t low_mask(unsigned width) noexcept {
+        return width >= 32 ? ~std::uint32_t{ 0 } : (std::uint32_t{ 1 } << width) - 1;
+    }
+
+    inline void pack_scalar(std::uint32_t const* in, std::uint32_t* out, unsigned width) noexcept {
+        for (size_t lane = 0; lane < 4; ++lane) {
+            std::uint32_t word = 0;
+            unsigned shift = 0;
+            auto dst = out + lane;
+            for (size_t i = lane; i < packed_block; i += 4) {
+                word |= in[i] << shift;
+                shift += width;
+                if (shift >= 32) {
+                    *dst = word;
+                    dst += 4;
+                    shift -= 32;
+                    word = shift != 0 ? in[i] >> (width - shift) : 0;
+                }
+            }
+        }
+    }
+
+    inline void unpack_scalar(std::uint32_t const* in, std::uint32_t* out, unsigned width) noexcept {
+        if (width == 0) {
+            std::memset(out, 0, packed_block * sizeof(std::uint32_t));
+            return;
+        }
+        auto const mask = low_mask(width);
+        for (size_t lane = 0; lane < 4; ++lane) {
+            auto src = in + lane;
+            auto word = *src;
+            unsigned shift = 0;
+            for (size_t i = lane; i < packed_block; i += 4) {
+                auto value = word >> shift;
+                shift += width;
+                if (shift >= 32) {
+                    shift -= 32;
+                    src += 4;
+                    if (i + 4 < packed_block) {
+                        word = *src;
+                        if (shift != 0) value |= word << (width - shift);
+                    }
+                }
+                out[i] = value & mask;
+            }
+        }
+    }
+
+#ifdef TAPEWORM_SSE2
+
+    inline void pack_sse2(std::uint32_t const* in, std::uint32_t* out, unsigned width) noexcept {
+        auto dst = reinterpret_cast<__m128i*>(out);
+        auto word = _mm_setzero_si128();
+        unsigned shift = 0;
+        for (size_t i = 0; i < packed_block; i += 4) {
+            auto const values = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + i));
+            word = _mm_or_si128(word, _mm_sll_epi32(values, _mm_cvtsi32_si128(static_cast<int>(shift))));
+            shift += width;
+            if (shift >= 32) {
+                _mm_storeu_si128(dst++, word);
+                shift -= 32;
+                word = shift != 0 ?
+                    _mm_srl_epi32(values, _mm_cvtsi32_si128(static_cast<int>(width - shift))) :
+                    _mm_setzero_si128();
+            }
+        }
+    }
+
+    // Inlined in the unpack table, where 'width' is a constant.
+    TAPEWORM_FORCE_INLINE void unpack_sse2(std::uint32_t const* in, std::uint32_t* out, unsigned width) noexcept {
+        if (width == 0) {
+            std::memset(out, 0, packed_block * sizeof(std::uint32_t));
+            return;
+        }
+        auto src = reinterpret_cast<__m128i const*>(in);
+        auto const mask = _mm_set1_epi32(static_cast<int>(low_mask(width)));
+        auto word = _mm_loadu_si128(src);
+        unsigned shift = 0;
+        for (size_t i = 0; i < packed_block; i += 4) {
+            auto values = _mm_srl_epi32(word, _mm_cvtsi32_si128(static_cast<int>(shift)));
+            shift += width;
+            if (shift >= 32) {
+                shift -= 32;
+                if (i + 4 < packed_block) {
+                    word = _mm_loadu_si128(++src);
+                    if (shift != 0) {
+                        values = _mm_or_si128(values,
+                            _mm_sll_epi32(word, _mm_cvtsi32_si128(static_cast<int>(width - shift))));
+                    }
+                }
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_and_si128(values, mask));
+        }
+    }
+
+    // Unpacking with a width known at compile-time, so that the shifts are constants.
+    template <unsigned Width>
+    void unpack_sse2_fixed(std::uint32_t const* in, std::uint32_t* out) noexcept {
+        unpack_sse2(in, out, Width);
+    }
+
+    template <size_t...Widths>
+    constexpr auto make_unpack_table(std::index_sequence<Widths...>) noexcept {
+        using unpack_type = void (*)(std::uint32_t const*, std::uint32_t*);
+        return std::array<unpack_type, sizeof...(Widths)>{ &unpack_sse2_fixed<Widths>... };
+    }
+
+    inline void pack(std::uint32_t const* in, std::uint32_t* out, unsigned width) noexcept {
+        pack_sse2(in, out, width);
+    }
+    inline void unpack(std::uint32_t const* in, std::uint32_t* out, unsigned width) noexcept {
+        static constexpr auto table = make_unpack_table(std::make_index_sequence<33>{});
+        table[width](in, out);
+    }
+
+#else
+
+    inline void pack(std::uint32_t const* in, std::uint32_t* out, unsigned width) noexcept {
+        pack_scalar(in, out, width);
+    }
+    inline void unpack(std::uint32_t const* in, std::uint32_t* out, unsigned width) noexcept {
+        unpack_scalar(in, out, width);
+    }
+
+#endif
+
+    // The number of bytes of 'count' values packed horizontally.
+    constexpr size_t tail_size(size_t count, unsigned width) noexcept {
+        return (count * width + 7) / 8;
+    }
+
+    inline void pack_tail(std::uint32_t const* in, size_t count, std::uint8_t* out, unsigned width) noexcept {
+        std::uint64_t bits = 0;
+        unsigned filled = 0;
+        for (size_t i = 0; i < count; ++i) {
+            bits |= std::uint64_t{ in[i] } << filled;
+            filled += width;
+            for (; filled >= 8; filled -= 8, bits >>= 8) *out++ = static_cast<std::uint8_t>(bits);
+        }
+        if (filled != 0) *out = static_cast<std::uint8_t>(bits);
+    }
+
+    inline void unpack_tail(std::uint8_t const* in, size_t count, std::uint32_t* out, unsigned width) noexcept {
+        auto const mask = low_mask(width);
+        std::uint64_t bits = 0;
+        unsigned filled = 0;
+        for (size_t i = 0; i < count; ++i) {
+            for (; filled < width; filled += 8) bits |= std::uint64_t{ *in++ } << filled;
+            out[i] = static_cast<std::uint32_t>(bits) & mask;
+            bits >>= width;
+            filled -= width;
+        }
+    }
+
+    // The number of bytes of 'count' offsets of 'width' bits.
+    constexpr size_t packed_size(size_t count, unsigned width) noexcept {
+        if (count == packed_block) return 16 * size_t{ width };
+        if (width <= 32) return tail_size(count, width);
+        return 4 * count + tail_size(count, width - 32);
+    }
+
+    inline void pack_plane(std::uint32_t const* in, size_t count, std::uint8_t* out, unsigned width) noexcept {
+        if (count == packed_block) {
+            std::uint32_t words[packed_block];
+            pack(in, words, width);
+            std::memcpy(out, words, 16 * size_t{ width });
+        }
+        else pack_tail(in, count, out, width);
+    }
+
+    inline void unpack_plane(std::uint8_t const* in, size_t count, std::uint32_t* out, unsigned width) noexcept {
+        if (count == packed_block) {
+        #ifdef TAPEWORM_SSE2
+            // The SSE2 kernel only does unaligned loads.
+            unpack(reinterpret_cast<std::uint32_t const*>(in), out, width);
+        #else
+            std::uint32_t words[packed_block];
+            std::memcpy(words, in, 16 * size_t{ width });
+            unpack(words, out, width);
+        #endif
+        }
+        else unpack_tail(in, count, out, width);
+    }
+
+    // Finds the minimum of up to 'packed_block' values, and the width of their offsets to it.
+    template <class T>
+    unsigned block_width(T const* values, size_t count, T& min) noexcept {
+        using U = std::make_unsigned_t<T>;
+        min = values[0];
+        auto max = values[0];
+        for (size_t i = 1; i < count; ++i) {
+            min = values[i] < min ? values[i] : min;
+            max = values[i] > max ? values[i] : max;
+        }
+        return bit_width(static_cast<U>(static_cast<U>(max) - static_cast<U>(min)));
+    }
+
+    // Writes the packed_size(count, width) bytes of the offsets to 'min'.
+    template <class T>
+    void encode_block(T const* values, size_t count, T min, unsigned width, std::uint8_t* out) noexcept {
+        using U = std::make_unsigned_t<T>;
+        std::uint32_t offsets[packed_block];
+        auto const offset = [min] (T value) noexcept {
+            return static_cast<U>(static_cast<U>(value) - static_cast<U>(min));
+        };
+        for (size_t i = 0; i < count; ++i) {
+            offsets[i] = static_cast<std::uint32_t>(offset(values[i]));
+        }
+        if (width <= 32) {
+            pack_plane(offsets, count, out, width);
+            return;
+        }
+        pack_plane(offsets, count, out, 32);
+        if constexpr (sizeof(T) == 8) {
+            for (size_t i = 0; i < count; ++i) {
+                offsets[i] = static_cast<std::uint32_t>(offset(values[i]) >> 32);
+            }
+        }
+        pack_plane(offsets, count, out + packed_size(count, 32), width - 32);
+    }
+
+    template <class T>
+    void decode_block(std::uint8_t const* in, size_t count, T min, unsigned width, T* values) noexcept {
+        using U = std::make_unsigned_t<T>;
+        std::uint32_t offsets[packed_block];
+        unpack_plane(in, count, offsets, width < 32 ? width : 32);
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = static_cast<T>(static_cast<U>(static_cast<U>(min) + static_cast<U>(offsets[i])));
+        }
+        if constexpr (sizeof(T) == 8) {
+            if (width <= 32) return;
+            unpack_plane(in + packed_size(count, 32), count, offsets, width - 32);
+            for (size_t i = 0; i < count; ++i) {
+                values[i] = static_cast<T>(static_cast<U>(values[i]) + (static_cast<U>(offsets[i]) << 32));
+            }
+        }
+    }
+
+} // ::detail::packing
+
+} // ::tom
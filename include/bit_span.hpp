@@ -0,0 +1,117 @@
+
+#pragma once
+
+#include "io_span.hpp"
+#include <cstdint>
+
+/*
+    Bit streams over io spans : the bits are packed from the lowest bit of each byte,
+    and a stream is padded with zeros up to the next byte.
+*/
+
+namespace tom {
+
+namespace detail::bits {
+
+    constexpr std::uint64_t low_mask(unsigned count) noexcept {
+        return count >= 64 ? ~std::uint64_t{ 0 } : (std::uint64_t{ 1 } << count) - 1;
+    }
+
+} // ::detail::bits
+
+// Writes bits in an output span (or a counting_span), by words of 64 bits.
+template <class Span>
+class bit_writer {
+    static_assert(!Span::is_input, "Can't write bits in an input span");
+public:
+    explicit bit_writer(Span& span) noexcept : span_{ span } {}
+
+    bit_writer(bit_writer const&) = delete;
+    bit_writer& operator=(bit_writer const&) = delete;
+
+    // Writes the 'count' (<= 64) low bits of 'bits'.
+    void write(std::uint64_t bits, unsigned count) {
+        if (count == 0) return;
+        bits &= detail::bits::low_mask(count);
+        pending_ |= bits << filled_;
+        auto const filled = filled_ + count;
+        if (filled < 64) {
+            filled_ = filled;
+            return;
+        }
+        write_bytes(pending_, 8);
+        pending_ = filled_ != 0 ? bits >> (64 - filled_) : 0;
+        filled_ = filled - 64;
+    }
+
+    // Writes the pending bits, must be called once at the end of the stream.
+    void flush() {
+        write_bytes(pending_, (filled_ + 7) / 8);
+        pending_ = 0;
+        filled_ = 0;
+    }
+
+    // The number of bytes the stream takes once flushed.
+    size_t size() const noexcept { return written_ + (filled_ + 7) / 8; }
+private:
+    void write_bytes(std::uint64_t word, unsigned count) {
+        std::uint8_t bytes[8];
+        for (unsigned i = 0; i < count; ++i) bytes[i] = static_cast<std::uint8_t>(word >> 8 * i);
+        span_.write(bytes, count);
+        written_ += count;
+    }
+
+    Span& span_;
+    std::uint64_t pending_ = 0;
+    unsigned filled_ = 0;
+    size_t written_ = 0;
+};
+
+// Reads bits from an input span, which fails when reading past it's end.
+template <class Span>
+class bit_reader {
+    static_assert(Span::is_input, "Can't read bits from an output span");
+public:
+    explicit bit_reader(Span& span) noexcept : span_{ span } {}
+
+    bit_reader(bit_reader const&) = delete;
+    bit_reader& operator=(bit_reader const&) = delete;
+
+    // Reads 'count' (<= 64) bits, returns 0 if the span failed.
+    std::uint64_t read(unsigned count) {
+        if (count <= available_) {
+            auto const bits = buffer_ & detail::bits::low_mask(count);
+            buffer_ = count < 64 ? buffer_ >> count : 0;
+            available_ -= count;
+            return bits;
+        }
+        std::uint64_t word;
+        auto const loaded = load(word);
+        auto const missing = count - available_;
+        if (loaded < missing) {
+            span_.fail("tapeworm : truncated bit stream");
+            return 0;
+        }
+        auto const bits = (buffer_ | word << available_) & detail::bits::low_mask(count);
+        buffer_ = missing < 64 ? word >> missing : 0;
+        available_ = loaded - missing;
+        return bits;
+    }
+
+    bool read_bit() { return read(1) != 0; }
+private:
+    // Loads up to 8 bytes, returns the number of bits loaded.
+    unsigned load(std::uint64_t& word) {
+        word = 0;
+        auto const count = span_.size() < 8 ? static_cast<unsigned>(span_.size()) : 8u;
+        auto const bytes = reinterpret_cast<std::uint8_t const*>(span_.advance(count));
+        for (unsigned i = 0; i < count; ++i) word |= std::uint64_t{ bytes[i] } << 8 * i;
+        return 8 * count;
+    }
+
+    Span& span_;
+    std::uint64_t buffer_ = 0;
+    unsigned available_ = 0;
+};
+
+} // ::tom
@@ -0,0 +1,250 @@
+
+#pragma once
+
+#include "lz_codec.hpp"
+#include "serialization.hpp"
+#include <limits>
+#include <new>
+#include <vector>
+
+/*
+    A compression stage between the serializer and the output, on blocks of fixed size
+    compressed independently, so that they can be decompressed as a stream or in parallel.
+
+    Header : the block size as a 'length_type' and the decompressed size (8 bytes).
+    Block  : the stored size as a 'length_type', with the high bit set if the block is
+             stored uncompressed, followed by the stored bytes.
+    Each block holds 'block size' bytes once decompressed, except the last one.
+
+    The codec is a template parameter, it must provide :
+
+    struct codec {
+        // The maximum ratio of the decompressed size to the compressed size, which bounds
+        // the memory allocated for untrusted input.
+        static constexpr size_t max_expansion = 255;
+        // Returns the compressed size, or 0 if it doesn't fit in 'capacity' bytes.
+        static size_t compress(std::byte const* src, size_t size, std::byte* dst, size_t capacity);
+        // Decompresses exactly 'dst_size' bytes, returns false if the input is corrupted.
+        static bool decompress(std::byte const* src, size_t size, std::byte* dst, size_t dst_size);
+    };
+*/
+
+namespace tom {
+
+constexpr size_t default_block_size = size_t{ 1 } << 16;
+
+namespace detail::blocks {
+
+    constexpr length_type stored_flag = length_type{ 1 } << 31;
+    constexpr size_t header_size = sizeof(length_type) + sizeof(std::uint64_t);
+
+    struct header {
+        size_t block_size;
+        std::uint64_t size;
+
+        size_t block_count() const noexcept {
+            return static_cast<size_t>(size / block_size + (size % block_size != 0));
+        }
+        size_t raw_size(size_t index) const noexcept {
+            return static_cast<size_t>(std::min<std::uint64_t>(block_size, size - std::uint64_t{ index } * block_size));
+        }
+    };
+
+    struct block {
+        std::byte const* data;
+        size_t size;
+        bool stored;
+    };
+
+    template <class Span>
+    bool write_header(Span& span, size_t size, size_t block_size) {
+        if (block_size == 0 || block_size >= stored_flag) {
+            span.fail("tapeworm : invalid block size");
+            return false;
+        }
+        span.write_value(static_cast<length_type>(block_size));
+        span.write_value(static_cast<std::uint64_t>(size));
+        return !span.failed();
+    }
+
+    template <class Span>
+    bool read_header(Span& span, header& header) {
+        length_type block_size = 0;
+        header.size = 0;
+        span.read_value(block_size);
+        span.read_value(header.size);
+        if (span.failed()) return false;
+        if (block_size == 0 || block_size >= stored_flag) {
+            span.fail("tapeworm : invalid block size");
+            return false;
+        }
+        header.block_size = block_size;
+        // Each block takes at least it's stored size.
+        if (header.size > std::numeric_limits<size_t>::max() || header.block_count() > span.size() / sizeof(length_type)) {
+            span.fail("tapeworm : invalid decompressed size");
+            return false;
+        }
+        return true;
+    }
+
+    // The decompressed size of a block is checked against it's stored size.
+    template <class Codec, class Span>
+    bool read_block(Span& span, header const& header, size_t index, block& block) {
+        length_type size = 0;
+        span.read_value(size);
+        if (span.failed()) return false;
+        block.stored = (size & stored_flag) != 0;
+        block.size = size & ~stored_flag;
+        auto const raw_size = header.raw_size(index);
+        if (block.stored ? block.size != raw_size : (raw_size + Codec::max_expansion - 1) / Codec::max_expansion > block.size) {
+            span.fail("tapeworm : invalid block size");
+            return false;
+        }
+        if (!span.check(block.size)) return false;
+        block.data = span.advance(block.size);
+        return true;
+    }
+
+    // Writes a block in at most 'capacity' bytes, returns the number of bytes written.
+    template <class Codec>
+    size_t write_block(std::byte const* src, size_t size, std::byte* dst, size_t capacity) {
+        auto const compressed = size > 1 && capacity > sizeof(length_type) ?
+            Codec::compress(src, size, dst + sizeof(length_type), std::min(size - 1, capacity - sizeof(length_type))) : 0;
+        auto const stored_size = compressed != 0 ? compressed : size;
+        auto const tag = static_cast<length_type>(stored_size) | (compressed != 0 ? 0 : stored_flag);
+        std::memcpy(dst, &tag, sizeof(length_type));
+        if (compressed == 0) std::memcpy(dst + sizeof(length_type), src, size);
+        return sizeof(length_type) + stored_size;
+    }
+
+    template <class Codec, class Span>
+    bool decompress_block(Span& span, block const& block, std::byte* dst, size_t size) {
+        if (block.stored) {
+            std::memcpy(dst, block.data, size);
+            return true;
+        }
+        if (Codec::decompress(block.data, block.size, dst, size)) return true;
+        span.fail("tapeworm : corrupted block");
+        return false;
+    }
+
+    // Decompresses a value with 'decompress(span, out)', which must be alone in the blocks.
+    template <class Codec, class Span, class T, class F>
+    void deserialize_value(Span& span, T& value, F&& decompress) {
+        // The headers of the blocks are read first, so that a corrupted size allocates nothing.
+        input_span<span_policy::error> blocks{ span.begin(), span.end() };
+        header header;
+        bool valid = read_header(blocks, header);
+        for (size_t i = 0, count = valid ? header.block_count() : 0; i < count && valid; ++i) {
+            block block;
+            valid = read_block<Codec>(blocks, header, i, block);
+        }
+        if (!valid) {
+            span.fail("tapeworm : invalid compressed blocks");
+            return;
+        }
+
+        if (!serial::detail::allocate<std::byte>(span, static_cast<size_t>(header.size))) return;
+        std::vector<std::byte> buffer;
+        try {
+            buffer.resize(static_cast<size_t>(header.size));
+        }
+        catch (std::bad_alloc const&) {
+            span.fail("tapeworm : can't allocate the decompressed value");
+            return;
+        }
+        output_span<span_policy::error> out{ buffer.data(), buffer.size() };
+        decompress(span, out);
+        if (span.failed()) return;
+
+        input_span<span_policy::error> serial{ buffer.data(), buffer.size() };
+        tom::deserialize(serial, value);
+        if (serial.failed() || serial.size() != 0) span.fail("tapeworm : invalid compressed value");
+    }
+
+} // ::detail::blocks
+
+// The maximum number of bytes written by 'compress_blocks'.
+constexpr size_t compressed_bound(size_t size, size_t block_size = default_block_size) noexcept {
+    return detail::blocks::header_size + size + (size + block_size - 1) / block_size * sizeof(length_type);
+}
+
+// Compresses 'size' bytes by blocks of 'block_size' bytes.
+template <class Codec = lz_codec, class Span>
+void compress_blocks(Span& span, void const* data, size_t size, size_t block_size = default_block_size) {
+    static_assert(!Span::is_input, "Can't compress in an input span");
+    if (!detail::blocks::write_header(span, size, block_size)) return;
+    auto const src = static_cast<std::byte const*>(data);
+    for (size_t first = 0; first < size && !span.failed(); first += block_size) {
+        auto const block = std::min(block_size, size - first);
+        if (!span.check(sizeof(length_type) + block)) return;
+        auto const written = detail::blocks::write_block<Codec>(src + first, block, span.begin(), span.size());
+        span.advance(written);
+        serial::detail::release(span);
+    }
+}
+
+// The decompressed size of the blocks at the front of the span, or 0 if the header is invalid.
+template <class Span>
+std::uint64_t decompressed_size(Span span) {
+    input_span<span_policy::error> copy{ span.begin(), span.end() };
+    detail::blocks::header header;
+    return detail::blocks::read_header(copy, header) ? header.size : 0;
+}
+
+// Decompresses the blocks one by one, calling 'consume(data, size)' on each of them.
+template <class Codec = lz_codec, class Span, class F>
+void for_each_block(Span& span, F&& consume) {
+    using namespace detail::blocks;
+    header header;
+    if (!read_header(span, header)) return;
+    std::vector<std::byte> buffer;
+    for (size_t i = 0, count = header.block_count(); i < count; ++i) {
+        block block;
+        if (!read_block<Codec>(span, header, i, block)) return;
+        auto const size = header.raw_size(i);
+        if (block.stored) {
+            consume(block.data, size);
+            continue;
+        }
+        buffer.resize(header.block_size);
+        if (!decompress_block<Codec>(span, block, buffer.data(), size)) return;
+        consume(static_cast<std::byte const*>(buffer.data()), size);
+    }
+}
+
+// Decompresses the blocks in an output span.
+template <class Codec = lz_codec, class Span, class Out>
+void decompress_blocks(Span& span, Out& out) {
+    static_assert(!Out::is_input, "Can't decompress in an input span");
+    using namespace detail::blocks;
+    header header;
+    if (!read_header(span, header)) return;
+    if (!out.check(header.size)) return;
+    for (size_t i = 0, count = header.block_count(); i < count; ++i) {
+        block block;
+        if (!read_block<Codec>(span, header, i, block)) return;
+        auto const size = header.raw_size(i);
+        if (!decompress_block<Codec>(span, block, out.begin(), size)) return;
+        out.advance(size);
+    }
+}
+
+// Serializes a value, then compresses it.
+template <class Codec = lz_codec, class Span, class T>
+void serialize_compressed(Span& span, T const& value, size_t block_size = default_block_size) {
+    std::vector<std::byte> buffer(tom::serialized_size(value));
+    output_span<span_policy::unsafe> serial{ buffer.data(), buffer.size() };
+    tom::serialize(serial, value);
+    tom::compress_blocks<Codec>(span, buffer.data(), buffer.size(), block_size);
+}
+
+// Decompresses a value, which must be alone in the blocks.
+template <class Codec = lz_codec, class Span, class T>
+void deserialize_compressed(Span& span, T& value) {
+    detail::blocks::deserialize_value<Codec>(span, value, [] (Span& span, auto& out) {
+        tom::decompress_blocks<Codec>(span, out);
+    });
+}
+
+} // ::tom
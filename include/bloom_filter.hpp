@@ -0,0 +1,52 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+    Kernels of Bloom filters on 64 bits hashes, as in LevelDB : the 'k' probes are derived from
+    one hash by double hashing. With 10 bits per key, about 1% of the absent keys pass the filter.
+*/
+
+namespace tom {
+
+namespace detail::bloom {
+
+    constexpr unsigned max_hash_count = 30;
+
+    // The number of probes minimizing the false positives, ln(2) * bits per key.
+    constexpr unsigned hash_count(size_t bits_per_key) noexcept {
+        auto const k = static_cast<unsigned>(bits_per_key * 69 / 100);
+        return k < 1 ? 1 : k > max_hash_count ? max_hash_count : k;
+    }
+
+    // The size in bytes of the filter of 'keys' keys, at least 8 bytes.
+    constexpr size_t filter_size(size_t keys, size_t bits_per_key) noexcept {
+        auto const bits = keys * bits_per_key;
+        return bits < 64 ? 8 : (bits + 7) / 8;
+    }
+
+    inline void add(std::uint8_t* filter, size_t size, std::uint64_t hash, unsigned probes) noexcept {
+        auto const bits = size * 8;
+        auto const delta = hash >> 33 | hash << 31;
+        for (unsigned i = 0; i < probes; ++i, hash += delta) {
+            auto const bit = hash % bits;
+            filter[bit / 8] = static_cast<std::uint8_t>(filter[bit / 8] | 1u << bit % 8);
+        }
+    }
+
+    // False if the key was never added, true if it may have been.
+    inline bool may_contain(std::uint8_t const* filter, size_t size, std::uint64_t hash, unsigned probes) noexcept {
+        auto const bits = size * 8;
+        auto const delta = hash >> 33 | hash << 31;
+        for (unsigned i = 0; i < probes; ++i, hash += delta) {
+            auto const bit = hash % bits;
+            if (!(filter[bit / 8] & 1u << bit % 8)) return false;
+        }
+        return true;
+    }
+
+} // ::detail::bloom
+
+} // ::tom
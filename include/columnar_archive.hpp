@@ -0,0 +1,385 @@
+
+#pragma once
+
+#include "crc32c.hpp"
+#include "decode_limits.hpp"
+#include "field_path.hpp"
+#include "fingerprint.hpp"
+#include "mapped_file.hpp"
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+    Columnar files of tuple-like rows, for scans reading a few row groups out of many.
+
+    The rows are split in row groups. In a row group, each member is written as a column chunk :
+    the serialized vector of it's values (integers with the adaptive encoding, see adaptive_coding.hpp).
+    Each chunk has statistics : the minimum and the maximum of the values if they are ordered
+    (numbers, enums, strings), and the number of empty optionals.
+
+    File format :
+        - the column chunks, row group by row group.
+        - the metadata : for each row group the number of rows, and for each chunk it's offset, size,
+          null count, minimum and maximum (serialized, empty without values), serialized by tapeworm.
+        - the footer : the size of the metadata, the fingerprint of the rows, the CRC32C of the metadata
+          and a magic number.
+
+    Scans check a predicate on the statistics of each row group, and only decode the groups which may match.
+*/
+
+namespace tom {
+
+struct columnar_options {
+    size_t row_group_size = 65536; // The number of rows in a row group.
+};
+
+namespace detail::columnar {
+
+    constexpr std::uint32_t magic = 0x4C435754; // "TWCL"
+
+    struct column_chunk {
+        std::uint64_t offset;
+        std::uint64_t size;
+        std::uint64_t null_count;
+        std::vector<std::byte> min;
+        std::vector<std::byte> max;
+    };
+
+    struct row_group {
+        std::uint64_t rows;
+        std::vector<column_chunk> columns;
+    };
+
+    struct footer {
+        std::uint64_t metadata_size;
+        std::uint64_t fingerprint;
+        std::uint32_t checksum;
+        std::uint32_t magic;
+    };
+
+    static_assert(sizeof(footer) == 24, "The footer must not be padded");
+
+    template <class T>
+    using members_t = path::members_t<T>;
+
+    template <class T>
+    constexpr size_t columns_v = std::tuple_size_v<members_t<T>>;
+
+    // The container of the values of a member in a chunk.
+    template <class M>
+    using chunk_t = std::conditional_t<std::is_integral_v<M> && !std::is_same_v<M, bool>,
+        adaptive_coded<std::vector<M>>, std::vector<M>>;
+
+    template <class M>
+    constexpr bool is_nullable_v = uses_concept_v<M, serial::concept::optional>;
+
+    // The type of the statistics of a member : the value of optionals.
+    template <class M, bool = is_nullable_v<M>>
+    struct stat_value { using type = M; };
+    template <class M>
+    struct stat_value<M, true> { using type = remove_cvref_t<decltype(*std::declval<M const&>())>; };
+
+    template <class M>
+    using stat_value_t = typename stat_value<M>::type;
+
+    template <class V>
+    constexpr bool is_ordered_v = std::is_arithmetic_v<V> || std::is_enum_v<V> || serial::detail::is_string_like_v<V>;
+
+    template <class V>
+    bool less(V const& lhs, V const& rhs) noexcept {
+        if constexpr (serial::detail::is_string_like_v<V>) {
+            return std::string_view{ std::data(lhs), std::size(lhs) } < std::string_view{ std::data(rhs), std::size(rhs) };
+        }
+        else return lhs < rhs;
+    }
+
+    template <class V>
+    std::vector<std::byte> to_bytes(V const& value) {
+        std::vector<std::byte> bytes(tom::serialized_size(value));
+        output_span<> span{ bytes.data(), bytes.size() };
+        tom::serialize(span, value);
+        return bytes;
+    }
+
+    // The statistics of a chunk. NaNs are left out of the minimum and maximum.
+    template <class M>
+    void compute_stats(std::vector<M> const& values, column_chunk& chunk) {
+        using V = stat_value_t<M>;
+        V const* min = nullptr;
+        V const* max = nullptr;
+        chunk.null_count = 0;
+        for (auto const& member : values) {
+            V const* value = nullptr;
+            if constexpr (is_nullable_v<M>) {
+                if (!member) {
+                    ++chunk.null_count;
+                    continue;
+                }
+                value = &*member;
+            }
+            else value = &member;
+            if constexpr (is_ordered_v<V>) {
+                if constexpr (std::is_floating_point_v<V>) {
+                    if (*value != *value) continue;
+                }
+                if (!min || less(*value, *min)) min = value;
+                if (!max || less(*max, *value)) max = value;
+            }
+        }
+        if (min) {
+            chunk.min = to_bytes(*min);
+            chunk.max = to_bytes(*max);
+        }
+    }
+
+} // ::detail::columnar
+
+// The statistics of a column chunk. The minimum and the maximum are empty if the chunk has no ordered values.
+template <class V>
+struct column_stats {
+    std::optional<V> min;
+    std::optional<V> max;
+    size_t null_count = 0;
+    size_t rows = 0;
+};
+
+// Writes a columnar archive of rows of T in a stream, a row group at a time.
+template <class T>
+class columnar_writer {
+    using members = detail::columnar::members_t<T>;
+    static constexpr size_t columns = detail::columnar::columns_v<T>;
+
+    template <class Tuple>
+    struct chunks;
+    template <class...Ms>
+    struct chunks<std::tuple<Ms...>> {
+        using type = std::tuple<detail::columnar::chunk_t<Ms>...>;
+    };
+public:
+    explicit columnar_writer(std::ostream& out, columnar_options options = {}) :
+        out_{ out }, options_{ options } {
+        if (options_.row_group_size == 0) throw std::invalid_argument{ "tapeworm : invalid row group size" };
+    }
+
+    void add(T const& row) {
+        using tuple_concept = typename serial_concept_t<T>::tuple_concept;
+        append(tuple_concept::as_tuple(row), std::make_index_sequence<columns>{});
+        if (++rows_ == options_.row_group_size) flush();
+    }
+
+    // Writes the last row group, the metadata and the footer.
+    // Throws a 'serialization_error' if the stream failed.
+    void finish() {
+        flush();
+        auto const metadata = detail::columnar::to_bytes(groups_);
+        detail::columnar::footer const footer{
+            metadata.size(), fingerprint_v<T>, crc32c(0, metadata.data(), metadata.size()), detail::columnar::magic
+        };
+        write(metadata.data(), metadata.size());
+        write(&footer, sizeof(footer));
+        out_.flush();
+        if (!out_) throw serialization_error{ "tapeworm : can't write the archive" };
+    }
+private:
+    template <class Tuple, size_t...Is>
+    void append(Tuple const& members, std::index_sequence<Is...>) {
+        (std::get<Is>(chunks_).push_back(std::get<Is>(members)), ...);
+    }
+
+    template <size_t...Is>
+    void write_chunks(detail::columnar::row_group& group, std::index_sequence<Is...>) {
+        (write_chunk(std::get<Is>(chunks_), group.columns[Is]), ...);
+    }
+
+    template <class Chunk>
+    void write_chunk(Chunk& values, detail::columnar::column_chunk& chunk) {
+        detail::columnar::compute_stats(values, chunk);
+        chunk.offset = offset_;
+        chunk.size = tom::serialized_size(values);
+        buffer_.resize(chunk.size);
+        output_span<> span{ buffer_.data(), buffer_.size() };
+        tom::serialize(span, values);
+        write(buffer_.data(), buffer_.size());
+        offset_ += chunk.size;
+        values.clear();
+    }
+
+    void flush() {
+        if (rows_ == 0) return;
+        detail::columnar::row_group group{ rows_, std::vector<detail::columnar::column_chunk>(columns) };
+        write_chunks(group, std::make_index_sequence<columns>{});
+        groups_.push_back(std::move(group));
+        rows_ = 0;
+    }
+
+    void write(void const* data, size_t size) {
+        out_.write(static_cast<char const*>(data), static_cast<std::streamsize>(size));
+    }
+
+    std::ostream& out_;
+    columnar_options options_;
+    typename chunks<members>::type chunks_;
+    std::vector<detail::columnar::row_group> groups_;
+    std::vector<std::byte> buffer_;
+    std::uint64_t offset_ = 0;
+    size_t rows_ = 0;
+};
+
+// Reads the row groups of a columnar archive, mapped from a file or on bytes which outlive it.
+template <class T>
+class columnar_archive {
+    using members = detail::columnar::members_t<T>;
+    static constexpr size_t columns = detail::columnar::columns_v<T>;
+public:
+    template <size_t I>
+    using member_t = std::tuple_element_t<I, members>;
+
+    template <size_t I>
+    using stat_value_t = detail::columnar::stat_value_t<member_t<I>>;
+
+    columnar_archive() = default;
+
+    // Checks the footer, the checksum and the metadata. Throws a 'serialization_error' if they are invalid.
+    columnar_archive(std::byte const* data, size_t size) { load(data, size); }
+
+    // Maps the file, throws a 'std::system_error' if it can't be.
+    static columnar_archive open(std::string const& path) {
+        columnar_archive archive;
+        archive.file_ = mapped_file{ path };
+        archive.load(archive.file_.data(), archive.file_.size());
+        return archive;
+    }
+
+    size_t row_groups() const noexcept { return groups_.size(); }
+    size_t rows(size_t group) const noexcept { return static_cast<size_t>(groups_[group].rows); }
+    size_t rows() const noexcept { return rows_; }
+
+    // The statistics of the member I in a row group, without reading it's chunk.
+    template <size_t I>
+    column_stats<stat_value_t<I>> stats(size_t group) const {
+        auto const& chunk = groups_[group].columns[I];
+        column_stats<stat_value_t<I>> stats;
+        stats.null_count = static_cast<size_t>(chunk.null_count);
+        stats.rows = rows(group);
+        if (!chunk.min.empty()) {
+            stats.min = decode<stat_value_t<I>>(chunk.min.data(), chunk.min.size());
+            stats.max = decode<stat_value_t<I>>(chunk.max.data(), chunk.max.size());
+        }
+        return stats;
+    }
+
+    // The values of the member I in a row group, only this chunk being decoded.
+    template <size_t I>
+    std::vector<member_t<I>> column(size_t group) const {
+        auto const& chunk = groups_[group].columns[I];
+        // The budget covers the values and the bytes they were decoded from (eg. strings).
+        limited_span span{ input_span<span_policy::error>{ data_ + chunk.offset, static_cast<size_t>(chunk.size) },
+            decode_limits{ rows(group) * sizeof(member_t<I>) + 2 * static_cast<size_t>(chunk.size) } };
+        detail::columnar::chunk_t<member_t<I>> values;
+        tom::deserialize(span, values);
+        if (span.failed() || span.size() != 0 || values.size() != rows(group)) {
+            throw serialization_error{ "tapeworm : invalid column chunk" };
+        }
+        return std::move(static_cast<std::vector<member_t<I>>&>(values));
+    }
+
+    // The rows of a row group.
+    std::vector<T> read(size_t group) const {
+        std::vector<T> rows(this->rows(group));
+        read_columns(rows, group, std::make_index_sequence<columns>{});
+        return rows;
+    }
+
+    // Calls 'f(row)' on the rows of the row groups for which 'keep(archive, group)' is true,
+    // the others are not decoded. Returns the number of row groups read.
+    template <class Predicate, class F>
+    size_t scan(Predicate&& keep, F&& f) const {
+        size_t read = 0;
+        for (size_t group = 0; group < groups_.size(); ++group) {
+            if (!keep(*this, group)) continue;
+            for (auto const& row : this->read(group)) f(row);
+            ++read;
+        }
+        return read;
+    }
+private:
+    template <class V>
+    static V decode(std::byte const* data, size_t size) {
+        input_span<span_policy::error> span{ data, size };
+        V value{};
+        tom::deserialize(span, value);
+        if (span.failed() || span.size() != 0) throw serialization_error{ "tapeworm : invalid column statistics" };
+        return value;
+    }
+
+    template <size_t...Is>
+    void read_columns(std::vector<T>& rows, size_t group, std::index_sequence<Is...>) const {
+        using tuple_concept = typename serial_concept_t<T>::tuple_concept;
+        auto const read_column = [&] (auto i) {
+            auto values = column<decltype(i)::value>(group);
+            for (size_t row = 0; row < rows.size(); ++row) {
+                std::get<decltype(i)::value>(tuple_concept::as_tuple(rows[row])) = std::move(values[row]);
+            }
+        };
+        (read_column(std::integral_constant<size_t, Is>{}), ...);
+    }
+
+    void load(std::byte const* data, size_t size) {
+        auto const invalid = [] { throw serialization_error{ "tapeworm : invalid archive" }; };
+        detail::columnar::footer footer;
+        if (size < sizeof(footer)) invalid();
+        std::memcpy(&footer, data + size - sizeof(footer), sizeof(footer));
+        if (footer.magic != detail::columnar::magic || footer.metadata_size > size - sizeof(footer)) invalid();
+        if (footer.fingerprint != fingerprint_v<T>) throw serialization_error{ "tapeworm : schema fingerprint mismatch" };
+
+        auto const data_size = size - sizeof(footer) - static_cast<size_t>(footer.metadata_size);
+        auto const metadata = data + data_size;
+        if (crc32c(0, metadata, static_cast<size_t>(footer.metadata_size)) != footer.checksum) invalid();
+        limited_span span{ input_span<span_policy::error>{ metadata, static_cast<size_t>(footer.metadata_size) },
+            decode_limits{ 16 * static_cast<size_t>(footer.metadata_size) } };
+        tom::deserialize(span, groups_);
+        if (span.failed() || span.size() != 0) invalid();
+
+        std::uint64_t offset = 0;
+        rows_ = 0;
+        for (auto const& group : groups_) {
+            if (group.columns.size() != columns || group.rows == 0) invalid();
+            for (auto const& chunk : group.columns) {
+                if (chunk.offset != offset || chunk.size > data_size - offset || chunk.null_count > group.rows) invalid();
+                offset += chunk.size;
+            }
+            rows_ += static_cast<size_t>(group.rows);
+        }
+        if (offset != data_size) invalid();
+        data_ = data;
+    }
+
+    mapped_file file_;
+    std::vector<detail::columnar::row_group> groups_;
+    std::byte const* data_ = nullptr;
+    size_t rows_ = 0;
+};
+
+// A predicate of 'scan' keeping the row groups where the member I may be in [low, high].
+template <size_t I, class V>
+auto column_between(V low, V high) {
+    return [low = std::move(low), high = std::move(high)] (auto const& archive, size_t group) {
+        using archive_type = std::remove_cv_t<std::remove_reference_t<decltype(archive)>>;
+        static_assert(detail::columnar::is_ordered_v<typename archive_type::template stat_value_t<I>>,
+            "The member has no min/max statistics");
+        auto const stats = archive.template stats<I>(group);
+        return stats.min && !(*stats.max < low) && !(high < *stats.min);
+    };
+}
+
+// A predicate of 'scan' keeping the row groups where the member I may be 'value'.
+template <size_t I, class V>
+auto column_equal(V value) {
+    return column_between<I>(value, value);
+}
+
+} // ::tom
@@ -0,0 +1,123 @@
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #include <nmmintrin.h>
+    #define TAPEWORM_CRC32C_HARDWARE __attribute__((target("sse4.2")))
+#elif defined(_M_X64)
+    #include <intrin.h>
+    #include <nmmintrin.h>
+    #define TAPEWORM_CRC32C_HARDWARE
+#endif
+
+/*
+    CRC32C (Castagnoli polynomial), computed with the SSE4.2 'crc32' instruction when
+    the CPU supports it, and with a slicing-by-8 table otherwise.
+
+    The checksum of a sequence can be updated chunk by chunk :
+    crc32c(crc32c(0, a, n), b, m) == crc32c of a followed by b.
+*/
+
+namespace tom {
+
+namespace detail::crc32c {
+
+    constexpr std::uint32_t polynomial = 0x82F63B78; // Reflected.
+
+    using table_type = std::array<std::array<std::uint32_t, 256>, 8>;
+
+    constexpr table_type make_tables() noexcept {
+        table_type tables{};
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            auto crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ ((crc & 1) ? polynomial : 0);
+            }
+            tables[0][i] = crc;
+        }
+        for (size_t t = 1; t < 8; ++t) {
+            for (size_t i = 0; i < 256; ++i) {
+                auto const prev = tables[t - 1][i];
+                tables[t][i] = (prev >> 8) ^ tables[0][prev & 0xFF];
+            }
+        }
+        return tables;
+    }
+
+    inline constexpr table_type tables = make_tables();
+
+    // Works on the inverted crc.
+    inline std::uint32_t software(std::uint32_t crc, std::uint8_t const* data, size_t size) noexcept {
+        for (; size >= 8; size -= 8, data += 8) {
+            std::uint32_t low, high;
+            std::memcpy(&low,  data,     4);
+            std::memcpy(&high, data + 4, 4);
+            low ^= crc;
+            crc = tables[7][low & 0xFF]  ^ tables[6][(low >> 8) & 0xFF] ^
+                  tables[5][(low >> 16) & 0xFF] ^ tables[4][low >> 24] ^
+                  tables[3][high & 0xFF] ^ tables[2][(high >> 8) & 0xFF] ^
+                  tables[1][(high >> 16) & 0xFF] ^ tables[0][high >> 24];
+        }
+        for (; size > 0; --size, ++data) {
+            crc = (crc >> 8) ^ tables[0][(crc ^ *data) & 0xFF];
+        }
+        return crc;
+    }
+
+#ifdef TAPEWORM_CRC32C_HARDWARE
+
+    TAPEWORM_CRC32C_HARDWARE
+    inline std::uint32_t hardware(std::uint32_t crc, std::uint8_t const* data, size_t size) noexcept {
+        std::uint64_t crc64 = crc;
+        for (; size >= 8; size -= 8, data += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, data, 8);
+            crc64 = _mm_crc32_u64(crc64, word);
+        }
+        crc = static_cast<std::uint32_t>(crc64);
+        for (; size > 0; --size, ++data) {
+            crc = _mm_crc32_u8(crc, *data);
+        }
+        return crc;
+    }
+
+    inline bool has_hardware() noexcept {
+    #ifdef _M_X64
+        static bool const supported = [] {
+            int info[4];
+            __cpuid(info, 1);
+            return (info[2] & (1 << 20)) != 0;
+        }();
+    #else
+        static bool const supported = __builtin_cpu_supports("sse4.2");
+    #endif
+        return supported;
+    }
+
+#else
+
+    constexpr bool has_hardware() noexcept { return false; }
+
+    inline std::uint32_t hardware(std::uint32_t crc, std::uint8_t const* data, size_t size) noexcept {
+        return software(crc, data, size);
+    }
+
+#endif
+
+} // ::detail::crc32c
+
+// Updates the CRC32C 'crc' (0 for an empty sequence) with 'size' bytes.
+inline std::uint32_t crc32c(std::uint32_t crc, void const* data, size_t size) noexcept {
+    namespace impl = detail::crc32c;
+    auto const bytes = static_cast<std::uint8_t const*>(data);
+    crc = ~crc;
+    crc = impl::has_hardware() ? impl::hardware(crc, bytes, size) : impl::software(crc, bytes, size);
+    return ~crc;
+}
+
+} // ::tom
@@ -0,0 +1,88 @@
+
+#pragma once
+
+#include "serialization.hpp"
+#include <limits>
+
+/*
+    Limits the resources used to decode untrusted input, without scanning it first.
+
+    tom::limited_span span{ tom::input_span<>{ data, size }, { 1 << 20, 1024, 8 } };
+    tom::deserialize(span, message);
+
+    The span fails as soon as a limit is exceeded :
+        - max_bytes  : the total memory allocated by containers and pointers, counted
+                       as the size of their values.
+        - max_length : the length of each container.
+        - max_depth  : the nesting of ranges, optionals and tuple-likes.
+*/
+
+namespace tom {
+
+// The default limit of nested ranges, optionals and tuple-likes.
+constexpr int default_max_depth = 64;
+
+struct decode_limits {
+    size_t      max_bytes  = std::numeric_limits<size_t>::max();
+    length_type max_length = std::numeric_limits<length_type>::max();
+    int         max_depth  = default_max_depth;
+};
+
+// An input span which enforces decoding limits.
+template <class Span>
+class limited_span : public Span {
+    static_assert(Span::is_input, "Only input spans can be limited");
+    static_assert(Span::policy != span_policy::unsafe, "Limits can't be enforced by unsafe spans");
+public:
+    using Span::Span;
+
+    limited_span(Span const& span, decode_limits const& limits) noexcept :
+        Span{ span }, limits_{ limits } {}
+
+    decode_limits const& limits() const noexcept { return limits_; }
+
+    // The number of bytes allocated so far.
+    size_t allocated() const noexcept { return allocated_; }
+
+    // Counts 'bytes' against the budget, fails the span if it is exceeded.
+    bool allocate(size_t bytes) {
+        if (bytes > limits_.max_bytes - allocated_) {
+            this->fail("tapeworm : allocation budget exceeded");
+            return false;
+        }
+        allocated_ += bytes;
+        return true;
+    }
+
+    // A span on 'size' bytes of this one (eg. a delimited payload) with it's limits, allocations and depth.
+    // The allocations made through it are counted back by 'join'.
+    limited_span sub_span(typename Span::byte_type* data, size_t size) const noexcept {
+        limited_span sub{ Span{ data, size }, limits_ };
+        sub.allocated_ = allocated_;
+        sub.depth_ = depth_;
+        return sub;
+    }
+    void join(limited_span const& sub) noexcept {
+        if (sub.allocated_ > allocated_) allocated_ = sub.allocated_;
+    }
+
+    // Called around the decoding of nested values.
+    bool enter() {
+        if (depth_ >= limits_.max_depth) {
+            this->fail("tapeworm : nesting limit exceeded");
+            return false;
+        }
+        ++depth_;
+        return true;
+    }
+    void leave() noexcept { --depth_; }
+private:
+    decode_limits limits_;
+    size_t allocated_ = 0;
+    int depth_ = 0;
+};
+
+template <class Span>
+limited_span(Span const&, decode_limits const&) -> limited_span<Span>;
+
+} // ::tom
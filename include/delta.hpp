@@ -0,0 +1,290 @@
+
+#pragma once
+
+#include "field_mask.hpp"
+#include "varint.hpp"
+
+/*
+    Delta encoding of a value against a previous snapshot of it.
+
+    Wire format, following the serial concept of each value :
+        - tuple_like : a presence bitmap of the changed members (see field_mask.hpp),
+          followed by the delta of each changed member.
+        - trivially_serializable : depends on 'numeric_delta'.
+        - trivial_array : the new length, a bitmap of the changed blocks among the
+          elements common to both arrays, the changed blocks, then the new elements.
+        - otherwise : the new value.
+    When the root is not tuple-like, it is preceded by a byte set to 1 if it changed.
+
+    The delta is applied on a value equal to the previous snapshot.
+*/
+
+namespace tom {
+
+// How the changed integers and floating points are encoded.
+enum class numeric_delta {
+    raw,      // The new value.
+    xor_bits, // A varint of the xor of the old and new bits.
+    subtract  // A zigzag varint of the difference for integers, 'xor_bits' for floating points.
+};
+
+namespace detail::delta {
+
+    // The number of bytes compared at once in trivial arrays.
+    constexpr size_t block_size = 64;
+
+    template <class T>
+    constexpr bool has_numeric_delta_v =
+        (std::is_arithmetic_v<T> || std::is_enum_v<T>) &&
+        !std::is_same_v<T, bool> && sizeof(T) <= 8;
+
+    template <class T>
+    std::uint64_t to_bits(T const& value) noexcept {
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(T));
+        return bits;
+    }
+    template <class T>
+    T from_bits(std::uint64_t bits) noexcept {
+        T value;
+        std::memcpy(&value, &bits, sizeof(T));
+        return value;
+    }
+
+    // Sign-extends the difference computed on the bits of T.
+    template <class T>
+    std::int64_t difference(std::uint64_t prev, std::uint64_t curr) noexcept {
+        constexpr unsigned shift = 64 - 8 * sizeof(T);
+        return static_cast<std::int64_t>((curr - prev) << shift) >> shift;
+    }
+
+    template <numeric_delta Encoding, class T>
+    constexpr numeric_delta encoding_of() noexcept {
+        if constexpr (!has_numeric_delta_v<T>) {
+            return numeric_delta::raw;
+        }
+        else if constexpr (Encoding == numeric_delta::subtract && std::is_floating_point_v<T>) {
+            return numeric_delta::xor_bits;
+        }
+        else return Encoding;
+    }
+
+    template <numeric_delta Encoding, class Span, class T>
+    void write_changed(Span& span, T const& prev, T const& curr);
+
+    template <numeric_delta Encoding, class Span, class T>
+    void apply_changed(Span& span, T& value);
+
+    template <class T>
+    using concept_of = serial_concept_t<T>;
+
+    // Numbers.
+
+    template <numeric_delta Encoding, class Span, class T>
+    void write_number(Span& span, T const& prev, T const& curr) {
+        constexpr auto encoding = encoding_of<Encoding, T>();
+        if constexpr (encoding == numeric_delta::raw) {
+            tom::serialize(span, curr);
+        }
+        else if constexpr (encoding == numeric_delta::xor_bits) {
+            write_varint(span, to_bits(prev) ^ to_bits(curr));
+        }
+        else write_varint(span, zigzag_encode(difference<T>(to_bits(prev), to_bits(curr))));
+    }
+
+    template <numeric_delta Encoding, class Span, class T>
+    void apply_number(Span& span, T& value) {
+        constexpr auto encoding = encoding_of<Encoding, T>();
+        if constexpr (encoding == numeric_delta::raw) {
+            tom::deserialize(span, value);
+        }
+        else {
+            std::uint64_t delta;
+            read_varint(span, delta);
+            if (span.failed()) return;
+            if constexpr (encoding == numeric_delta::xor_bits) {
+                value = from_bits<T>(to_bits(value) ^ delta);
+            }
+            else value = from_bits<T>(to_bits(value) + static_cast<std::uint64_t>(zigzag_decode(delta)));
+        }
+    }
+
+    // Tuple-likes.
+
+    template <numeric_delta Encoding, class Span, class T>
+    void write_members(Span& span, T const& prev, T const& curr) {
+        using tuple_concept = typename concept_of<T>::tuple_concept;
+        auto const prev_members = tuple_concept::as_tuple(prev);
+        auto const curr_members = tuple_concept::as_tuple(curr);
+
+        field_mask<T> changed;
+        tom::for_each_index<fields_count_v<T>>([&] (auto i) {
+            changed[i] = !tom::serialized_equal(std::get<i>(prev_members), std::get<i>(curr_members));
+        });
+        auto const bitmap = mask::make_bitmap(changed);
+        span.write(bitmap.data(), bitmap.size());
+
+        tom::for_each_index<fields_count_v<T>>([&] (auto i) {
+            if (changed[i]) write_changed<Encoding>(span, std::get<i>(prev_members), std::get<i>(curr_members));
+        });
+    }
+
+    template <numeric_delta Encoding, class Span, class T>
+    void apply_members(Span& span, T& value) {
+        using tuple_concept = typename concept_of<T>::tuple_concept;
+        constexpr auto count = fields_count_v<T>;
+
+        std::array<std::uint8_t, mask::bitmap_size<count>> bitmap{};
+        span.read(bitmap.data(), bitmap.size());
+        if (span.failed()) return;
+        if constexpr (count % 8 != 0) {
+            if (bitmap.back() >> (count % 8)) {
+                span.fail("tapeworm : invalid presence bitmap");
+                return;
+            }
+        }
+        auto members = tuple_concept::as_tuple(value);
+        tom::for_each_index<count>([&] (auto i) {
+            if ((bitmap[i / 8] >> (i % 8)) & 1) apply_changed<Encoding>(span, std::get<i>(members));
+        });
+    }
+
+    // Trivial arrays, compared by blocks of 'block_size' bytes.
+
+    template <class T>
+    constexpr size_t block_length = std::max(size_t{ 1 }, block_size / sizeof(typename concept_of<T>::value_type));
+
+    template <class Span, class T>
+    void write_blocks(Span& span, T const& prev, T const& curr) {
+        using value_type = typename concept_of<T>::value_type;
+        constexpr auto block_length = delta::block_length<T>;
+
+        auto const length = std::size(curr);
+        auto const common = std::min<size_t>(std::size(prev), length);
+        auto const blocks = (common + block_length - 1) / block_length;
+        auto const prev_data = std::data(prev);
+        auto const curr_data = std::data(curr);
+
+        span.write_value(static_cast<length_type>(length));
+
+        std::uint8_t byte = 0;
+        for (size_t block = 0; block < blocks; ++block) {
+            auto const first = block * block_length;
+            auto const size  = std::min(block_length, common - first) * sizeof(value_type);
+            if (std::memcmp(prev_data + first, curr_data + first, size) != 0) {
+                byte |= static_cast<std::uint8_t>(1 << (block % 8));
+            }
+            if (block % 8 == 7 || block + 1 == blocks) {
+                span.write_value(byte);
+                byte = 0;
+            }
+        }
+        for (size_t block = 0; block < blocks; ++block) {
+            auto const first = block * block_length;
+            auto const size  = std::min(block_length, common - first) * sizeof(value_type);
+            if (std::memcmp(prev_data + first, curr_data + first, size) != 0) {
+                span.write(curr_data + first, size);
+            }
+        }
+        span.write(curr_data + common, (length - common) * sizeof(value_type));
+    }
+
+    template <class Span, class T>
+    void apply_blocks(Span& span, T& value) {
+        using value_type = typename concept_of<T>::value_type;
+        constexpr auto block_length = delta::block_length<T>;
+
+        length_type length;
+        if (!serial::detail::read_length(span, length)) return;
+        auto const common = std::min<size_t>(std::size(value), length);
+        auto const blocks = (common + block_length - 1) / block_length;
+
+        // The bitmap and the new elements must be in the span before resizing.
+        auto const bitmap_bytes = (blocks + 7) / 8;
+        if (!span.check(bitmap_bytes + (length - common) * sizeof(value_type))) return;
+        auto const bitmap = span.advance(bitmap_bytes);
+
+        value.resize(length);
+        auto const data = std::data(value);
+        for (size_t block = 0; block < blocks; ++block) {
+            if ((static_cast<std::uint8_t>(bitmap[block / 8]) >> (block % 8)) & 1) {
+                auto const first = block * block_length;
+                auto const size  = std::min(block_length, common - first) * sizeof(value_type);
+                span.read(data + first, size);
+                if (span.failed()) return;
+            }
+        }
+        span.read(data + common, (length - common) * sizeof(value_type));
+    }
+
+    // Dispatch on the serial concept.
+
+    template <numeric_delta Encoding, class Span, class T>
+    void write_changed(Span& span, T const& prev, T const& curr) {
+        if constexpr (uses_concept_v<T, serial::concept::trivially_serializable>) {
+            write_number<Encoding>(span, prev, curr);
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::tuple_like>) {
+            write_members<Encoding>(span, prev, curr);
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::trivial_array>) {
+            write_blocks(span, prev, curr);
+        }
+        else tom::serialize(span, curr);
+    }
+
+    template <numeric_delta Encoding, class Span, class T>
+    void apply_changed(Span& span, T& value) {
+        if constexpr (uses_concept_v<T, serial::concept::trivially_serializable>) {
+            apply_number<Encoding>(span, value);
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::tuple_like>) {
+            apply_members<Encoding>(span, value);
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::trivial_array>) {
+            apply_blocks(span, value);
+        }
+        else tom::deserialize(span, value);
+    }
+
+} // ::detail::delta
+
+// Serializes the changes between two snapshots of a value.
+template <numeric_delta Encoding = numeric_delta::raw, class Span, class T>
+void serialize_delta(Span& span, T const& prev, T const& curr) {
+    if constexpr (uses_concept_v<T, serial::concept::tuple_like>) {
+        detail::delta::write_members<Encoding>(span, prev, curr);
+    }
+    else {
+        auto const changed = !tom::serialized_equal(prev, curr);
+        span.write_value(static_cast<std::uint8_t>(changed));
+        if (changed) detail::delta::write_changed<Encoding>(span, prev, curr);
+    }
+}
+
+// The number of bytes written by 'serialize_delta'.
+template <numeric_delta Encoding = numeric_delta::raw, class T>
+size_t serialized_delta_size(T const& prev, T const& curr) {
+    counting_span span;
+    tom::serialize_delta<Encoding>(span, prev, curr);
+    return span.count();
+}
+
+// Applies a delta on a value equal to the previous snapshot used to serialize it.
+template <numeric_delta Encoding = numeric_delta::raw, class Span, class T>
+void apply_delta(Span& span, T& value) {
+    if constexpr (uses_concept_v<T, serial::concept::tuple_like>) {
+        detail::delta::apply_members<Encoding>(span, value);
+    }
+    else {
+        std::uint8_t changed = 0;
+        span.read_value(changed);
+        if (span.failed()) return;
+        if (changed == 1) {
+            detail::delta::apply_changed<Encoding>(span, value);
+        }
+        else if (changed != 0) span.fail("tapeworm : invalid delta flag");
+    }
+}
+
+} // ::tom
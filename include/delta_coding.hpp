@@ -0,0 +1,87 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+/*
+    Kernels of the delta encoding of integer containers : the deltas (or deltas of deltas) of
+    the values, zigzag-encoded at the width of the values, and the prefix sums undoing them.
+    All the arithmetic wraps in the unsigned type of the values.
+*/
+
+namespace tom {
+
+namespace detail::delta_coding {
+
+    template <class U>
+    constexpr U zigzag_encode(U value) noexcept {
+        using S = std::make_signed_t<U>;
+        constexpr unsigned shift = 8 * sizeof(U) - 1;
+        return static_cast<U>(static_cast<U>(value << 1) ^ static_cast<U>(static_cast<S>(value) >> shift));
+    }
+    template <class U>
+    constexpr U zigzag_decode(U value) noexcept {
+        return static_cast<U>((value >> 1) ^ static_cast<U>(0u - (value & 1u)));
+    }
+
+    // The zigzag-encoded term 'i' (>= order) of the values.
+    template <int Order, class T, class U = std::make_unsigned_t<T>>
+    U term(T const* values, size_t i) noexcept {
+        auto const delta = [values] (size_t j) noexcept {
+            return static_cast<U>(static_cast<U>(values[j]) - static_cast<U>(values[j - 1]));
+        };
+        if constexpr (Order == 1) {
+            return zigzag_encode(delta(i));
+        }
+        else return zigzag_encode(static_cast<U>(delta(i) - delta(i - 1)));
+    }
+
+    // Replaces the values by their running sum starting from 'carry', returns the last sum.
+    template <class U>
+    U prefix_sum(U* values, size_t count, U carry) noexcept {
+        size_t i = 0;
+    #if defined(__SSE2__) || defined(_M_X64)
+        if constexpr (sizeof(U) == 4) {
+            auto sum = _mm_set1_epi32(static_cast<int>(carry));
+            for (; i + 4 <= count; i += 4) {
+                auto const ptr = reinterpret_cast<__m128i*>(values + i);
+                auto x = _mm_loadu_si128(ptr);
+                x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+                x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+                x = _mm_add_epi32(x, sum);
+                _mm_storeu_si128(ptr, x);
+                sum = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+            }
+            carry = static_cast<U>(_mm_cvtsi128_si32(sum));
+        }
+        else if constexpr (sizeof(U) == 8) {
+            auto sum = _mm_set1_epi64x(static_cast<long long>(carry));
+            for (; i + 2 <= count; i += 2) {
+                auto const ptr = reinterpret_cast<__m128i*>(values + i);
+                auto x = _mm_loadu_si128(ptr);
+                x = _mm_add_epi64(x, _mm_slli_si128(x, 8));
+                x = _mm_add_epi64(x, sum);
+                _mm_storeu_si128(ptr, x);
+                sum = _mm_unpackhi_epi64(x, x);
+            }
+            std::uint64_t last;
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(&last), sum);
+            carry = static_cast<U>(last);
+        }
+    #endif
+        for (; i < count; ++i) {
+            carry = static_cast<U>(carry + values[i]);
+            values[i] = carry;
+        }
+        return carry;
+    }
+
+} // ::detail::delta_coding
+
+} // ::tom
@@ -0,0 +1,107 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+/*
+    Kernels of the dictionary encoding of strings : the distinct strings are gathered
+    in a dictionary, in order of first appearance, and each string is replaced by it's index.
+    The indices take 1, 2 or 4 bytes depending on the size of the dictionary.
+*/
+
+namespace tom {
+
+namespace detail::dictionary {
+
+    // The number of bytes of the indices in a dictionary of 'entries' strings.
+    constexpr size_t index_size(size_t entries) noexcept {
+        return entries <= 0x100 ? 1 : entries <= 0x10000 ? 2 : 4;
+    }
+
+    inline std::uint64_t mix(std::uint64_t hash) noexcept {
+        hash ^= hash >> 32;
+        hash *= 0xD6E8FEB86659FD93ull;
+        return hash ^ hash >> 32;
+    }
+
+    // Hashes by words of 8 bytes.
+    inline std::uint64_t hash(std::string_view string) noexcept {
+        constexpr std::uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+        auto ptr = string.data();
+        auto size = string.size();
+        std::uint64_t hash = size * multiplier;
+        for (; size >= 8; ptr += 8, size -= 8) {
+            std::uint64_t word;
+            std::memcpy(&word, ptr, 8);
+            hash = (hash ^ word) * multiplier;
+            hash ^= hash >> 29;
+        }
+        if (size != 0) {
+            std::uint64_t word = 0;
+            std::memcpy(&word, ptr, size);
+            hash = (hash ^ word) * multiplier;
+        }
+        return mix(hash);
+    }
+
+    // Gives each distinct string an index, with an open addressing hash table.
+    // The strings are not copied and must outlive the table.
+    class string_table {
+    public:
+        string_table() = default;
+        explicit string_table(size_t capacity) { reserve(capacity); }
+
+        // Returns the index of the string, inserted if it is new.
+        std::uint32_t insert(std::string_view string) {
+            if (2 * (entries_.size() + 1) > slots_.size()) grow();
+            auto const hash = dictionary::hash(string);
+            auto const mask = slots_.size() - 1;
+            for (auto i = static_cast<size_t>(hash) & mask;; i = (i + 1) & mask) {
+                auto& slot = slots_[i];
+                if (slot.index == empty) {
+                    slot.hash = hash;
+                    slot.index = static_cast<std::uint32_t>(entries_.size());
+                    entries_.push_back(string);
+                    return slot.index;
+                }
+                if (slot.hash == hash && entries_[slot.index] == string) return slot.index;
+            }
+        }
+
+        // The distinct strings, by index.
+        std::vector<std::string_view> const& entries() const noexcept { return entries_; }
+    private:
+        static constexpr std::uint32_t empty = ~std::uint32_t{ 0 };
+
+        struct slot {
+            std::uint64_t hash;
+            std::uint32_t index = empty;
+        };
+
+        void reserve(size_t capacity) {
+            size_t size = 16;
+            while (size < 2 * capacity) size *= 2;
+            std::vector<slot> slots(size);
+            auto const mask = size - 1;
+            for (auto const& old : slots_) {
+                if (old.index == empty) continue;
+                auto i = static_cast<size_t>(old.hash) & mask;
+                while (slots[i].index != empty) i = (i + 1) & mask;
+                slots[i] = old;
+            }
+            slots_ = std::move(slots);
+            entries_.reserve(capacity);
+        }
+        void grow() { reserve(slots_.empty() ? 8 : slots_.size()); }
+
+        std::vector<slot> slots_;
+        std::vector<std::string_view> entries_;
+    };
+
+} // ::detail::dictionary
+
+} // ::tom
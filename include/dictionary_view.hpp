@@ -0,0 +1,109 @@
+
+#pragma once
+
+#include "serialization.hpp"
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace tom {
+
+// A read-only view on a range serialized with the dictionary encoding.
+// The strings are interned : they are views on the distinct strings of the serialized bytes,
+// which must outlive the view. Nothing is copied.
+template <class Range>
+class dictionary_view {
+    using concept_type = serial_concept_t<Range>;
+    static_assert(std::is_same_v<concept_type, serial::concept::dictionary_encoding<Range>>,
+        "dictionary_view only applies to types serialized with the dictionary encoding.");
+    static_assert(!concept_type::is_records, "dictionary_view only applies to ranges of strings.");
+public:
+    using value_type = std::string_view;
+    using size_type  = size_t;
+
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = std::string_view;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = std::string_view;
+        using pointer           = void;
+
+        constexpr iterator() noexcept = default;
+
+        std::string_view operator*() const { return (*view_)[i_]; }
+
+        constexpr iterator& operator++() noexcept { ++i_; return *this; }
+        constexpr iterator operator++(int) noexcept { auto it = *this; ++*this; return it; }
+
+        constexpr friend bool operator==(iterator lhs, iterator rhs) noexcept { return lhs.i_ == rhs.i_; }
+        constexpr friend bool operator!=(iterator lhs, iterator rhs) noexcept { return lhs.i_ != rhs.i_; }
+    private:
+        friend class dictionary_view;
+        constexpr iterator(dictionary_view const* view, size_t i) noexcept : view_{ view }, i_{ i } {}
+
+        dictionary_view const* view_ = nullptr;
+        size_t i_ = 0;
+    };
+
+    dictionary_view() = default;
+
+    // Reads the dictionary and checks all the indices, then moves the span past the range.
+    // The view is empty if the checks fail.
+    template <class Span>
+    explicit dictionary_view(Span& span) {
+        static_assert(Span::is_input, "dictionary_view reads from an input span");
+        length_type length;
+        if (!concept_type::read_dictionary(span, length, entries_)) {
+            entries_.clear();
+            return;
+        }
+        index_size_ = detail::dictionary::index_size(entries_.size());
+        indices_ = span.advance(length * index_size_);
+        for (size_t i = 0; i < length; ++i) {
+            if (index_at(indices_, i) >= entries_.size()) {
+                span.fail("tapeworm : invalid dictionary index");
+                entries_.clear();
+                return;
+            }
+        }
+        size_ = length;
+    }
+
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    // The distinct strings, in order of first appearance.
+    std::vector<std::string_view> const& dictionary() const noexcept { return entries_; }
+
+    // The index of the string 'i' in the dictionary.
+    size_t index(size_type i) const noexcept { return index_at(indices_, i); }
+
+    std::string_view operator[](size_type i) const noexcept {
+        return entries_[index(i)];
+    }
+    std::string_view at(size_type i) const {
+        if (i >= size_) throw std::out_of_range{ "tapeworm : dictionary_view index out of range" };
+        return (*this)[i];
+    }
+
+    iterator begin() const noexcept { return { this, 0 }; }
+    iterator end()   const noexcept { return { this, size_ }; }
+private:
+    size_t index_at(std::byte const* indices, size_t i) const noexcept {
+        auto const ptr = indices + i * index_size_;
+        switch (index_size_) {
+            case 1:  return static_cast<std::uint8_t>(*ptr);
+            case 2:  { std::uint16_t index; std::memcpy(&index, ptr, 2); return index; }
+            default: { std::uint32_t index; std::memcpy(&index, ptr, 4); return index; }
+        }
+    }
+
+    std::vector<std::string_view> entries_;
+    std::byte const* indices_ = nullptr;
+    size_t index_size_ = 1;
+    size_type size_ = 0;
+};
+
+} // ::tom
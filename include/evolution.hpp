@@ -0,0 +1,295 @@
+
+#pragma once
+
+#include "fingerprint.hpp"
+#include "field_mask.hpp"
+#include "varint.hpp"
+
+/*
+    Opt-in evolvable encoding, allowing to add, remove or reorder the members of tuple-likes.
+
+    Message : the writer fingerprint (8 bytes), a mode byte, then the value.
+        - mode 0 (positional) : the usual encoding, only readable with the same fingerprint.
+        - mode 1 (tagged)     : the evolvable encoding below.
+
+    Evolvable encoding, following the serial concept of each value :
+        - tuple_like : the members as tagged fields, up to the end of the enclosing length.
+        - optional   : a byte (0 or 1) followed by the value if any, delimited.
+        - range      : a 'length_type' followed by the elements, delimited.
+        - otherwise  : the usual encoding.
+    A delimited value is preceded by it's size as a 'length_type'.
+
+    Tagged field : a varint (tag << 3 | wire type) followed by :
+        - wire types 0 to 3 : a number of 1, 2, 4 or 8 bytes.
+        - wire type 4       : a delimited value.
+
+    Readers skip unknown fields, and fields whose wire type changed, in O(1).
+    Missing fields are default constructed.
+*/
+
+namespace tom {
+
+// Specialize to give stable tags to the members of T, by default the tag of a member is it's index + 1.
+//
+// template <>
+// struct tom::field_tags<my_type> {
+//     static constexpr std::uint32_t value[] = { 1, 2, 7 };
+// };
+template <class T>
+struct field_tags {};
+
+enum class wire_type : std::uint8_t {
+    fixed_1, fixed_2, fixed_4, fixed_8, delimited
+};
+
+namespace detail::evolution {
+
+    enum class mode : std::uint8_t { positional, tagged };
+
+    template <class T>
+    using tags_t = decltype(field_tags<T>::value);
+
+    template <class T>
+    constexpr bool valid_tags() noexcept {
+        constexpr auto count = fields_count_v<T>;
+        constexpr auto& tags = field_tags<T>::value;
+        static_assert(std::size(tags) == count, "field_tags must give a tag to each member");
+        for (size_t i = 0; i < count; ++i) {
+            if (tags[i] == 0 || tags[i] >= (1u << 28)) return false;
+            for (size_t j = 0; j < i; ++j) {
+                if (tags[i] == tags[j]) return false;
+            }
+        }
+        return true;
+    }
+
+    template <class T, size_t I>
+    constexpr std::uint32_t tag_of() noexcept {
+        if constexpr (is_detected_v<tags_t, T>) {
+            static_assert(valid_tags<T>(), "field_tags must be unique, non-zero and lower than 2^28");
+            return field_tags<T>::value[I];
+        }
+        else return static_cast<std::uint32_t>(I + 1);
+    }
+
+    template <class T>
+    constexpr wire_type wire_of() noexcept {
+        if constexpr (uses_concept_v<T, serial::concept::trivially_serializable>) {
+            switch (sizeof(T)) {
+                case 1: return wire_type::fixed_1;
+                case 2: return wire_type::fixed_2;
+                case 4: return wire_type::fixed_4;
+                case 8: return wire_type::fixed_8;
+            }
+        }
+        return wire_type::delimited;
+    }
+
+    constexpr size_t fixed_size(wire_type wire) noexcept {
+        return size_t{ 1 } << static_cast<unsigned>(wire);
+    }
+
+    template <class Span, class T>
+    void write_body(Span& span, T const& value);
+
+    template <class Span, class T>
+    void read_body(Span& span, T& value);
+
+    // Writes the length of the body, then the body. Bodies too large for a 'length_type' fail the span.
+    template <class Span, class F>
+    void write_delimited(Span& span, F&& write) {
+        serial::detail::write_sized(span, std::forward<F>(write));
+    }
+
+    // Calls 'read' with a span restricted to the delimited body, then moves past it.
+    template <class Span, class F>
+    void read_delimited(Span& span, F&& read) {
+        length_type length;
+        if (!serial::detail::read_length(span, length)) return;
+        if (!span.check(length)) return;
+        auto body = serial::detail::sub_span(span, span.begin(), length);
+        read(body);
+        if (body.failed()) span.fail("tapeworm : invalid delimited value");
+        else serial::detail::join_sub_span(span, body);
+        span.advance(length);
+    }
+
+    template <class Span, class T>
+    void write_members(Span& span, T const& value) {
+        using tuple_concept = typename serial_concept_t<T>::tuple_concept;
+        auto const members = tuple_concept::as_tuple(value);
+        tom::for_each_index<fields_count_v<T>>([&] (auto i) {
+            auto const& member = std::get<i>(members);
+            using member_type = remove_cvref_t<decltype(member)>;
+            constexpr auto wire = wire_of<member_type>();
+
+            write_varint(span, std::uint64_t{ tag_of<T, i>() } << 3 | static_cast<std::uint8_t>(wire));
+            if constexpr (wire == wire_type::delimited) {
+                write_delimited(span, [&] { write_body(span, member); });
+            }
+            else tom::serialize(span, member);
+        });
+    }
+
+    // Reads the tagged fields until the end of the span.
+    template <class Span, class T>
+    void read_members(Span& span, T& value) {
+        using tuple_concept = typename serial_concept_t<T>::tuple_concept;
+        value = T{};
+        auto members = tuple_concept::as_tuple(value);
+        while (span.size() > 0 && !span.failed()) {
+            std::uint64_t key;
+            read_varint(span, key);
+            if (span.failed()) return;
+            auto const tag  = key >> 3;
+            auto const wire = static_cast<wire_type>(key & 7);
+            if (wire > wire_type::delimited) {
+                span.fail("tapeworm : invalid wire type");
+                return;
+            }
+            bool found = false;
+            tom::for_each_index<fields_count_v<T>>([&] (auto i) {
+                auto& member = std::get<i>(members);
+                using member_type = remove_cvref_t<decltype(member)>;
+                constexpr auto expected = wire_of<member_type>();
+
+                if (found || tag != tag_of<T, i>() || wire != expected) return;
+                found = true;
+                if constexpr (expected == wire_type::delimited) {
+                    read_delimited(span, [&] (Span& body) { read_body(body, member); });
+                }
+                else tom::deserialize(span, member);
+            });
+            if (found) continue;
+
+            // Unknown field.
+            if (wire == wire_type::delimited) {
+                length_type length;
+                if (!serial::detail::read_length(span, length)) return;
+                serial::detail::skip_bytes(span, length);
+            }
+            else serial::detail::skip_bytes(span, fixed_size(wire));
+        }
+    }
+
+    template <class Span, class T>
+    void write_body(Span& span, T const& value) {
+        if constexpr (uses_concept_v<T, serial::concept::tuple_like>) {
+            write_members(span, value);
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::optional>) {
+            span.write_value(static_cast<std::uint8_t>(value ? 1 : 0));
+            if (value) write_delimited(span, [&] { write_body(span, *value); });
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::range>) {
+            auto const length = static_cast<length_type>(std::distance(std::begin(value), std::end(value)));
+            span.write_value(length);
+            for (auto const& element : value) {
+                write_delimited(span, [&] { write_body(span, element); });
+            }
+        }
+        else tom::serialize(span, value);
+    }
+
+    template <class Span, class T>
+    void read_body(Span& span, T& value) {
+        if constexpr (uses_concept_v<T, serial::concept::tuple_like>) {
+            read_members(span, value);
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::optional>) {
+            std::uint8_t flag = 0;
+            span.read_value(flag);
+            if (span.failed()) return;
+            if (flag == 0) {
+                value = T{};
+            }
+            else if (flag == 1) {
+                auto& inner = serial::detail::emplace_value(value);
+                read_delimited(span, [&] (Span& body) { read_body(body, inner); });
+            }
+            else span.fail("tapeworm : invalid optional flag");
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::range>) {
+            using value_type = typename serial_concept_t<T>::value_type;
+            length_type length;
+            if (!serial::detail::read_length(span, length)) return;
+            // Each element takes at least it's delimiter.
+            if (!span.check(size_t{ length } * sizeof(length_type))) return;
+            if (!serial::detail::allocate<value_type>(span, length)) return;
+            value.clear();
+            for (length_type i = 0; i < length && !span.failed(); ++i) {
+                value_type element{};
+                read_delimited(span, [&] (Span& body) { read_body(body, element); });
+                value.insert(std::end(value), std::move(element));
+            }
+        }
+        else tom::deserialize(span, value);
+    }
+
+    template <class Span, class T>
+    void write_message(Span& span, T const& value, mode message_mode) {
+        tom::write_fingerprint<T>(span);
+        span.write_value(message_mode);
+        if (message_mode == mode::positional) {
+            tom::serialize(span, value);
+        }
+        else write_delimited(span, [&] { write_body(span, value); });
+    }
+
+} // ::detail::evolution
+
+// Serializes a value with the tagged encoding, readable by any version of T.
+template <class Span, class T>
+void serialize_evolvable(Span& span, T const& value) {
+    detail::evolution::write_message(span, value, detail::evolution::mode::tagged);
+}
+
+// Serializes a value for a reader whose fingerprint of T is known.
+// If it is the same as the writer one, the positional encoding is used.
+template <class Span, class T>
+void serialize_evolvable(Span& span, T const& value, std::uint64_t reader_fingerprint) {
+    using detail::evolution::mode;
+    detail::evolution::write_message(span, value,
+        reader_fingerprint == fingerprint_v<T> ? mode::positional : mode::tagged);
+}
+
+// The number of bytes written by 'serialize_evolvable'.
+template <class T>
+size_t evolvable_size(T const& value) {
+    counting_span span;
+    tom::serialize_evolvable(span, value);
+    return span.count();
+}
+template <class T>
+size_t evolvable_size(T const& value, std::uint64_t reader_fingerprint) {
+    counting_span span;
+    tom::serialize_evolvable(span, value, reader_fingerprint);
+    return span.count();
+}
+
+// Deserializes a value written by 'serialize_evolvable' with any version of T.
+// The span fails if the message is positional and written with another version of T.
+template <class Span, class T>
+void deserialize_evolvable(Span& span, T& value) {
+    using detail::evolution::mode;
+    std::uint64_t fingerprint = 0;
+    auto message_mode = mode::tagged;
+    span.read_value(fingerprint);
+    span.read_value(message_mode);
+    if (span.failed()) return;
+
+    if (message_mode == mode::positional) {
+        if (fingerprint == fingerprint_v<T>) {
+            tom::deserialize(span, value);
+        }
+        else span.fail("tapeworm : positional message written with another schema");
+    }
+    else if (message_mode == mode::tagged) {
+        detail::evolution::read_delimited(span, [&] (Span& body) {
+            detail::evolution::read_body(body, value);
+        });
+    }
+    else span.fail("tapeworm : invalid message mode");
+}
+
+} // ::tom
@@ -0,0 +1,512 @@
+
+#pragma once
+
+#include "framing.hpp"
+#include "key_encoding.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+/*
+    External merge sort of files of framed records (see framing.hpp) larger than the memory,
+    ordered by a key of each record encoded with 'serialize_key' (see key_encoding.hpp).
+
+    Each record is deserialized once to compute it's key, then only it's bytes are moved : the records
+    are read in runs of 'memory_budget' bytes, sorted on their keys with memcmp and spilled to temporary
+    files, which are merged with a loser tree (one comparison of keys per level of the tree for each record).
+    When there are more than 'max_fan_in' runs, groups of runs are first merged into longer runs.
+    The sort is stable : the records with equal keys keep the order of the input.
+
+    Run entry : the key size as a 'length_type', the key, the framed record.
+
+    The files are read and written through two buffers each : one is filled or drained by an I/O thread
+    while the sort works on the other one.
+
+    'sort_records<T>' decodes the records as T, 'sort_frames' leaves the payloads to the key function
+    (eg. the 'tapeworm_sort' tool, which decodes the leading members of the records).
+
+    tom::sort_file<event>("events.bin", "sorted.bin", [] (event const& e) { return std::tuple{ e.user, e.timestamp }; });
+*/
+
+namespace tom {
+
+struct sort_options {
+    size_t memory_budget = size_t{ 64 } << 20;  // The bytes of records and keys sorted in memory at once.
+    size_t buffer_size = size_t{ 1 } << 20;     // The size of each I/O buffer, two per file.
+    size_t max_fan_in = 64;                     // The maximum number of runs merged at once.
+    bool io_thread = true;                      // If false, the reads and writes block the sort.
+    std::string temp_directory;                 // The directory of the runs, the system one if empty.
+};
+
+namespace detail::external_sort {
+
+    // Runs the reads and writes on a thread of their own, or inline.
+    class io_queue {
+    public:
+        explicit io_queue(bool threaded) {
+            if (threaded) thread_ = std::make_unique<thread_pool>(1);
+        }
+
+        // The exceptions of 'f' are thrown by the future.
+        template <class F>
+        std::future<void> submit(F&& f) {
+            auto task = std::make_shared<std::packaged_task<void()>>(std::forward<F>(f));
+            auto future = task->get_future();
+            if (thread_) thread_->submit([task] { (*task)(); });
+            else (*task)();
+            return future;
+        }
+    private:
+        std::unique_ptr<thread_pool> thread_;
+    };
+
+    // Reads a stream through two buffers, one being filled by the I/O thread while the other is read.
+    // The buffers are swapped : the unread bytes of the current one (a partial record) are copied in
+    // the headroom left before the next one, which grows to the largest partial record.
+    class buffered_reader {
+    public:
+        buffered_reader(std::istream& in, io_queue& io, size_t buffer_size) :
+            in_{ in }, io_{ io }, buffer_size_{ buffer_size } {
+            fetch();
+        }
+        ~buffered_reader() {
+            if (pending_.valid()) pending_.wait();
+        }
+        buffered_reader(buffered_reader const&) = delete;
+        buffered_reader& operator=(buffered_reader const&) = delete;
+
+        // The next 'size' bytes, null if the stream ends before.
+        // The bytes are valid until the next call.
+        std::byte const* peek(size_t size) {
+            while (buffer_.size() - position_ < size) {
+                if (!refill()) return nullptr;
+            }
+            return buffer_.data() + position_;
+        }
+        void consume(size_t size) noexcept { position_ += size; }
+
+        bool empty() { return peek(1) == nullptr; }
+    private:
+        void fetch() {
+            auto const offset = headroom_;
+            pending_ = io_.submit([this, offset] {
+                next_.resize(offset + buffer_size_);
+                in_.read(reinterpret_cast<char*>(next_.data() + offset), static_cast<std::streamsize>(buffer_size_));
+                next_.resize(offset + static_cast<size_t>(in_.gcount()));
+            });
+            next_offset_ = offset;
+        }
+
+        // Moves to the next buffer, after the unread bytes. Returns false at the end of the stream.
+        bool refill() {
+            if (!pending_.valid()) return false;
+            pending_.get();
+            if (in_.bad()) throw serialization_error{ "tapeworm : can't read the records" };
+            if (next_.size() == next_offset_) return false;
+
+            auto const unread = buffer_.size() - position_;
+            if (unread <= next_offset_) {
+                position_ = next_offset_ - unread;
+                std::copy(buffer_.end() - static_cast<std::ptrdiff_t>(unread), buffer_.end(), next_.begin() + static_cast<std::ptrdiff_t>(position_));
+                std::swap(buffer_, next_);
+            }
+            else {
+                // A record larger than the headroom : the buffers are joined.
+                buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(position_));
+                buffer_.insert(buffer_.end(), next_.begin() + static_cast<std::ptrdiff_t>(next_offset_), next_.end());
+                position_ = 0;
+                headroom_ = unread;
+            }
+            fetch();
+            return true;
+        }
+
+        std::istream& in_;
+        io_queue& io_;
+        size_t buffer_size_;
+        std::vector<std::byte> buffer_, next_;
+        size_t position_ = 0;
+        size_t headroom_ = 4096;
+        size_t next_offset_ = 0;
+        std::future<void> pending_;
+    };
+
+    // Writes a stream through two buffers, one being written by the I/O thread while the other is filled.
+    class buffered_writer {
+    public:
+        buffered_writer(std::ostream& out, io_queue& io, size_t buffer_size) :
+            out_{ out }, io_{ io }, buffer_size_{ buffer_size } {
+            buffer_.reserve(buffer_size);
+        }
+        ~buffered_writer() {
+            if (pending_.valid()) pending_.wait();
+        }
+        buffered_writer(buffered_writer const&) = delete;
+        buffered_writer& operator=(buffered_writer const&) = delete;
+
+        void write(void const* data, size_t size) {
+            auto const bytes = static_cast<std::byte const*>(data);
+            buffer_.insert(buffer_.end(), bytes, bytes + size);
+            if (buffer_.size() >= buffer_size_) flush();
+        }
+
+        // Writes the buffered bytes, throws a 'serialization_error' if the stream fails.
+        void finish() {
+            flush();
+            wait();
+            out_.flush();
+            if (!out_) throw serialization_error{ "tapeworm : can't write the sorted records" };
+        }
+    private:
+        void wait() {
+            if (pending_.valid()) pending_.get();
+        }
+
+        void flush() {
+            wait();
+            if (buffer_.empty()) return;
+            std::swap(buffer_, writing_);
+            buffer_.clear();
+            pending_ = io_.submit([this] {
+                out_.write(reinterpret_cast<char const*>(writing_.data()), static_cast<std::streamsize>(writing_.size()));
+            });
+        }
+
+        std::ostream& out_;
+        io_queue& io_;
+        size_t buffer_size_;
+        std::vector<std::byte> buffer_, writing_;
+        std::future<void> pending_;
+    };
+
+    inline bool key_less(std::byte const* lhs, size_t lhs_size, std::byte const* rhs, size_t rhs_size) noexcept {
+        auto const order = std::memcmp(lhs, rhs, std::min(lhs_size, rhs_size));
+        return order < 0 || (order == 0 && lhs_size < rhs_size);
+    }
+
+    // The records of a run, sorted in memory.
+    class run_buffer {
+    public:
+        // Appends a record and it's key, appended to the bytes of the run by 'append_key(bytes)'.
+        template <class AppendKey>
+        void add(AppendKey&& append_key, std::byte const* record, size_t record_size) {
+            entry e{ 0, bytes_.size(), 0, 0, record_size };
+            append_key(bytes_);
+            e.key_size = bytes_.size() - e.key;
+            e.record = bytes_.size();
+            bytes_.insert(bytes_.end(), record, record + record_size);
+            for (size_t i = 0; i < sizeof(e.prefix); ++i) {
+                e.prefix = e.prefix << 8 | (i < e.key_size ? std::to_integer<std::uint64_t>(bytes_[e.key + i]) : 0);
+            }
+            entries_.push_back(e);
+        }
+
+        size_t memory() const noexcept { return bytes_.size() + entries_.size() * sizeof(entry); }
+        bool empty() const noexcept { return entries_.empty(); }
+
+        // Sorts the records on their keys, then writes them with their keys if 'keys'.
+        void write(buffered_writer& out, bool keys) {
+            std::stable_sort(entries_.begin(), entries_.end(), [this] (entry const& lhs, entry const& rhs) {
+                if (lhs.prefix != rhs.prefix) return lhs.prefix < rhs.prefix;
+                return key_less(bytes_.data() + lhs.key, lhs.key_size, bytes_.data() + rhs.key, rhs.key_size);
+            });
+            for (auto const& e : entries_) {
+                if (keys) {
+                    auto const key_size = static_cast<length_type>(e.key_size);
+                    out.write(&key_size, sizeof(key_size));
+                    out.write(bytes_.data() + e.key, e.key_size);
+                }
+                out.write(bytes_.data() + e.record, e.record_size);
+            }
+        }
+
+        void clear() noexcept {
+            bytes_.clear();
+            entries_.clear();
+        }
+    private:
+        struct entry {
+            std::uint64_t prefix; // The first 8 bytes of the key, big-endian : most comparisons stop there.
+            size_t key, key_size, record, record_size;
+        };
+
+        std::vector<std::byte> bytes_;
+        std::vector<entry> entries_;
+    };
+
+    inline std::ofstream create_file(std::string const& path) {
+        std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+        if (!file) throw std::system_error{ errno, std::generic_category(), "tapeworm : can't create " + path };
+        return file;
+    }
+
+    inline std::ifstream open_file(std::string const& path) {
+        std::ifstream file{ path, std::ios::binary };
+        if (!file) throw std::system_error{ errno, std::generic_category(), "tapeworm : can't open " + path };
+        return file;
+    }
+
+    // The entries of a run file, read one after another.
+    class run_reader {
+    public:
+        run_reader(std::string const& path, io_queue& io, size_t buffer_size) :
+            file_{ open_file(path) }, reader_{ file_, io, buffer_size } {}
+
+        // Moves to the next entry, returns false at the end of the run.
+        bool next() {
+            reader_.consume(size_);
+            size_ = 0;
+            if (reader_.empty()) {
+                done_ = true;
+                return false;
+            }
+            auto data = reader_.peek(sizeof(length_type));
+            if (!data) invalid();
+            length_type key_size;
+            std::memcpy(&key_size, data, sizeof(key_size));
+            auto const record = sizeof(length_type) + size_t{ key_size };
+
+            data = reader_.peek(record + frame_header_size);
+            if (!data) invalid();
+            length_type payload_size;
+            std::memcpy(&payload_size, data + record, sizeof(payload_size));
+            size_ = record + frame_header_size + payload_size;
+
+            data = reader_.peek(size_);
+            if (!data) invalid();
+            key_ = data + sizeof(length_type);
+            key_size_ = key_size;
+            record_ = data + record;
+            return true;
+        }
+
+        bool done() const noexcept { return done_; }
+
+        std::byte const* key() const noexcept { return key_; }
+        size_t key_size() const noexcept { return key_size_; }
+
+        // The entry, without it's key if '!keys'.
+        std::byte const* entry(bool keys) const noexcept { return keys ? key_ - sizeof(length_type) : record_; }
+        size_t entry_size(bool keys) const noexcept { return keys ? size_ : size_ - sizeof(length_type) - key_size_; }
+    private:
+        [[noreturn]] static void invalid() {
+            throw serialization_error{ "tapeworm : invalid sort run" };
+        }
+
+        std::ifstream file_;
+        buffered_reader reader_;
+        std::byte const* key_ = nullptr;
+        std::byte const* record_ = nullptr;
+        size_t key_size_ = 0;
+        size_t size_ = 0;
+        bool done_ = false;
+    };
+
+    // A tournament tree of 'count' sources keeping the loser of each match, whose root is the smallest
+    // source : once it has moved to it's next value, only the matches on it's path are replayed.
+    template <class Less>
+    class loser_tree {
+    public:
+        loser_tree(size_t count, Less less) :
+            less_{ std::move(less) }, nodes_(count), count_{ count } {
+            if (count != 0) nodes_[0] = build(1);
+        }
+
+        // The smallest source.
+        size_t top() const noexcept { return nodes_[0]; }
+
+        void replay() {
+            auto winner = nodes_[0];
+            for (auto node = (winner + count_) / 2; node != 0; node /= 2) {
+                if (less_(nodes_[node], winner)) std::swap(nodes_[node], winner);
+            }
+            nodes_[0] = winner;
+        }
+    private:
+        // The winner of the subtree of 'node', the leaves being the nodes 'count' to '2 * count - 1'.
+        size_t build(size_t node) {
+            if (node >= count_) return node - count_;
+            auto const left = build(2 * node), right = build(2 * node + 1);
+            auto const left_wins = !less_(right, left);
+            nodes_[node] = left_wins ? right : left;
+            return left_wins ? left : right;
+        }
+
+        Less less_;
+        std::vector<size_t> nodes_;
+        size_t count_;
+    };
+
+    // Temporary run files, removed with the sort.
+    class temp_files {
+    public:
+        explicit temp_files(std::string const& directory) :
+            directory_{ directory.empty() ? std::filesystem::temp_directory_path() : std::filesystem::path{ directory } },
+            prefix_{ "tapeworm_sort_" + std::to_string(std::random_device{}()) + "_" } {}
+        ~temp_files() {
+            for (auto const& path : paths_) remove(path);
+        }
+        temp_files(temp_files const&) = delete;
+        temp_files& operator=(temp_files const&) = delete;
+
+        std::string create() {
+            paths_.push_back((directory_ / (prefix_ + std::to_string(paths_.size()) + ".run")).string());
+            return paths_.back();
+        }
+
+        static void remove(std::string const& path) noexcept {
+            std::error_code error;
+            std::filesystem::remove(path, error);
+        }
+    private:
+        std::filesystem::path directory_;
+        std::string prefix_;
+        std::vector<std::string> paths_;
+    };
+
+    // Merges the runs in order of their keys, the runs coming first on equal keys.
+    // The entries are written with their keys if 'keys'.
+    inline void merge(std::vector<std::string> const& runs, buffered_writer& out, bool keys, io_queue& io, size_t buffer_size) {
+        std::vector<std::unique_ptr<run_reader>> readers;
+        readers.reserve(runs.size());
+        for (auto const& path : runs) {
+            readers.push_back(std::make_unique<run_reader>(path, io, buffer_size));
+            readers.back()->next();
+        }
+        auto const less = [&readers] (size_t lhs, size_t rhs) {
+            auto const& l = *readers[lhs];
+            auto const& r = *readers[rhs];
+            if (l.done() || r.done()) return !l.done() || (r.done() && lhs < rhs);
+            if (key_less(l.key(), l.key_size(), r.key(), r.key_size())) return true;
+            return !key_less(r.key(), r.key_size(), l.key(), l.key_size()) && lhs < rhs;
+        };
+        loser_tree<decltype(less)> tree{ readers.size(), less };
+        while (!readers[tree.top()]->done()) {
+            auto& reader = *readers[tree.top()];
+            out.write(reader.entry(keys), reader.entry_size(keys));
+            reader.next();
+            tree.replay();
+        }
+    }
+
+} // ::detail::external_sort
+
+// Appends the key encoding of a value (see key_encoding.hpp) to 'bytes'.
+template <class T>
+void append_key(std::vector<std::byte>& bytes, T const& value) {
+    auto const offset = bytes.size();
+    bytes.resize(offset + tom::serialized_key_size(value));
+    output_span<> span{ bytes.data() + offset, bytes.size() - offset };
+    tom::serialize_key(span, value);
+}
+
+// Sorts the framed records of 'in' (eg. written by 'serialize_framed') on keys computed from their payloads,
+// and writes them to 'out'. Returns the number of records.
+// 'append_key(input_span<span_policy::error>& payload, std::vector<std::byte>& key)' reads the payload and
+// appends it's key to 'key' (see 'append_key'), failing the payload span if the record is invalid.
+// Throws a 'serialization_error' on invalid records and a 'std::system_error' if a run can't be created.
+template <class AppendKey>
+size_t sort_frames(std::istream& in, std::ostream& out, AppendKey&& append_key, sort_options const& options = {}) {
+    namespace sort = detail::external_sort;
+    if (options.memory_budget == 0 || options.buffer_size == 0 || options.max_fan_in < 2) {
+        throw std::invalid_argument{ "tapeworm : invalid sort options" };
+    }
+    sort::io_queue io{ options.io_thread };
+    sort::temp_files temp{ options.temp_directory };
+    std::vector<std::string> runs;
+    sort::run_buffer run;
+
+    auto const spill = [&] {
+        runs.push_back(temp.create());
+        auto file = sort::create_file(runs.back());
+        sort::buffered_writer writer{ file, io, options.buffer_size };
+        run.write(writer, true);
+        writer.finish();
+        run.clear();
+    };
+
+    auto const invalid = [] { throw serialization_error{ "tapeworm : invalid record" }; };
+    size_t count = 0;
+    sort::buffered_reader reader{ in, io, options.buffer_size };
+    while (!reader.empty()) {
+        auto data = reader.peek(frame_header_size);
+        if (!data) invalid();
+        length_type length;
+        std::memcpy(&length, data, sizeof(length));
+        auto const size = frame_header_size + size_t{ length };
+        data = reader.peek(size);
+        if (!data) invalid();
+
+        input_span<span_policy::error> frame{ data, size }, payload;
+        if (!tom::read_frame(frame, payload)) invalid();
+        run.add([&] (std::vector<std::byte>& key) { append_key(payload, key); }, data, size);
+        if (payload.failed()) invalid();
+        reader.consume(size);
+        ++count;
+        if (run.memory() >= options.memory_budget) spill();
+    }
+
+    sort::buffered_writer writer{ out, io, options.buffer_size };
+    if (runs.empty()) {
+        run.write(writer, false);
+        writer.finish();
+        return count;
+    }
+    if (!run.empty()) spill();
+
+    // Merges groups of runs until they can all be merged at once.
+    while (runs.size() > options.max_fan_in) {
+        std::vector<std::string> merged;
+        for (size_t i = 0; i < runs.size(); i += options.max_fan_in) {
+            std::vector<std::string> const group(runs.begin() + static_cast<std::ptrdiff_t>(i),
+                runs.begin() + static_cast<std::ptrdiff_t>(std::min(runs.size(), i + options.max_fan_in)));
+            merged.push_back(temp.create());
+            auto file = sort::create_file(merged.back());
+            sort::buffered_writer group_writer{ file, io, options.buffer_size };
+            sort::merge(group, group_writer, true, io, options.buffer_size);
+            group_writer.finish();
+            for (auto const& path : group) temp.remove(path);
+        }
+        runs = std::move(merged);
+    }
+    sort::merge(runs, writer, false, io, options.buffer_size);
+    writer.finish();
+    return count;
+}
+
+// Sorts the framed records of T of 'in' (written by 'serialize_framed') on 'key(T const&)', any value
+// supported by 'serialize_key', and writes them to 'out'. Returns the number of records.
+// Throws a 'serialization_error' on invalid records and a 'std::system_error' if a run can't be created.
+template <class T, class Key>
+size_t sort_records(std::istream& in, std::ostream& out, Key&& key, sort_options const& options = {}) {
+    return tom::sort_frames(in, out, [&key] (auto& payload, std::vector<std::byte>& bytes) {
+        T value{};
+        tom::deserialize(payload, value);
+        if (payload.failed() || payload.size() != 0) {
+            payload.fail("tapeworm : invalid record");
+            return;
+        }
+        tom::append_key(bytes, key(std::as_const(value)));
+    }, options);
+}
+
+// Sorts a file of framed records of T into another one, see 'sort_records'.
+template <class T, class Key>
+size_t sort_file(std::string const& input, std::string const& output, Key&& key, sort_options const& options = {}) {
+    auto in = detail::external_sort::open_file(input);
+    auto out = detail::external_sort::create_file(output);
+    return tom::sort_records<T>(in, out, std::forward<Key>(key), options);
+}
+
+} // ::tom
@@ -0,0 +1,140 @@
+
+#pragma once
+
+#include "field_path.hpp"
+#include <bitset>
+
+/*
+    Partial serialization of tuple-like values.
+
+    Wire format :
+        - A presence bitmap of (N + 7) / 8 bytes, N being the number of members.
+          The bit j (byte j / 8, bit j % 8) is set if the member j is present.
+        - The present members in order.
+
+    The mask is either known at compile-time ('fields<Is...>') or at runtime ('field_mask<T>').
+    The reader only assigns the present members, the others keep their value.
+*/
+
+namespace tom {
+
+template <size_t...Is>
+struct field_list {};
+
+template <size_t...Is>
+constexpr field_list<Is...> fields{};
+
+// The number of members of a tuple-like T.
+template <class T>
+constexpr size_t fields_count_v = std::tuple_size_v<detail::path::members_t<T>>;
+
+template <class T>
+using field_mask = std::bitset<fields_count_v<T>>;
+
+namespace detail::mask {
+
+    template <size_t N>
+    constexpr size_t bitmap_size = (N + 7) / 8;
+
+    template <size_t N, size_t...Is>
+    constexpr std::array<std::uint8_t, bitmap_size<N>> make_bitmap() noexcept {
+        std::array<std::uint8_t, bitmap_size<N>> bitmap{};
+        for (auto const i : { Is... }) {
+            bitmap[i / 8] |= static_cast<std::uint8_t>(1 << (i % 8));
+        }
+        return bitmap;
+    }
+
+    template <size_t N>
+    std::array<std::uint8_t, bitmap_size<N>> make_bitmap(std::bitset<N> const& mask) noexcept {
+        std::array<std::uint8_t, bitmap_size<N>> bitmap{};
+        for (size_t i = 0; i < N; ++i) {
+            if (mask[i]) bitmap[i / 8] |= static_cast<std::uint8_t>(1 << (i % 8));
+        }
+        return bitmap;
+    }
+
+    template <class Tuple, size_t N, size_t...Js>
+    size_t fields_size(Tuple const& members, std::bitset<N> const& mask, std::index_sequence<Js...>) {
+        return (size_t{ 0 } + ... + (mask[Js] ? tom::serialized_size(std::get<Js>(members)) : 0));
+    }
+
+} // ::detail::mask
+
+// The number of bytes used to serialize the selected members of a tuple-like T.
+
+template <class T, size_t...Is>
+size_t serialized_size(T const& value, field_list<Is...>) {
+    using tuple_concept = typename serial_concept_t<T>::tuple_concept;
+    auto const members = tuple_concept::as_tuple(value);
+    return detail::mask::bitmap_size<fields_count_v<T>> +
+        (size_t{ 0 } + ... + tom::serialized_size(std::get<Is>(members)));
+}
+
+template <class T>
+size_t serialized_size(T const& value, field_mask<T> const& mask) {
+    using tuple_concept = typename serial_concept_t<T>::tuple_concept;
+    auto const members = tuple_concept::as_tuple(value);
+    return detail::mask::bitmap_size<fields_count_v<T>> + detail::mask::fields_size(
+        members, mask, std::make_index_sequence<fields_count_v<T>>{});
+}
+
+// Serializes the members Is... of a tuple-like T, preceded by their presence bitmap.
+template <class Span, class T, size_t...Is>
+void serialize_fields(Span& span, T const& value, field_list<Is...>) {
+    constexpr auto count = fields_count_v<T>;
+    static_assert(detail::path::is_strictly_increasing<Is...>(),
+        "The member indexes must be strictly increasing.");
+    static_assert(((Is < count) && ...), "Member index out of range");
+
+    using tuple_concept = typename serial_concept_t<T>::tuple_concept;
+    constexpr auto bitmap = detail::mask::make_bitmap<count, Is...>();
+    span.write(bitmap.data(), bitmap.size());
+
+    auto const members = tuple_concept::as_tuple(value);
+    (tom::serialize(span, std::get<Is>(members)), ...);
+}
+
+// Serializes the members of a tuple-like T selected at runtime, preceded by their presence bitmap.
+template <class Span, class T>
+void serialize_fields(Span& span, T const& value, field_mask<T> const& mask) {
+    using tuple_concept = typename serial_concept_t<T>::tuple_concept;
+    auto const bitmap = detail::mask::make_bitmap(mask);
+    span.write(bitmap.data(), bitmap.size());
+
+    auto const members = tuple_concept::as_tuple(value);
+    auto const serialize_member = [&] (auto j) {
+        if (mask[j]) tom::serialize(span, std::get<decltype(j)::value>(members));
+    };
+    for_each_index<fields_count_v<T>>(serialize_member);
+}
+
+// Deserializes the members present in the bitmap into 'value', the others are left untouched.
+// Returns the mask of the members read.
+template <class Span, class T>
+field_mask<T> deserialize_fields(Span& span, T& value) {
+    constexpr auto count = fields_count_v<T>;
+    using tuple_concept = typename serial_concept_t<T>::tuple_concept;
+
+    std::array<std::uint8_t, detail::mask::bitmap_size<count>> bitmap{};
+    span.read(bitmap.data(), bitmap.size());
+    if (span.failed()) return {};
+    if constexpr (count % 8 != 0) {
+        if (bitmap.back() >> (count % 8)) {
+            span.fail("tapeworm : invalid presence bitmap");
+            return {};
+        }
+    }
+    field_mask<T> mask;
+    for (size_t i = 0; i < count; ++i) {
+        mask[i] = (bitmap[i / 8] >> (i % 8)) & 1;
+    }
+    auto members = tuple_concept::as_tuple(value);
+    auto const deserialize_member = [&] (auto j) {
+        if (mask[j]) tom::deserialize(span, std::get<decltype(j)::value>(members));
+    };
+    for_each_index<count>(deserialize_member);
+    return mask;
+}
+
+} // ::tom
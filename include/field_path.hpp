@@ -0,0 +1,222 @@
+
+#pragma once
+
+#include "serialization.hpp"
+
+namespace tom {
+
+// Steps of a path leading to a field of a serialized value :
+//  - 'member<I>' selects the I-th element of a tuple-like value.
+//  - 'element{ i }' selects the i-th element of a range.
+//
+// auto ref = tom::locate<std::vector<record>>(span, tom::element{ 17 }, tom::member<3>);
+// ref.set(ref.get() + 1);
+
+template <size_t I>
+struct member_t {
+    static constexpr size_t index = I;
+};
+
+template <size_t I>
+constexpr member_t<I> member{};
+
+struct element {
+    size_t index;
+};
+
+// A reference to a field of constant size in a serialized buffer.
+// Mutable if 'Byte' is not const, in which case the field can be patched in place.
+template <class T, class Byte = std::byte>
+class serialized_ref {
+    static_assert(has_constant_size_v<T>,
+        "Only fields with a constant serialized size can be referenced.");
+public:
+    using value_type = T;
+
+    static constexpr size_t size = constant_size_v<T>;
+
+    constexpr serialized_ref() noexcept = default;
+    constexpr explicit serialized_ref(Byte* data) noexcept : data_{ data } {}
+
+    // False if the field could not be located.
+    constexpr explicit operator bool() const noexcept { return data_ != nullptr; }
+
+    constexpr Byte* data() const noexcept { return data_; }
+
+    T get() const {
+        input_span<span_policy::unsafe> span{ data_, size };
+        return tom::deserialize<T>(span);
+    }
+
+    // Overwrites the field without touching the rest of the buffer.
+    void set(T const& value) const {
+        static_assert(!std::is_const_v<Byte>, "Can't patch a field of an input span");
+        output_span<span_policy::unsafe> span{ data_, size };
+        tom::serialize(span, value);
+    }
+private:
+    Byte* data_ = nullptr;
+};
+
+namespace detail::path {
+
+    template <class T, class Step>
+    struct step_result {};
+
+    template <class T, size_t I>
+    struct step_result<T, member_t<I>> {
+        using tuple_type = typename serial_concept_t<T>::tuple_type;
+        using type = remove_cvref_t<std::tuple_element_t<I, tuple_type>>;
+    };
+
+    template <class T>
+    struct step_result<T, element> {
+        using type = typename serial_concept_t<T>::value_type;
+    };
+
+    template <class T, class Step>
+    using step_result_t = typename step_result<T, Step>::type;
+
+    template <class T, class...Steps>
+    struct path_result {
+        using type = T;
+    };
+    template <class T, class Step, class...Steps>
+    struct path_result<T, Step, Steps...> {
+        using type = typename path_result<step_result_t<T, Step>, Steps...>::type;
+    };
+
+    // Skips the members preceding the I-th one.
+    // Their offset is computed at compile-time when they have a constant size.
+    template <class Tuple, class Span, size_t...Is>
+    void skip_members(Span& span, std::index_sequence<Is...>) {
+        using members = std::tuple<remove_cvref_t<std::tuple_element_t<Is, Tuple>>...>;
+        constexpr bool is_constant = (has_constant_size_v<std::tuple_element_t<Is, members>> && ...);
+        if constexpr (is_constant) {
+            serial::detail::skip_bytes(span, (size_t{ 0 } + ... + constant_size_v<std::tuple_element_t<Is, members>>));
+        }
+        else (tom::skip<std::tuple_element_t<Is, members>>(span), ...);
+    }
+
+    template <class T, class Span, size_t I>
+    void step(Span& span, member_t<I>) {
+        using tuple_type = typename serial_concept_t<T>::tuple_type;
+        static_assert(I < std::tuple_size_v<tuple_type>, "Member index out of range");
+        skip_members<tuple_type>(span, std::make_index_sequence<I>{});
+    }
+
+    template <class T, class Span>
+    void step(Span& span, element e) {
+        using value_type = step_result_t<T, element>;
+        length_type length;
+        if (!serial::detail::read_length(span, length)) return;
+        if (e.index >= length) {
+            span.fail("tapeworm : element index out of range");
+            return;
+        }
+        if constexpr (has_constant_size_v<value_type>) {
+            serial::detail::skip_bytes(span, e.index * constant_size_v<value_type>);
+        }
+        else for (size_t i = 0; i < e.index && !span.failed(); ++i) {
+            tom::skip<value_type>(span);
+        }
+    }
+
+    template <class T, class Span>
+    void walk(Span&) {}
+
+    template <class T, class Span, class Step, class...Steps>
+    void walk(Span& span, Step step, Steps...steps) {
+        path::step<T>(span, step);
+        if (span.failed()) return;
+        walk<step_result_t<T, Step>>(span, steps...);
+    }
+
+    // The position of J in Is, or -1.
+    template <size_t J, size_t...Is>
+    constexpr int position_of() noexcept {
+        int position = 0;
+        for (auto const i : { Is... }) {
+            if (i == J) return position;
+            ++position;
+        }
+        return -1;
+    }
+
+    template <size_t...Is>
+    constexpr bool is_strictly_increasing() noexcept {
+        size_t const indexes[] = { Is... };
+        for (size_t i = 1; i < sizeof...(Is); ++i) {
+            if (indexes[i - 1] >= indexes[i]) return false;
+        }
+        return true;
+    }
+
+    template <class T>
+    struct members {};
+    template <class...Ts>
+    struct members<std::tuple<Ts...>> {
+        using type = std::tuple<remove_cvref_t<Ts>...>;
+    };
+
+    template <class T>
+    using members_t = typename members<typename serial_concept_t<T>::tuple_type>::type;
+
+    // Deserializes the selected members and skips the others.
+    template <class Members, size_t...Is, class Span, class Fields, size_t...Js>
+    void read_members(Span& span, Fields& fields, std::index_sequence<Js...>) {
+        auto const read_member = [&] (auto j) {
+            constexpr auto position = position_of<decltype(j)::value, Is...>();
+            if constexpr (position >= 0) {
+                tom::deserialize(span, std::get<position>(fields));
+            }
+            else tom::skip<std::tuple_element_t<decltype(j)::value, Members>>(span);
+        };
+        (read_member(std::integral_constant<size_t, Js>{}), ...);
+    }
+
+} // ::detail::path
+
+template <class T, class...Steps>
+using path_result_t = typename detail::path::path_result<T, Steps...>::type;
+
+// Moves the span to the field designated by the path in a serialized T, and returns
+// a reference to it. The reference is null if the span failed.
+template <class T, class Span, class...Steps>
+auto locate(Span& span, Steps...steps) {
+    using field_type = path_result_t<T, Steps...>;
+    using ref_type   = serialized_ref<field_type, typename Span::byte_type>;
+
+    detail::path::walk<T>(span, steps...);
+    if (span.failed() || !span.check(ref_type::size)) return ref_type{};
+    return ref_type{ span.begin() };
+}
+
+// Overwrites in place the field designated by the path in a serialized T.
+// Returns false if the field could not be located.
+template <class T, class Span, class...Steps>
+bool patch(Span& span, path_result_t<T, Steps...> const& value, Steps...steps) {
+    auto const ref = tom::locate<T>(span, steps...);
+    if (!ref) return false;
+    ref.set(value);
+    return true;
+}
+
+// Deserializes only the members Is... of a serialized tuple-like T, and returns them in a tuple.
+// Other members are skipped without being constructed. The span is moved past the whole T.
+//
+// auto [id, date] = tom::read_fields<message, 0, 2>(span);
+template <class T, size_t...Is, class Span>
+auto read_fields(Span& span) {
+    using members = detail::path::members_t<T>;
+    static_assert(detail::path::is_strictly_increasing<Is...>(),
+        "The member indexes must be strictly increasing.");
+    static_assert(((Is < std::tuple_size_v<members>) && ...), "Member index out of range");
+
+    std::tuple<std::tuple_element_t<Is, members>...> fields{};
+    detail::path::read_members<members, Is...>(span, fields,
+        std::make_index_sequence<std::tuple_size_v<members>>{});
+    return fields;
+}
+
+} // ::tom
@@ -0,0 +1,407 @@
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #include <immintrin.h>
+    #define TAPEWORM_AVX2   __attribute__((target("avx2")))
+    #define TAPEWORM_AVX512 __attribute__((target("avx512f")))
+#endif
+
+/*
+    Filters on numeric columns : a comparison of each value ('==', '<', between, in a set) gives
+    a selection bitmap, one bit per value (bit i % 64 of the word i / 64). Selections are combined
+    with '&', '|' and '~', then drive a gather of the selected rows.
+
+    The comparisons of 4 and 8 bytes values are vectorized with AVX-512 or AVX2, chosen at runtime
+    from the CPU, each 64 values giving a word of the bitmap. Other values and CPUs use a branchless
+    scalar loop. NaNs are never selected.
+*/
+
+namespace tom {
+
+// A set of rows, as a bitmap.
+class selection {
+public:
+    selection() = default;
+    explicit selection(size_t size, bool selected = false) :
+        words_((size + 63) / 64, selected ? ~std::uint64_t{ 0 } : 0), size_{ size } {
+        clear_tail();
+    }
+
+    size_t size() const noexcept { return size_; }
+
+    bool operator[](size_t i) const noexcept { return words_[i / 64] >> (i % 64) & 1; }
+    void set(size_t i, bool selected = true) noexcept {
+        auto const bit = std::uint64_t{ 1 } << (i % 64);
+        words_[i / 64] = selected ? words_[i / 64] | bit : words_[i / 64] & ~bit;
+    }
+
+    // The number of selected rows.
+    size_t count() const noexcept {
+        size_t count = 0;
+        for (auto word : words_) count += popcount(word);
+        return count;
+    }
+    bool any() const noexcept {
+        return std::any_of(words_.begin(), words_.end(), [] (std::uint64_t word) { return word != 0; });
+    }
+
+    selection& operator&=(selection const& other) {
+        check_size(other);
+        for (size_t i = 0; i < words_.size(); ++i) words_[i] &= other.words_[i];
+        return *this;
+    }
+    selection& operator|=(selection const& other) {
+        check_size(other);
+        for (size_t i = 0; i < words_.size(); ++i) words_[i] |= other.words_[i];
+        return *this;
+    }
+    friend selection operator&(selection lhs, selection const& rhs) { return lhs &= rhs; }
+    friend selection operator|(selection lhs, selection const& rhs) { return lhs |= rhs; }
+    friend selection operator~(selection value) {
+        for (auto& word : value.words_) word = ~word;
+        value.clear_tail();
+        return value;
+    }
+
+    // Calls 'f(i)' on the selected rows, in order.
+    template <class F>
+    void for_each(F&& f) const {
+        for (size_t i = 0; i < words_.size(); ++i) {
+            for (auto word = words_[i]; word != 0; word &= word - 1) f(i * 64 + trailing_zeros(word));
+        }
+    }
+
+    std::vector<size_t> indices() const {
+        std::vector<size_t> indices;
+        indices.reserve(count());
+        for_each([&] (size_t i) { indices.push_back(i); });
+        return indices;
+    }
+
+    std::uint64_t* words() noexcept { return words_.data(); }
+    std::uint64_t const* words() const noexcept { return words_.data(); }
+private:
+    static size_t popcount(std::uint64_t word) noexcept {
+    #if defined(__GNUC__) || defined(__clang__)
+        return static_cast<size_t>(__builtin_popcountll(word));
+    #else
+        size_t count = 0;
+        for (; word != 0; word &= word - 1) ++count;
+        return count;
+    #endif
+    }
+    static size_t trailing_zeros(std::uint64_t word) noexcept {
+    #if defined(__GNUC__) || defined(__clang__)
+        return static_cast<size_t>(__builtin_ctzll(word));
+    #else
+        size_t count = 0;
+        for (; (word & 1) == 0; word >>= 1) ++count;
+        return count;
+    #endif
+    }
+
+    void check_size(selection const& other) const {
+        if (other.size_ != size_) throw std::invalid_argument{ "tapeworm : selections of different sizes" };
+    }
+
+    // The bits past the size are never set.
+    void clear_tail() noexcept {
+        if (size_ % 64 != 0) words_.back() &= (std::uint64_t{ 1 } << (size_ % 64)) - 1;
+    }
+
+    std::vector<std::uint64_t> words_;
+    size_t size_ = 0;
+};
+
+namespace detail::filter {
+
+    enum class compare_op { equal, less, between };
+
+    enum class simd_level { scalar, avx2, avx512 };
+
+    template <class T>
+    constexpr bool is_filterable_v = std::is_arithmetic_v<T> && !std::is_same_v<T, bool>;
+
+    template <class T>
+    constexpr bool is_vectorized_v = is_filterable_v<T> && (sizeof(T) == 4 || sizeof(T) == 8);
+
+    // Selects the values 'op' (a, b), in words of 64 values.
+    template <class T>
+    void select_scalar(T const* values, size_t count, compare_op op, T a, T b, std::uint64_t* words) noexcept {
+        auto const select = [&] (auto predicate) {
+            for (size_t i = 0; i < count; i += 64) {
+                auto const n = std::min<size_t>(64, count - i);
+                std::uint64_t word = 0;
+                for (size_t j = 0; j < n; ++j) word |= static_cast<std::uint64_t>(predicate(values[i + j])) << j;
+                words[i / 64] = word;
+            }
+        };
+        switch (op) {
+            case compare_op::equal: select([a] (T value) { return value == a; }); break;
+            case compare_op::less:  select([a] (T value) { return value < a; }); break;
+            case compare_op::between: select([a, b] (T value) { return (a <= value) & (value <= b); }); break;
+        }
+    }
+
+#ifdef TAPEWORM_AVX2
+
+    // The sign bit, flipped to compare unsigned integers as signed ones.
+    template <class T>
+    constexpr T sign_bit = static_cast<T>(std::is_unsigned_v<T> ? T{ 1 } << (8 * sizeof(T) - 1) : 0);
+
+    // Compares 8 values of 4 bytes or 4 values of 8 bytes, returns the selected lanes as bits.
+    template <compare_op Op, class T>
+    TAPEWORM_AVX2 inline unsigned compare_avx2(T const* values, __m256i a, __m256i b) noexcept {
+        if constexpr (std::is_floating_point_v<T>) {
+            if constexpr (sizeof(T) == 4) {
+                auto const x = _mm256_loadu_ps(values);
+                auto const low = _mm256_castsi256_ps(a), high = _mm256_castsi256_ps(b);
+                if constexpr (Op == compare_op::equal) return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(x, low, _CMP_EQ_OQ)));
+                else if constexpr (Op == compare_op::less) return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(x, low, _CMP_LT_OQ)));
+                else return static_cast<unsigned>(_mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(x, low, _CMP_GE_OQ), _mm256_cmp_ps(x, high, _CMP_LE_OQ))));
+            }
+            else {
+                auto const x = _mm256_loadu_pd(values);
+                auto const low = _mm256_castsi256_pd(a), high = _mm256_castsi256_pd(b);
+                if constexpr (Op == compare_op::equal) return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(x, low, _CMP_EQ_OQ)));
+                else if constexpr (Op == compare_op::less) return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(x, low, _CMP_LT_OQ)));
+                else return static_cast<unsigned>(_mm256_movemask_pd(_mm256_and_pd(_mm256_cmp_pd(x, low, _CMP_GE_OQ), _mm256_cmp_pd(x, high, _CMP_LE_OQ))));
+            }
+        }
+        else {
+            // 'a' and 'b' have their sign bit flipped for unsigned integers.
+            auto x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(values));
+            __m256i mask;
+            if constexpr (sizeof(T) == 4) {
+                if constexpr (std::is_unsigned_v<T>) x = _mm256_xor_si256(x, _mm256_set1_epi32(static_cast<int>(sign_bit<T>)));
+                if constexpr (Op == compare_op::equal) mask = _mm256_cmpeq_epi32(x, a);
+                else if constexpr (Op == compare_op::less) mask = _mm256_cmpgt_epi32(a, x);
+                else mask = _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpgt_epi32(a, x), _mm256_cmpgt_epi32(x, b)), _mm256_set1_epi32(-1));
+                return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(mask)));
+            }
+            else {
+                if constexpr (std::is_unsigned_v<T>) x = _mm256_xor_si256(x, _mm256_set1_epi64x(static_cast<long long>(sign_bit<T>)));
+                if constexpr (Op == compare_op::equal) mask = _mm256_cmpeq_epi64(x, a);
+                else if constexpr (Op == compare_op::less) mask = _mm256_cmpgt_epi64(a, x);
+                else mask = _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpgt_epi64(a, x), _mm256_cmpgt_epi64(x, b)), _mm256_set1_epi64x(-1));
+                return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(mask)));
+            }
+        }
+    }
+
+    template <class T>
+    TAPEWORM_AVX2 inline __m256i broadcast_avx2(T value) noexcept {
+        if constexpr (std::is_same_v<T, float>) return _mm256_castps_si256(_mm256_set1_ps(value));
+        else if constexpr (std::is_same_v<T, double>) return _mm256_castpd_si256(_mm256_set1_pd(value));
+        else if constexpr (sizeof(T) == 4) return _mm256_set1_epi32(static_cast<int>(value ^ sign_bit<T>));
+        else return _mm256_set1_epi64x(static_cast<long long>(value ^ sign_bit<T>));
+    }
+
+    // Fills the words of the whole blocks of 64 values, returns the number of values selected.
+    template <compare_op Op, class T>
+    TAPEWORM_AVX2 size_t select_blocks_avx2(T const* values, size_t count, T a, T b, std::uint64_t* words) noexcept {
+        constexpr size_t lanes = 32 / sizeof(T);
+        auto const low = broadcast_avx2(a), high = broadcast_avx2(b);
+        size_t i = 0;
+        for (; i + 64 <= count; i += 64) {
+            std::uint64_t word = 0;
+            for (size_t j = 0; j < 64; j += lanes) {
+                word |= std::uint64_t{ compare_avx2<Op>(values + i + j, low, high) } << j;
+            }
+            words[i / 64] = word;
+        }
+        return i;
+    }
+
+    template <class T>
+    void select_avx2(T const* values, size_t count, compare_op op, T a, T b, std::uint64_t* words) noexcept {
+        size_t i = 0;
+        switch (op) {
+            case compare_op::equal: i = select_blocks_avx2<compare_op::equal>(values, count, a, b, words); break;
+            case compare_op::less:  i = select_blocks_avx2<compare_op::less>(values, count, a, b, words); break;
+            default: i = select_blocks_avx2<compare_op::between>(values, count, a, b, words); break;
+        }
+        if (i != count) select_scalar(values + i, count - i, op, a, b, words + i / 64);
+    }
+
+    // Compares 16 values of 4 bytes or 8 values of 8 bytes, returns the selected lanes as bits.
+    template <compare_op Op, class T>
+    TAPEWORM_AVX512 inline unsigned compare_avx512(T const* values, T a, T b) noexcept {
+        if constexpr (std::is_same_v<T, float>) {
+            auto const x = _mm512_loadu_ps(values);
+            if constexpr (Op == compare_op::equal) return _mm512_cmp_ps_mask(x, _mm512_set1_ps(a), _CMP_EQ_OQ);
+            else if constexpr (Op == compare_op::less) return _mm512_cmp_ps_mask(x, _mm512_set1_ps(a), _CMP_LT_OQ);
+            else return _mm512_cmp_ps_mask(x, _mm512_set1_ps(a), _CMP_GE_OQ) & _mm512_cmp_ps_mask(x, _mm512_set1_ps(b), _CMP_LE_OQ);
+        }
+        else if constexpr (std::is_same_v<T, double>) {
+            auto const x = _mm512_loadu_pd(values);
+            if constexpr (Op == compare_op::equal) return _mm512_cmp_pd_mask(x, _mm512_set1_pd(a), _CMP_EQ_OQ);
+            else if constexpr (Op == compare_op::less) return _mm512_cmp_pd_mask(x, _mm512_set1_pd(a), _CMP_LT_OQ);
+            else return _mm512_cmp_pd_mask(x, _mm512_set1_pd(a), _CMP_GE_OQ) & _mm512_cmp_pd_mask(x, _mm512_set1_pd(b), _CMP_LE_OQ);
+        }
+        else if constexpr (sizeof(T) == 4) {
+            auto const x = _mm512_loadu_si512(values);
+            auto const low = _mm512_set1_epi32(static_cast<int>(a)), high = _mm512_set1_epi32(static_cast<int>(b));
+            if constexpr (std::is_unsigned_v<T>) {
+                if constexpr (Op == compare_op::equal) return _mm512_cmpeq_epu32_mask(x, low);
+                else if constexpr (Op == compare_op::less) return _mm512_cmplt_epu32_mask(x, low);
+                else return _mm512_cmpge_epu32_mask(x, low) & _mm512_cmple_epu32_mask(x, high);
+            }
+            else {
+                if constexpr (Op == compare_op::equal) return _mm512_cmpeq_epi32_mask(x, low);
+                else if constexpr (Op == compare_op::less) return _mm512_cmplt_epi32_mask(x, low);
+                else return _mm512_cmpge_epi32_mask(x, low) & _mm512_cmple_epi32_mask(x, high);
+            }
+        }
+        else {
+            auto const x = _mm512_loadu_si512(values);
+            auto const low = _mm512_set1_epi64(static_cast<long long>(a)), high = _mm512_set1_epi64(static_cast<long long>(b));
+            if constexpr (std::is_unsigned_v<T>) {
+                if constexpr (Op == compare_op::equal) return _mm512_cmpeq_epu64_mask(x, low);
+                else if constexpr (Op == compare_op::less) return _mm512_cmplt_epu64_mask(x, low);
+                else return _mm512_cmpge_epu64_mask(x, low) & _mm512_cmple_epu64_mask(x, high);
+            }
+            else {
+                if constexpr (Op == compare_op::equal) return _mm512_cmpeq_epi64_mask(x, low);
+                else if constexpr (Op == compare_op::less) return _mm512_cmplt_epi64_mask(x, low);
+                else return _mm512_cmpge_epi64_mask(x, low) & _mm512_cmple_epi64_mask(x, high);
+            }
+        }
+    }
+
+    template <compare_op Op, class T>
+    TAPEWORM_AVX512 size_t select_blocks_avx512(T const* values, size_t count, T a, T b, std::uint64_t* words) noexcept {
+        constexpr size_t lanes = 64 / sizeof(T);
+        size_t i = 0;
+        for (; i + 64 <= count; i += 64) {
+            std::uint64_t word = 0;
+            for (size_t j = 0; j < 64; j += lanes) {
+                word |= std::uint64_t{ compare_avx512<Op>(values + i + j, a, b) } << j;
+            }
+            words[i / 64] = word;
+        }
+        return i;
+    }
+
+    template <class T>
+    void select_avx512(T const* values, size_t count, compare_op op, T a, T b, std::uint64_t* words) noexcept {
+        size_t i = 0;
+        switch (op) {
+            case compare_op::equal: i = select_blocks_avx512<compare_op::equal>(values, count, a, b, words); break;
+            case compare_op::less:  i = select_blocks_avx512<compare_op::less>(values, count, a, b, words); break;
+            default: i = select_blocks_avx512<compare_op::between>(values, count, a, b, words); break;
+        }
+        if (i != count) select_scalar(values + i, count - i, op, a, b, words + i / 64);
+    }
+
+    inline simd_level detect_simd() noexcept {
+        static simd_level const level = [] {
+            if (__builtin_cpu_supports("avx512f")) return simd_level::avx512;
+            if (__builtin_cpu_supports("avx2")) return simd_level::avx2;
+            return simd_level::scalar;
+        }();
+        return level;
+    }
+
+#else
+
+    constexpr simd_level detect_simd() noexcept { return simd_level::scalar; }
+
+#endif
+
+    // Selects with the given instructions, which the CPU must support.
+    template <class T>
+    void select(simd_level level, T const* values, size_t count, compare_op op, T a, T b, std::uint64_t* words) noexcept {
+    #ifdef TAPEWORM_AVX2
+        if constexpr (is_vectorized_v<T>) {
+            if (level == simd_level::avx512) return select_avx512(values, count, op, a, b, words);
+            if (level == simd_level::avx2) return select_avx2(values, count, op, a, b, words);
+        }
+    #endif
+        (void)level;
+        select_scalar(values, count, op, a, b, words);
+    }
+
+    template <class T>
+    selection select(T const* values, size_t count, compare_op op, T a, T b) {
+        static_assert(is_filterable_v<T>, "Only numeric columns can be filtered");
+        selection selected{ count };
+        select(detect_simd(), values, count, op, a, b, selected.words());
+        return selected;
+    }
+
+    template <class Column>
+    using column_value_t = std::remove_cv_t<std::remove_reference_t<decltype(*std::data(std::declval<Column const&>()))>>;
+
+} // ::detail::filter
+
+// The rows where 'values[i] == value'.
+template <class T>
+selection select_equal(T const* values, size_t count, T value) {
+    return detail::filter::select(values, count, detail::filter::compare_op::equal, value, value);
+}
+
+// The rows where 'values[i] < value'.
+template <class T>
+selection select_less(T const* values, size_t count, T value) {
+    return detail::filter::select(values, count, detail::filter::compare_op::less, value, value);
+}
+
+// The rows where 'low <= values[i] <= high'.
+template <class T>
+selection select_between(T const* values, size_t count, T low, T high) {
+    return detail::filter::select(values, count, detail::filter::compare_op::between, low, high);
+}
+
+// The rows where 'values[i]' is one of 'set', one pass over the values per element of the set.
+template <class T>
+selection select_in(T const* values, size_t count, std::vector<T> const& set) {
+    selection selected{ count };
+    for (auto const value : set) selected |= tom::select_equal(values, count, value);
+    return selected;
+}
+
+template <class Column>
+selection select_equal(Column const& column, detail::filter::column_value_t<Column> value) {
+    return tom::select_equal(std::data(column), std::size(column), value);
+}
+
+template <class Column>
+selection select_less(Column const& column, detail::filter::column_value_t<Column> value) {
+    return tom::select_less(std::data(column), std::size(column), value);
+}
+
+template <class Column>
+selection select_between(Column const& column, detail::filter::column_value_t<Column> low, detail::filter::column_value_t<Column> high) {
+    return tom::select_between(std::data(column), std::size(column), low, high);
+}
+
+template <class Column>
+selection select_in(Column const& column, std::vector<detail::filter::column_value_t<Column>> const& set) {
+    return tom::select_in(std::data(column), std::size(column), set);
+}
+
+// The selected rows of a random access range, in order.
+template <class Range>
+auto gather(Range const& rows, selection const& selected) {
+    using value_type = std::remove_cv_t<std::remove_reference_t<decltype(*std::begin(rows))>>;
+    if (selected.size() != static_cast<size_t>(std::size(rows))) {
+        throw std::invalid_argument{ "tapeworm : the selection does not match the rows" };
+    }
+    std::vector<value_type> gathered;
+    gathered.reserve(selected.count());
+    auto const begin = std::begin(rows);
+    selected.for_each([&] (size_t i) { gathered.push_back(begin[static_cast<std::ptrdiff_t>(i)]); });
+    return gathered;
+}
+
+} // ::tom
@@ -0,0 +1,147 @@
+
+#pragma once
+
+#include "serialization.hpp"
+
+/*
+    A 64 bits hash of the serialized layout of a type, computed at compile-time.
+    It depends on the concept chosen for each node of the expression tree, the kind
+    and size of numbers, the arity of tuple-likes and the nesting of all of these.
+    Names are not part of it : two types serialized the same way share their fingerprint.
+
+    It can be written as a message header and checked before reading the message :
+
+    tom::write_fingerprint<message>(span);
+    tom::serialize(span, msg);
+    ...
+    if (tom::check_fingerprint<message>(span)) tom::deserialize(span, msg);
+*/
+
+namespace tom {
+
+namespace detail::fingerprint {
+
+    constexpr std::uint64_t mix(std::uint64_t value) noexcept {
+        value ^= value >> 30;
+        value *= 0xBF58476D1CE4E5B9;
+        value ^= value >> 27;
+        value *= 0x94D049BB133111EB;
+        value ^= value >> 31;
+        return value;
+    }
+
+    constexpr std::uint64_t combine(std::uint64_t seed, std::uint64_t value) noexcept {
+        return mix(seed + 0x9E3779B97F4A7C15 + value);
+    }
+
+    // The tags of the concepts and of the kinds of numbers.
+    enum tag : std::uint64_t {
+        trivial = 1, trivial_array, optional, tuple_like, range,
+        boolean, floating, signed_integer, unsigned_integer, enumeration, array,
+        frame_of_reference, delta_encoding, xor_encoding, run_length_encoding, adaptive_encoding,
+        dictionary_encoding, prefix_encoding
+    };
+
+    template <class T>
+    constexpr std::uint64_t of();
+
+    template <class T>
+    constexpr std::uint64_t of_trivial();
+
+    template <class T, size_t Size>
+    constexpr std::uint64_t of_std_array(type_tag<std::array<T, Size>>) {
+        return combine(combine(array, Size), of_trivial<T>());
+    }
+
+    template <class T>
+    constexpr std::uint64_t of_trivial() {
+        if constexpr (std::is_array_v<T>) {
+            return combine(combine(array, std::extent_v<T>), of_trivial<std::remove_extent_t<T>>());
+        }
+        else if constexpr (std::is_enum_v<T>) {
+            return combine(enumeration, of_trivial<std::underlying_type_t<T>>());
+        }
+        else if constexpr (std::is_arithmetic_v<T>) {
+            constexpr auto kind =
+                std::is_same_v<T, bool>     ? boolean  :
+                std::is_floating_point_v<T> ? floating :
+                std::is_signed_v<T>         ? signed_integer : unsigned_integer;
+            return combine(kind, sizeof(T));
+        }
+        else return of_std_array(type_tag<T>{});
+    }
+
+    template <class...Ts>
+    constexpr std::uint64_t of_members(type_tag<std::tuple<Ts...>>) {
+        std::uint64_t hash = combine(tuple_like, sizeof...(Ts));
+        ((hash = combine(hash, of<remove_cvref_t<Ts>>())), ...);
+        return hash;
+    }
+
+    template <class T>
+    constexpr std::uint64_t of() {
+        using concept_type = serial_concept_t<T>;
+        if constexpr (uses_concept_v<T, serial::concept::trivially_serializable>) {
+            return combine(trivial, of_trivial<T>());
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::trivial_array>) {
+            return combine(trivial_array, of<typename concept_type::value_type>());
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::xor_encoding>) {
+            return combine(xor_encoding, of<typename concept_type::value_type>());
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::delta_encoding>) {
+            auto const options = combine(concept_type::order, static_cast<std::uint64_t>(concept_type::packing));
+            return combine(combine(delta_encoding, options), of<typename concept_type::value_type>());
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::prefix_encoding>) {
+            return combine(combine(prefix_encoding, concept_type::interval), of<typename concept_type::value_type>());
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::dictionary_encoding>) {
+            return combine(dictionary_encoding, of<typename concept_type::value_type>());
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::adaptive_encoding>) {
+            return combine(adaptive_encoding, of<typename concept_type::value_type>());
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::run_length_encoding>) {
+            return combine(run_length_encoding, of<typename concept_type::value_type>());
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::frame_of_reference>) {
+            return combine(frame_of_reference, of<typename concept_type::value_type>());
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::optional>) {
+            return combine(optional, of<typename concept_type::value_type>());
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::tuple_like>) {
+            return of_members(type_tag<typename concept_type::tuple_type>{});
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::range>) {
+            return combine(range, of<typename concept_type::value_type>());
+        }
+        else static_assert(always_false_v<T>, "The serial concept of T has no fingerprint");
+    }
+
+} // ::detail::fingerprint
+
+template <class T>
+constexpr std::uint64_t fingerprint_v = detail::fingerprint::of<std::remove_cv_t<T>>();
+
+// Writes the fingerprint of T (8 bytes).
+template <class T, class Span>
+void write_fingerprint(Span& span) {
+    span.write_value(fingerprint_v<T>);
+}
+
+// Reads a fingerprint and compares it to the one of T.
+// On mismatch the span fails and false is returned.
+template <class T, class Span>
+bool check_fingerprint(Span& span) {
+    std::uint64_t fingerprint = 0;
+    span.read_value(fingerprint);
+    if (span.failed()) return false;
+    if (fingerprint == fingerprint_v<T>) return true;
+    span.fail("tapeworm : schema fingerprint mismatch");
+    return false;
+}
+
+} // ::tom
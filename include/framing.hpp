@@ -0,0 +1,145 @@
+
+#pragma once
+
+#include "crc32c.hpp"
+#include "serialization.hpp"
+#include <limits>
+
+/*
+    Frames protecting serialized messages against corruption.
+
+    Frame : the payload size as a 'length_type', the CRC32C of the payload (4 bytes), the payload.
+
+    The checksum is computed while the payload is written, on chunks of bytes which are still
+    in cache, instead of a second pass over the whole output. Bytes consumed with 'advance' may be
+    patched later (eg. the size written after a value) : the hashing stops before them until they
+    are released (see 'serial::detail::release'), then resumes.
+*/
+
+namespace tom {
+
+constexpr size_t frame_header_size = sizeof(length_type) + sizeof(std::uint32_t);
+
+// An output span computing the CRC32C of the bytes written through it.
+template <class Span>
+class crc32c_span : public Span {
+    static_assert(!Span::is_input, "Only output spans can be checksummed");
+public:
+    explicit crc32c_span(Span const& span) noexcept :
+        Span{ span }, hashed_{ span.begin() } {}
+
+    void write(void const* src, size_t size) {
+        Span::write(src, size);
+        stream();
+    }
+    template <class T>
+    void write_value(T const& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write(&value, sizeof(T));
+    }
+
+    // The bytes consumed may be patched until they are released, they are not hashed before.
+    // Nested reservations are released in reverse order.
+    std::byte* advance(size_t size) noexcept {
+        if (holds_++ == 0) held_ = this->begin();
+        return Span::advance(size);
+    }
+    void release() noexcept {
+        if (holds_ != 0 && --holds_ == 0) stream();
+    }
+
+    // The number of bytes written but not hashed yet.
+    size_t pending() const noexcept { return static_cast<size_t>(this->begin() - hashed_); }
+
+    // The CRC32C of all the bytes consumed so far.
+    std::uint32_t checksum() noexcept {
+        hash(this->begin());
+        return crc_;
+    }
+private:
+    // Small enough to stay in the L1 cache.
+    static constexpr size_t chunk_size = 4096;
+
+    // Hashes the final bytes once they fill a chunk.
+    void stream() noexcept {
+        auto const end = holds_ != 0 ? held_ : this->begin();
+        if (static_cast<size_t>(end - hashed_) >= chunk_size) hash(end);
+    }
+
+    void hash(std::byte const* end) noexcept {
+        crc_ = tom::crc32c(crc_, hashed_, static_cast<size_t>(end - hashed_));
+        hashed_ = end;
+    }
+
+    std::byte const* hashed_;
+    std::byte const* held_ = nullptr;
+    size_t holds_ = 0;
+    std::uint32_t crc_ = 0;
+};
+
+// Writes a frame whose payload is written by 'write_payload(crc32c_span<Span>&)'.
+template <class Span, class F>
+void write_frame(Span& span, F&& write_payload) {
+    static_assert(!Span::is_input, "Can't write a frame in an input span");
+    if (!span.check(frame_header_size)) return;
+    auto const header = span.advance(frame_header_size);
+
+    crc32c_span<Span> payload{ span };
+    write_payload(payload);
+    if (payload.failed()) {
+        span.fail("tapeworm : invalid frame payload");
+        return;
+    }
+    auto const size = static_cast<size_t>(payload.begin() - span.begin());
+    if (size > std::numeric_limits<length_type>::max()) {
+        span.fail("tapeworm : frame payload too large");
+        return;
+    }
+    auto const length = static_cast<length_type>(size);
+    auto const crc = payload.checksum();
+    std::memcpy(header, &length, sizeof(length));
+    std::memcpy(header + sizeof(length), &crc, sizeof(crc));
+    span.advance(size);
+}
+
+// Reads a frame and checks it's payload, then sets 'payload' to a span on it, with the limits of 'span' if any.
+// On failure the span fails and false is returned.
+template <class Span>
+bool read_frame(Span& span, Span& payload) {
+    length_type length = 0;
+    std::uint32_t crc = 0;
+    span.read_value(length);
+    span.read_value(crc);
+    if (span.failed() || !span.check(length)) return false;
+
+    auto const data = span.advance(length);
+    if (tom::crc32c(0, data, length) != crc) {
+        span.fail("tapeworm : frame checksum mismatch");
+        return false;
+    }
+    payload = serial::detail::sub_span(span, data, length);
+    return true;
+}
+
+// The number of bytes written by 'serialize_framed'.
+template <class T>
+size_t framed_size(T const& value) {
+    return frame_header_size + tom::serialized_size(value);
+}
+
+template <class Span, class T>
+void serialize_framed(Span& span, T const& value) {
+    tom::write_frame(span, [&] (auto& payload) { tom::serialize(payload, value); });
+}
+
+// The payload must hold exactly one T.
+template <class Span, class T>
+void deserialize_framed(Span& span, T& value) {
+    Span payload;
+    if (!tom::read_frame(span, payload)) return;
+    tom::deserialize(payload, value);
+    if (payload.failed() || payload.size() != 0) span.fail("tapeworm : invalid frame payload");
+    else serial::detail::join_sub_span(span, payload);
+}
+
+} // ::tom
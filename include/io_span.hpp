@@ -0,0 +1,159 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace tom {
+
+// What an io span does when a size check fails.
+enum class span_policy {
+    unsafe,   // No size checks are performed.
+    throwing, // A 'serialization_error' is thrown.
+    error,    // A flag is set, the faulty operation is dropped.
+    monadic   // Same as error, but once the flag is set every operation is dropped.
+};
+
+// Thrown by io spans with the 'throwing' policy.
+struct serialization_error : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// A view on a non-owned buffer which is consumed by the front.
+// 'Byte' is 'std::byte' for output spans and 'std::byte const' for input spans.
+template <class Byte, span_policy Policy>
+class basic_io_span {
+    static_assert(std::is_same_v<std::remove_const_t<Byte>, std::byte>);
+public:
+    static constexpr auto policy = Policy;
+    static constexpr bool is_input = std::is_const_v<Byte>;
+
+    using byte_type = Byte;
+
+    constexpr basic_io_span() noexcept = default;
+    constexpr basic_io_span(Byte* begin, Byte* end) noexcept :
+        begin_{ begin }, end_{ end } {}
+    constexpr basic_io_span(Byte* data, size_t size) noexcept :
+        begin_{ data }, end_{ data + size } {}
+
+    // Allows to build an input span from an output span.
+    template <span_policy OtherPolicy, class B = Byte, class = std::enable_if_t<std::is_const_v<B>>>
+    constexpr basic_io_span(basic_io_span<std::byte, OtherPolicy> const& span) noexcept :
+        begin_{ span.begin() }, end_{ span.end() } {}
+
+    constexpr Byte* begin() const noexcept { return begin_; }
+    constexpr Byte* end()   const noexcept { return end_; }
+
+    // The number of bytes remaining.
+    constexpr size_t size() const noexcept {
+        return static_cast<size_t>(end_ - begin_);
+    }
+
+    // Always false with the 'unsafe' and 'throwing' policies.
+    constexpr bool failed() const noexcept {
+        if constexpr (has_flag) return failed_;
+        else return false;
+    }
+
+    // Signals an invalid operation (eg. corrupted data) following the policy.
+    void fail(char const* what = "tapeworm : invalid span operation") {
+        if constexpr (Policy == span_policy::throwing) {
+            throw serialization_error{ what };
+        }
+        else if constexpr (has_flag) {
+            failed_ = true;
+        }
+    }
+
+    // Returns true if 'size' bytes can be consumed, otherwise applies the policy.
+    bool check(size_t size) {
+        if constexpr (Policy == span_policy::unsafe) {
+            return true;
+        }
+        else {
+            if constexpr (Policy == span_policy::monadic) {
+                if (failed_) return false;
+            }
+            if (size <= this->size()) return true;
+            fail("tapeworm : not enough space in span");
+            return false;
+        }
+    }
+
+    // Consumes 'size' bytes without any check and returns their address.
+    constexpr Byte* advance(size_t size) noexcept {
+        auto const ptr = begin_;
+        begin_ += size;
+        return ptr;
+    }
+
+    void write(void const* src, size_t size) {
+        static_assert(!is_input, "Can't write in an input span");
+        if (check(size)) std::memcpy(advance(size), src, size);
+    }
+    void read(void* dst, size_t size) {
+        if (check(size)) std::memcpy(dst, advance(size), size);
+    }
+
+    template <class T>
+    void write_value(T const& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write(&value, sizeof(T));
+    }
+    template <class T>
+    void read_value(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        read(&value, sizeof(T));
+    }
+private:
+    static constexpr bool has_flag =
+        Policy == span_policy::error ||
+        Policy == span_policy::monadic;
+
+    struct no_flag {
+        constexpr no_flag& operator=(bool) noexcept { return *this; }
+    };
+
+    Byte* begin_ = nullptr;
+    Byte* end_   = nullptr;
+    [[maybe_unused]] std::conditional_t<has_flag, bool, no_flag> failed_{};
+};
+
+template <span_policy Policy = span_policy::throwing>
+using output_span = basic_io_span<std::byte, Policy>;
+
+template <span_policy Policy = span_policy::throwing>
+using input_span = basic_io_span<std::byte const, Policy>;
+
+// An output span which only counts the bytes written.
+// Used to compute the size of an encoding by running it.
+class counting_span {
+public:
+    static constexpr auto policy = span_policy::unsafe;
+    static constexpr bool is_input = false;
+
+    using byte_type = std::byte;
+
+    constexpr size_t count() const noexcept { return count_; }
+
+    constexpr bool failed() const noexcept { return false; }
+    constexpr void fail(char const* = nullptr) noexcept {}
+    constexpr bool check(size_t) const noexcept { return true; }
+
+    constexpr void write(void const*, size_t size) noexcept { count_ += size; }
+
+    template <class T>
+    constexpr void write_value(T const&) noexcept { count_ += sizeof(T); }
+private:
+    size_t count_ = 0;
+};
+
+template <class T>
+constexpr bool is_io_span_v = false;
+
+template <class Byte, span_policy Policy>
+constexpr bool is_io_span_v<basic_io_span<Byte, Policy>> = true;
+
+} // ::tom
@@ -0,0 +1,263 @@
+
+#pragma once
+
+#include "serialization.hpp"
+#include <cstring>
+#include <type_traits>
+
+/*
+    Order-preserving encoding of keys : comparing two encoded keys with memcmp gives the
+    lexicographic order of the values, as in the key encodings of FoundationDB or CockroachDB.
+    Keys can then be sorted, merged and searched without being decoded.
+
+    Wire format, following the serial concept of each value :
+        - bool, unsigned integers and enums of unsigned types : big-endian.
+        - signed integers : big-endian, with the sign bit flipped.
+        - floating points : big-endian, with the sign bit flipped if positive, all the bits if negative.
+          -0.0 sorts before 0.0 and NaNs sort outside of the infinities.
+        - T[N] and std::array<T, N> : the elements one after another.
+        - strings (contiguous chars) : the bytes, 0x00 being escaped as 0x00 0xFF, then 0x00 0x01.
+        - other ranges : each element preceded by 0x01, then 0x00.
+        - optional : 0x00 if empty, otherwise 0x01 followed by the value.
+        - tuple_like : the elements one after another.
+*/
+
+namespace tom {
+
+namespace detail::key {
+
+    constexpr std::uint8_t escape     = 0x00;
+    constexpr std::uint8_t escaped    = 0xFF;
+    constexpr std::uint8_t terminator = 0x01;
+
+    constexpr std::uint8_t absent  = 0x00;
+    constexpr std::uint8_t present = 0x01;
+
+    template <size_t Size>
+    struct unsigned_of_size;
+
+    template <> struct unsigned_of_size<1> { using type = std::uint8_t;  };
+    template <> struct unsigned_of_size<2> { using type = std::uint16_t; };
+    template <> struct unsigned_of_size<4> { using type = std::uint32_t; };
+    template <> struct unsigned_of_size<8> { using type = std::uint64_t; };
+
+    template <class T>
+    using bits_t = typename unsigned_of_size<sizeof(T)>::type;
+
+    template <class T>
+    constexpr bool is_scalar_v = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+    // The bits of a scalar, ordered as unsigned integers.
+    template <class T>
+    bits_t<T> to_ordered(T value) noexcept {
+        using U = bits_t<T>;
+        constexpr auto sign = static_cast<U>(U{ 1 } << (8 * sizeof(T) - 1));
+        if constexpr (std::is_enum_v<T>) {
+            return to_ordered(static_cast<std::underlying_type_t<T>>(value));
+        }
+        else if constexpr (std::is_floating_point_v<T>) {
+            U bits;
+            std::memcpy(&bits, &value, sizeof(T));
+            return static_cast<U>(bits & sign ? ~bits : bits ^ sign);
+        }
+        else if constexpr (std::is_signed_v<T>) {
+            return static_cast<U>(static_cast<U>(value) ^ sign);
+        }
+        else return static_cast<U>(value);
+    }
+
+    template <class T>
+    T from_ordered(bits_t<T> bits) noexcept {
+        using U = bits_t<T>;
+        constexpr auto sign = static_cast<U>(U{ 1 } << (8 * sizeof(T) - 1));
+        if constexpr (std::is_enum_v<T>) {
+            return static_cast<T>(from_ordered<std::underlying_type_t<T>>(bits));
+        }
+        else if constexpr (std::is_floating_point_v<T>) {
+            bits = static_cast<U>(bits & sign ? bits ^ sign : ~bits);
+            T value;
+            std::memcpy(&value, &bits, sizeof(T));
+            return value;
+        }
+        else if constexpr (std::is_same_v<T, bool>) {
+            return bits != 0;
+        }
+        else return static_cast<T>(static_cast<U>(bits ^ (std::is_signed_v<T> ? sign : 0)));
+    }
+
+    template <class Span, class T>
+    void write_key(Span& span, T const& value);
+
+    template <class Span, class T>
+    void read_key(Span& span, T& value);
+
+    template <class Span, class T>
+    void write_scalar(Span& span, T value) {
+        auto const bits = to_ordered(value);
+        std::uint8_t bytes[sizeof(T)];
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            bytes[i] = static_cast<std::uint8_t>(bits >> 8 * (sizeof(T) - 1 - i));
+        }
+        span.write(bytes, sizeof(T));
+    }
+
+    template <class Span, class T>
+    void read_scalar(Span& span, T& value) {
+        std::uint8_t bytes[sizeof(T)];
+        span.read(bytes, sizeof(T));
+        if (span.failed()) return;
+        bits_t<T> bits = 0;
+        for (size_t i = 0; i < sizeof(T); ++i) bits = static_cast<bits_t<T>>(bits << 8 | bytes[i]);
+        if constexpr (std::is_same_v<T, bool>) {
+            if (bits > 1) {
+                span.fail("tapeworm : invalid bool");
+                return;
+            }
+        }
+        value = from_ordered<T>(bits);
+    }
+
+    // Strings are written by runs of bytes between the zeros.
+    template <class Span>
+    void write_string(Span& span, char const* data, size_t size) {
+        std::uint8_t const escape_bytes[] = { escape, escaped };
+        while (size != 0) {
+            auto const zero = static_cast<char const*>(std::memchr(data, 0, size));
+            auto const run = zero ? static_cast<size_t>(zero - data) : size;
+            span.write(data, run);
+            if (!zero) break;
+            span.write(escape_bytes, 2);
+            data += run + 1;
+            size -= run + 1;
+        }
+        std::uint8_t const end[] = { escape, terminator };
+        span.write(end, 2);
+    }
+
+    template <class Span, class T>
+    void read_string(Span& span, T& string) {
+        string.resize(0);
+        for (;;) {
+            auto const begin = reinterpret_cast<char const*>(span.begin());
+            auto const zero = span.size() < 2 ? nullptr :
+                static_cast<char const*>(std::memchr(begin, 0, span.size() - 1));
+            if (!zero) {
+                span.fail("tapeworm : unterminated key string");
+                return;
+            }
+            auto const run = static_cast<size_t>(zero - begin);
+            auto const size = std::size(string);
+            auto const marker = static_cast<std::uint8_t>(zero[1]);
+            if (marker != escaped && marker != terminator) {
+                span.fail("tapeworm : invalid key string escape");
+                return;
+            }
+            string.resize(size + run + (marker == escaped));
+            if (run != 0) std::memcpy(std::data(string) + size, begin, run);
+            span.advance(run + 2);
+            if (marker == terminator) return;
+            std::data(string)[size + run] = 0;
+        }
+    }
+
+    template <class Span, class T>
+    void write_key(Span& span, T const& value) {
+        if constexpr (is_scalar_v<T>) {
+            write_scalar(span, value);
+        }
+        else if constexpr (is_trivially_serializable_v<T>) {
+            for (auto const& element : value) write_key(span, element);
+        }
+        else if constexpr (serial::detail::is_string_like_v<T>) {
+            write_string(span, std::data(value), std::size(value));
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::optional>) {
+            span.write_value(value ? present : absent);
+            if (value) write_key(span, *value);
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::tuple_like>) {
+            using tuple_concept = typename serial_concept_t<T>::tuple_concept;
+            std::apply([&] (auto const&...members) {
+                (write_key(span, members), ...);
+            }, tuple_concept::as_tuple(value));
+        }
+        else {
+            for (auto const& element : value) {
+                span.write_value(present);
+                write_key(span, element);
+            }
+            span.write_value(absent);
+        }
+    }
+
+    template <class Span, class T>
+    void read_key(Span& span, T& value) {
+        if constexpr (is_scalar_v<T>) {
+            read_scalar(span, value);
+        }
+        else if constexpr (is_trivially_serializable_v<T>) {
+            for (auto& element : value) read_key(span, element);
+        }
+        else if constexpr (serial::detail::is_string_like_v<T>) {
+            read_string(span, value);
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::optional>) {
+            std::uint8_t marker = 0;
+            span.read_value(marker);
+            if (span.failed()) return;
+            if (marker == present) {
+                read_key(span, serial::detail::emplace_value(value));
+            }
+            else if (marker == absent) {
+                value = T{};
+            }
+            else span.fail("tapeworm : invalid key marker");
+        }
+        else if constexpr (uses_concept_v<T, serial::concept::tuple_like>) {
+            using tuple_concept = typename serial_concept_t<T>::tuple_concept;
+            std::apply([&] (auto&...members) {
+                (read_key(span, members), ...);
+            }, tuple_concept::as_tuple(value));
+        }
+        else {
+            using value_type = serial::detail::range_value_t<T>;
+            value.clear();
+            for (;;) {
+                std::uint8_t marker = 0;
+                span.read_value(marker);
+                if (span.failed() || marker == absent) return;
+                if (marker != present) {
+                    span.fail("tapeworm : invalid key marker");
+                    return;
+                }
+                value_type element{};
+                read_key(span, element);
+                if (span.failed()) return;
+                value.insert(std::end(value), std::move(element));
+            }
+        }
+    }
+
+} // ::detail::key
+
+// Serializes a value such that the order of the bytes is the order of the values.
+template <class Span, class T>
+void serialize_key(Span& span, T const& value) {
+    detail::key::write_key(span, value);
+}
+
+// The number of bytes written by 'serialize_key'.
+template <class T>
+size_t serialized_key_size(T const& value) {
+    counting_span span;
+    tom::serialize_key(span, value);
+    return span.count();
+}
+
+// Deserializes a value written by 'serialize_key'.
+template <class Span, class T>
+void deserialize_key(Span& span, T& value) {
+    detail::key::read_key(span, value);
+}
+
+} // ::tom
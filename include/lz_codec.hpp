@@ -0,0 +1,174 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*
+    A fast LZ77 compressor in the spirit of LZ4, made for blocks of up to a few MB.
+
+    Compressed block : a list of sequences, each made of
+        - a token : the number of literals (4 high bits) and the match length - 4 (4 low bits).
+          A nibble equal to 15 is followed by bytes added to it, up to a byte lower than 255.
+        - the literals.
+        - the match offset (2 bytes) and the match length, except for the last sequence.
+    The last sequence only holds literals, and matches end 'last_literals' bytes before the end.
+*/
+
+namespace tom {
+
+namespace detail::lz {
+
+    constexpr int    hash_bits     = 12;
+    constexpr size_t min_match     = 4;
+    constexpr size_t last_literals = 5;
+    constexpr size_t match_limit   = 12; // No match starts in the last bytes.
+    constexpr size_t max_offset    = 65535;
+
+    inline std::uint32_t load32(std::uint8_t const* ptr) noexcept {
+        std::uint32_t value;
+        std::memcpy(&value, ptr, 4);
+        return value;
+    }
+
+    inline std::uint32_t hash(std::uint32_t sequence) noexcept {
+        return (sequence * 2654435761u) >> (32 - hash_bits);
+    }
+
+    // The number of bytes used by a length whose nibble is full.
+    constexpr size_t extra_bytes(size_t length) noexcept {
+        return length < 15 ? 0 : (length - 15) / 255 + 1;
+    }
+
+    inline std::uint8_t* write_length(std::uint8_t* op, size_t length) noexcept {
+        for (length -= 15; length >= 255; length -= 255) *op++ = 255;
+        *op++ = static_cast<std::uint8_t>(length);
+        return op;
+    }
+
+    // Returns false if the length is cut or exceeds 'max'.
+    inline bool read_length(std::uint8_t const*& ip, std::uint8_t const* end, size_t& length, size_t max) noexcept {
+        std::uint8_t byte;
+        do {
+            if (ip == end) return false;
+            byte = *ip++;
+            length += byte;
+            if (length > max) return false;
+        } while (byte == 255);
+        return true;
+    }
+
+    // Writes a sequence, returns nullptr if it doesn't fit before 'end'.
+    inline std::uint8_t* write_sequence(std::uint8_t* op, std::uint8_t* end,
+        std::uint8_t const* literals, size_t literal_length, size_t offset, size_t match_length) noexcept
+    {
+        auto const has_match = match_length != 0;
+        auto const match_code = has_match ? match_length - min_match : 0;
+        auto const size = 1 + extra_bytes(literal_length) + literal_length +
+            (has_match ? 2 + extra_bytes(match_code) : 0);
+        if (size > static_cast<size_t>(end - op)) return nullptr;
+
+        auto const token = op++;
+        *token = static_cast<std::uint8_t>((literal_length < 15 ? literal_length : 15) << 4);
+        if (literal_length >= 15) op = write_length(op, literal_length);
+        if (literal_length != 0) std::memcpy(op, literals, literal_length);
+        op += literal_length;
+        if (has_match) {
+            *token |= static_cast<std::uint8_t>(match_code < 15 ? match_code : 15);
+            *op++ = static_cast<std::uint8_t>(offset);
+            *op++ = static_cast<std::uint8_t>(offset >> 8);
+            if (match_code >= 15) op = write_length(op, match_code);
+        }
+        return op;
+    }
+
+} // ::detail::lz
+
+// The built-in codec of the block compression stage (see block_compression.hpp).
+struct lz_codec {
+    // A match takes at least 3 bytes, each extra byte of it's length adds up to 255 bytes.
+    static constexpr size_t max_expansion = 255;
+
+    // Compresses 'size' bytes in at most 'capacity' bytes.
+    // Returns the compressed size, or 0 if it doesn't fit.
+    static size_t compress(std::byte const* src, size_t size, std::byte* dst, size_t capacity) noexcept {
+        using namespace detail::lz;
+        auto const in  = reinterpret_cast<std::uint8_t const*>(src);
+        auto const out = reinterpret_cast<std::uint8_t*>(dst);
+        auto const out_end = out + capacity;
+        auto op = out;
+
+        size_t anchor = 0;
+        if (size > match_limit) {
+            std::uint32_t table[1 << hash_bits] = {};
+            auto const limit = size - match_limit;
+            size_t ip = 1;
+            while (ip < limit) {
+                auto const sequence = load32(in + ip);
+                auto& slot = table[hash(sequence)];
+                size_t candidate = slot;
+                slot = static_cast<std::uint32_t>(ip);
+
+                if (ip - candidate > max_offset || load32(in + candidate) != sequence) {
+                    // Skips faster in incompressible data.
+                    ip += 1 + ((ip - anchor) >> 6);
+                    continue;
+                }
+                while (ip > anchor && candidate > 0 && in[ip - 1] == in[candidate - 1]) {
+                    --ip;
+                    --candidate;
+                }
+                auto length = min_match;
+                auto const match_end = size - last_literals;
+                while (ip + length < match_end && in[candidate + length] == in[ip + length]) ++length;
+
+                op = write_sequence(op, out_end, in + anchor, ip - anchor, ip - candidate, length);
+                if (!op) return 0;
+                ip += length;
+                anchor = ip;
+                if (ip < limit) table[hash(load32(in + ip - 2))] = static_cast<std::uint32_t>(ip - 2);
+            }
+        }
+        op = write_sequence(op, out_end, in + anchor, size - anchor, 0, 0);
+        return op ? static_cast<size_t>(op - out) : 0;
+    }
+
+    // Decompresses exactly 'dst_size' bytes, returns false if the input is corrupted.
+    static bool decompress(std::byte const* src, size_t size, std::byte* dst, size_t dst_size) noexcept {
+        using namespace detail::lz;
+        auto ip = reinterpret_cast<std::uint8_t const*>(src);
+        auto const in_end = ip + size;
+        auto const out = reinterpret_cast<std::uint8_t*>(dst);
+        size_t op = 0;
+
+        while (ip != in_end) {
+            auto const token = *ip++;
+            size_t literals = token >> 4;
+            if (literals == 15 && !read_length(ip, in_end, literals, dst_size)) return false;
+            if (literals > static_cast<size_t>(in_end - ip) || literals > dst_size - op) return false;
+            if (literals != 0) std::memcpy(out + op, ip, literals);
+            ip += literals;
+            op += literals;
+            if (ip == in_end) break;
+
+            if (in_end - ip < 2) return false;
+            size_t const offset = ip[0] | ip[1] << 8;
+            ip += 2;
+            size_t length = token & 15;
+            if (length == 15 && !read_length(ip, in_end, length, dst_size)) return false;
+            length += min_match;
+            if (offset == 0 || offset > op || length > dst_size - op) return false;
+
+            auto const match = out + op - offset;
+            if (offset >= length) {
+                std::memcpy(out + op, match, length);
+            }
+            else for (size_t i = 0; i < length; ++i) out[op + i] = match[i];
+            op += length;
+        }
+        return op == dst_size;
+    }
+};
+
+} // ::tom
@@ -0,0 +1,108 @@
+
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define TAPEWORM_MMAP
+#else
+    #include <fstream>
+    #include <vector>
+#endif
+
+namespace tom {
+
+// A read-only file mapped in memory : the pages are loaded by the OS as they are read.
+// Where mmap is not available, the file is read in a buffer.
+class mapped_file {
+public:
+    mapped_file() = default;
+
+    // Throws a 'std::system_error' if the file can't be mapped.
+    explicit mapped_file(std::string const& path) {
+    #ifdef TAPEWORM_MMAP
+        auto const fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) fail(path);
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            auto const error = errno;
+            ::close(fd);
+            fail(path, error);
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        if (size_ != 0) {
+            auto const data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                auto const error = errno;
+                ::close(fd);
+                fail(path, error);
+            }
+            data_ = static_cast<std::byte const*>(data);
+        }
+        ::close(fd);
+    #else
+        std::ifstream file{ path, std::ios::binary | std::ios::ate };
+        if (!file) fail(path, ENOENT);
+        buffer_.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+        if (!file) fail(path, EIO);
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+    #endif
+    }
+    ~mapped_file() { unmap(); }
+
+    mapped_file(mapped_file&& other) noexcept { swap(other); }
+    mapped_file& operator=(mapped_file&& other) noexcept {
+        mapped_file moved{ std::move(other) };
+        swap(moved);
+        return *this;
+    }
+
+    std::byte const* data() const noexcept { return data_; }
+    size_t size() const noexcept { return size_; }
+
+    // Tells the OS that the pages will be read in random order (eg. point lookups).
+    void advise_random() const noexcept {
+    #ifdef TAPEWORM_MMAP
+        if (data_) ::madvise(const_cast<std::byte*>(data_), size_, MADV_RANDOM);
+    #endif
+    }
+private:
+    [[noreturn]] static void fail(std::string const& path, int error = errno) {
+        throw std::system_error{ error, std::generic_category(), "tapeworm : can't map " + path };
+    }
+
+    void unmap() noexcept {
+    #ifdef TAPEWORM_MMAP
+        if (data_) ::munmap(const_cast<std::byte*>(data_), size_);
+    #endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    void swap(mapped_file& other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+    #ifndef TAPEWORM_MMAP
+        buffer_.swap(other.buffer_);
+    #endif
+    }
+
+    std::byte const* data_ = nullptr;
+    size_t size_ = 0;
+#ifndef TAPEWORM_MMAP
+    std::vector<std::byte> buffer_;
+#endif
+};
+
+} // ::tom
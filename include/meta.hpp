@@ -1,6 +1,8 @@
 
 #pragma once
 
+#include <cstddef>
+#include <type_traits>
 #include <utility>
 
 namespace tom {
@@ -45,6 +47,20 @@ constexpr decltype(auto) move(T&& value) noexcept {
     return static_cast<value_type&&>(value);
 }
 
+// Calls f with std::integral_constant<size_t, I> for each I in [0, N).
+
+namespace detail {
+    template <class F, size_t...Is>
+    constexpr void for_each_index(F&& f, std::index_sequence<Is...>) {
+        (f(std::integral_constant<size_t, Is>{}), ...);
+    }
+} // ::detail
+
+template <size_t N, class F>
+constexpr void for_each_index(F&& f) {
+    detail::for_each_index(f, std::make_index_sequence<N>{});
+}
+
 // Removes const of the value type.
 // Applied to a list of types, removes const on each type.
 // Used to construct pairs or tuples with const values.
@@ -60,7 +76,7 @@ template <class T>
 struct remove_deep_const<T const> {
     using type = T;
 };
-template <template <class...> List, class...Ts>
+template <template <class...> class List, class...Ts>
 struct remove_deep_const<List<Ts...>> {
     using type = List<remove_deep_const_t<Ts>...>;
 };
@@ -0,0 +1,241 @@
+
+#pragma once
+
+#include "block_compression.hpp"
+#include "thread_pool.hpp"
+#include <atomic>
+#include <memory>
+
+/*
+    The block compression stage (see block_compression.hpp) spread on a thread pool,
+    producing the same bytes as the single-threaded one.
+
+    Compression : the workers compress the blocks in a window of slots, while the calling
+    thread writes the compressed blocks in order and gives the freed slots back to the workers.
+    'serialize_compressed' hands each block to the workers as soon as the serializer is past it,
+    so that the serialization, the compression and the writes overlap.
+    Decompression : the block headers are read first, then each block is decompressed
+    in parallel at it's place in the output.
+*/
+
+namespace tom {
+
+namespace detail::parallel {
+
+    // Jobs submitted to a pool, waited for before leaving the scope (even on exceptions).
+    class job_group {
+    public:
+        job_group() = default;
+        job_group(job_group const&) = delete;
+        job_group& operator=(job_group const&) = delete;
+
+        ~job_group() { wait_until([this] { return pending_ == 0; }); }
+
+        template <class F>
+        void run(thread_pool& pool, F job) {
+            {
+                std::lock_guard<std::mutex> lock{ mutex_ };
+                ++pending_;
+            }
+            pool.submit([this, job = std::move(job)] () mutable {
+                job();
+                // Notified under the lock : the group may be destroyed as soon as it is released.
+                std::lock_guard<std::mutex> lock{ mutex_ };
+                --pending_;
+                condition_.notify_all();
+            });
+        }
+
+        // Blocks until 'ready()' is true, it is checked each time a job ends.
+        template <class F>
+        void wait_until(F&& ready) {
+            std::unique_lock<std::mutex> lock{ mutex_ };
+            condition_.wait(lock, std::forward<F>(ready));
+        }
+    private:
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        size_t pending_ = 0;
+    };
+
+    // A compressed block waiting to be written.
+    struct slot {
+        std::vector<std::byte> bytes;
+        size_t size = 0;
+        std::atomic<bool> ready{ false };
+    };
+
+    // Compresses the blocks of 'size' bytes on the pool as they are made 'available', and writes them
+    // in order in the span from the calling thread, through a window of slots (the reorder buffer).
+    template <class Codec, class Span>
+    class block_pipeline {
+    public:
+        block_pipeline(thread_pool& pool, Span& span, std::byte const* data, size_t size, size_t block_size) :
+            pool_{ pool }, span_{ span }, data_{ data }, size_{ size }, block_size_{ block_size },
+            count_{ (size + block_size - 1) / block_size },
+            // Enough slots to keep the workers busy while a block is written.
+            window_{ std::min(count_, 2 * pool.size()) },
+            slots_{ std::make_unique<slot[]>(window_) } {}
+
+        // The bytes before 'end' are final : the blocks they fill are compressed.
+        void available(std::byte const* end) {
+            auto const ready = end == data_ + size_ ? count_ : static_cast<size_t>(end - data_) / block_size_;
+            while (submitted_ < ready && !span_.failed()) {
+                if (submitted_ - written_ == window_) write_next();
+                else submit();
+            }
+            // The blocks already compressed are written without waiting.
+            while (written_ < submitted_ && slots_[written_ % window_].ready && !span_.failed()) write_next();
+        }
+
+        // Compresses and writes the remaining blocks.
+        void finish() {
+            available(data_ + size_);
+            while (written_ < submitted_ && !span_.failed()) write_next();
+        }
+    private:
+        void submit() {
+            auto& slot = slots_[submitted_ % window_];
+            auto const first = submitted_++ * block_size_;
+            auto const length = std::min(block_size_, size_ - first);
+            group_.run(pool_, [&slot, block = data_ + first, length] {
+                slot.bytes.resize(sizeof(length_type) + length);
+                slot.size = blocks::write_block<Codec>(block, length, slot.bytes.data(), slot.bytes.size());
+                slot.ready = true;
+            });
+        }
+
+        void write_next() {
+            auto& slot = slots_[written_++ % window_];
+            group_.wait_until([&slot] { return slot.ready.load(); });
+            slot.ready = false;
+            span_.write(slot.bytes.data(), slot.size);
+        }
+
+        thread_pool& pool_;
+        Span& span_;
+        std::byte const* data_;
+        size_t size_, block_size_, count_, window_;
+        size_t submitted_ = 0, written_ = 0;
+        std::unique_ptr<slot[]> slots_;
+        // Declared after the slots, so that the jobs end before the slots are destroyed.
+        job_group group_;
+    };
+
+    // The span a value is serialized in, handing the blocks to a pipeline as soon as the serializer is past them.
+    // Like a crc32c_span, the bytes consumed by 'advance' may be patched until they are released, so they are
+    // held back until then. The serialized value stays in one buffer, as the patches are made through pointers.
+    template <class Pipeline>
+    class block_span : public output_span<span_policy::unsafe> {
+        using base = output_span<span_policy::unsafe>;
+    public:
+        block_span(std::byte* data, size_t size, size_t block_size, Pipeline& pipeline) noexcept :
+            base{ data, size }, pipeline_{ pipeline }, data_{ data }, block_size_{ block_size }, next_{ block_size } {}
+
+        void write(void const* src, size_t size) {
+            base::write(src, size);
+            stream();
+        }
+        template <class T>
+        void write_value(T const& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            write(&value, sizeof(T));
+        }
+
+        std::byte* advance(size_t size) noexcept {
+            if (holds_++ == 0) held_ = this->begin();
+            return base::advance(size);
+        }
+        void release() {
+            if (holds_ != 0 && --holds_ == 0) stream();
+        }
+    private:
+        // Calls the pipeline once the end of a block is reached.
+        void stream() {
+            auto const end = holds_ != 0 ? held_ : this->begin();
+            auto const offset = static_cast<size_t>(end - data_);
+            if (offset < next_) return;
+            pipeline_.available(end);
+            next_ = (offset / block_size_ + 1) * block_size_;
+        }
+
+        Pipeline& pipeline_;
+        std::byte const* data_;
+        size_t block_size_;
+        size_t next_;  // The offset of the end of the block being filled.
+        std::byte* held_ = nullptr;
+        size_t holds_ = 0;
+    };
+
+} // ::detail::parallel
+
+// Compresses 'size' bytes by blocks of 'block_size' bytes on the pool.
+template <class Codec = lz_codec, class Span>
+void compress_blocks(thread_pool& pool, Span& span, void const* data, size_t size, size_t block_size = default_block_size) {
+    static_assert(!Span::is_input, "Can't compress in an input span");
+    if (!detail::blocks::write_header(span, size, block_size) || size == 0) return;
+    detail::parallel::block_pipeline<Codec, Span> pipeline{ pool, span, static_cast<std::byte const*>(data), size, block_size };
+    pipeline.finish();
+}
+
+// Decompresses the blocks in an output span, on the pool.
+template <class Codec = lz_codec, class Span, class Out>
+void decompress_blocks(thread_pool& pool, Span& span, Out& out) {
+    static_assert(!Out::is_input, "Can't decompress in an input span");
+    using namespace detail::blocks;
+    header header;
+    if (!read_header(span, header)) return;
+    if (!out.check(header.size)) return;
+
+    std::vector<block> blocks;
+    for (size_t i = 0, count = header.block_count(); i < count; ++i) {
+        block block;
+        if (!read_block<Codec>(span, header, i, block)) return;
+        blocks.push_back(block);
+    }
+
+    auto const dst = out.begin();
+    std::atomic<bool> corrupted{ false };
+    {
+        detail::parallel::job_group group;
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            group.run(pool, [&, i] {
+                auto const& block = blocks[i];
+                auto const target = dst + i * header.block_size;
+                auto const size = header.raw_size(i);
+                if (block.stored) {
+                    std::memcpy(target, block.data, size);
+                }
+                else if (!Codec::decompress(block.data, block.size, target, size)) corrupted = true;
+            });
+        }
+    }
+    if (corrupted) {
+        span.fail("tapeworm : corrupted block");
+        return;
+    }
+    out.advance(header.size);
+}
+
+// Serializes a value while it's blocks are compressed on the pool and written.
+template <class Codec = lz_codec, class Span, class T>
+void serialize_compressed(thread_pool& pool, Span& span, T const& value, size_t block_size = default_block_size) {
+    static_assert(!Span::is_input, "Can't compress in an input span");
+    std::vector<std::byte> buffer(tom::serialized_size(value));
+    if (!detail::blocks::write_header(span, buffer.size(), block_size) || buffer.empty()) return;
+    using pipeline_type = detail::parallel::block_pipeline<Codec, Span>;
+    pipeline_type pipeline{ pool, span, buffer.data(), buffer.size(), block_size };
+    detail::parallel::block_span<pipeline_type> serial{ buffer.data(), buffer.size(), block_size, pipeline };
+    tom::serialize(serial, value);
+    pipeline.finish();
+}
+
+// Decompresses a value on the pool, which must be alone in the blocks.
+template <class Codec = lz_codec, class Span, class T>
+void deserialize_compressed(thread_pool& pool, Span& span, T& value) {
+    detail::blocks::deserialize_value<Codec>(span, value, [&pool] (Span& span, auto& out) {
+        tom::decompress_blocks<Codec>(pool, span, out);
+    });
+}
+
+} // ::tom
@@ -0,0 +1,78 @@
+
+#pragma once
+
+#include "io_span.hpp"
+#include "varint.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*
+    Kernels of the prefix encoding (front coding) of strings.
+
+    Each entry is the size of the prefix it shares with the previous string (varint),
+    the size of the rest (varint), then the rest. Every 'interval' entries, a restart entry
+    shares nothing, so that it can be read without the previous ones.
+*/
+
+namespace tom {
+
+namespace detail::prefix {
+
+    // The number of restart entries of 'count' strings.
+    constexpr size_t restart_count(size_t count, size_t interval) noexcept {
+        return (count + interval - 1) / interval;
+    }
+
+    // The size of the prefix shared by two strings, compared by words of 8 bytes.
+    inline size_t shared_prefix(char const* lhs, size_t lhs_size, char const* rhs, size_t rhs_size) noexcept {
+        auto const size = lhs_size < rhs_size ? lhs_size : rhs_size;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            std::uint64_t a, b;
+            std::memcpy(&a, lhs + i, 8);
+            std::memcpy(&b, rhs + i, 8);
+            if (a != b) break;
+        }
+        while (i < size && lhs[i] == rhs[i]) ++i;
+        return i;
+    }
+
+    template <class Span>
+    void write_entry(Span& span, size_t shared, char const* data, size_t size) {
+        write_varint(span, shared);
+        write_varint(span, size - shared);
+        span.write(data + shared, size - shared);
+    }
+
+    inline size_t entry_size(size_t shared, size_t size) noexcept {
+        return varint_size(shared) + varint_size(size - shared) + size - shared;
+    }
+
+    struct entry {
+        size_t shared = 0;
+        size_t size = 0; // Of the rest.
+        char const* rest = nullptr;
+    };
+
+    // Reads an entry following a string of 'prev_size' bytes, the span fails if it is invalid.
+    template <class Span>
+    bool read_entry(Span& span, size_t prev_size, bool restart, entry& entry) {
+        std::uint64_t shared = 0, size = 0;
+        read_varint(span, shared);
+        read_varint(span, size);
+        if (span.failed()) return false;
+        if (shared > prev_size || (restart && shared != 0)) {
+            span.fail("tapeworm : invalid prefix entry");
+            return false;
+        }
+        if (!span.check(size)) return false;
+        entry.shared = static_cast<size_t>(shared);
+        entry.size = static_cast<size_t>(size);
+        entry.rest = reinterpret_cast<char const*>(span.advance(entry.size));
+        return true;
+    }
+
+} // ::detail::prefix
+
+} // ::tom
@@ -0,0 +1,134 @@
+
+#pragma once
+
+#include "serialization.hpp"
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace tom {
+
+// A read-only view on a range serialized with the prefix encoding, made for lookups in sorted strings.
+// A string is rebuilt from the nearest restart entry before it, and 'lower_bound' binary searches
+// the restart entries before scanning at most one interval. The serialized bytes must outlive the view.
+template <class Range>
+class prefix_view {
+    using concept_type = serial_concept_t<Range>;
+    static_assert(std::is_same_v<concept_type, serial::concept::prefix_encoding<Range>>,
+        "prefix_view only applies to types serialized with the prefix encoding.");
+
+    static constexpr size_t interval = concept_type::interval;
+    using entry_span = input_span<span_policy::unsafe>;
+public:
+    using value_type = std::string;
+    using size_type  = size_t;
+
+    prefix_view() = default;
+
+    // Checks all the entries and the restart offsets, then moves the span past the range.
+    // The view is empty if the checks fail.
+    template <class Span>
+    explicit prefix_view(Span& span) {
+        static_assert(Span::is_input, "prefix_view reads from an input span");
+        length_type length, size;
+        if (!concept_type::read_header(span, length, size)) return;
+        auto const entries = span.begin();
+        auto const restarts = entries + size;
+
+        input_span<span_policy::error> in{ entries, size };
+        detail::prefix::entry entry;
+        size_t prev_size = 0;
+        for (size_t i = 0; i < length; ++i) {
+            auto const restart = i % interval == 0;
+            if (restart && restart_offset(restarts, i / interval) != static_cast<size_t>(in.begin() - entries)) {
+                in.fail();
+                break;
+            }
+            if (!detail::prefix::read_entry(in, prev_size, restart, entry)) break;
+            prev_size = entry.shared + entry.size;
+        }
+        if (in.failed() || in.size() != 0) {
+            span.fail("tapeworm : invalid prefix entries");
+            return;
+        }
+        span.advance(size + detail::prefix::restart_count(length, interval) * sizeof(length_type));
+        entries_ = entries;
+        restarts_ = restarts;
+        size_ = length;
+    }
+
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    std::string operator[](size_type i) const {
+        std::string string;
+        auto span = block_span(i / interval);
+        for (size_t j = i / interval * interval; j <= i; ++j) next(span, string);
+        return string;
+    }
+    std::string at(size_type i) const {
+        if (i >= size_) throw std::out_of_range{ "tapeworm : prefix_view index out of range" };
+        return (*this)[i];
+    }
+
+    // The index of the first string not less than 'key', or size() if there is none.
+    size_type lower_bound(std::string_view key) const {
+        // The first restart entry not less than the key.
+        size_t low = 0, high = detail::prefix::restart_count(size_, interval);
+        while (low < high) {
+            auto const mid = low + (high - low) / 2;
+            if (restart_key(mid) < key) low = mid + 1;
+            else high = mid;
+        }
+        if (low == 0) return 0;
+        // The key is in the interval of the previous restart entry, or is this restart entry.
+        std::string string;
+        auto span = block_span(low - 1);
+        auto const end = low * interval < size_ ? low * interval : size_;
+        for (auto i = (low - 1) * interval; i < end; ++i) {
+            next(span, string);
+            if (!(string < key)) return i;
+        }
+        return end;
+    }
+
+    // The index of 'key', or size() if it is absent.
+    size_type find(std::string_view key) const {
+        auto const i = lower_bound(key);
+        return i != size_ && (*this)[i] == key ? i : size_;
+    }
+    bool contains(std::string_view key) const { return find(key) != size_; }
+private:
+    static size_t restart_offset(std::byte const* restarts, size_t restart) noexcept {
+        length_type offset;
+        std::memcpy(&offset, restarts + restart * sizeof(length_type), sizeof(length_type));
+        return offset;
+    }
+
+    entry_span block_span(size_t restart) const noexcept {
+        auto const offset = restart_offset(restarts_, restart);
+        return { entries_ + offset, static_cast<size_t>(restarts_ - entries_) - offset };
+    }
+
+    // Reads the entry following 'string', the entries being checked.
+    static void next(entry_span& span, std::string& string) {
+        detail::prefix::entry entry;
+        detail::prefix::read_entry(span, string.size(), false, entry);
+        string.resize(entry.shared);
+        string.append(entry.rest, entry.size);
+    }
+
+    // The string of a restart entry, without copying it.
+    std::string_view restart_key(size_t restart) const noexcept {
+        auto span = block_span(restart);
+        detail::prefix::entry entry;
+        detail::prefix::read_entry(span, 0, true, entry);
+        return { entry.rest, entry.size };
+    }
+
+    std::byte const* entries_ = nullptr;
+    std::byte const* restarts_ = nullptr;
+    size_type size_ = 0;
+};
+
+} // ::tom
@@ -21,18 +21,6 @@ template <template <class...> class Concept, class...Ts>
 constexpr bool implement_concept_v = detail::implement_concept<Concept, void, Ts...>;
 
 
-template <class PrioConcept, class SFINAE = void>
-struct accept_concept {
-    static constexpr bool value = is_detected_v<PrioConcept::template concept, Ts...>;
-};
-template <class PrioConcept>
-struct accept_concept<PrioConcept, std::enable_if_t<
-    PrioConcept::template concept<Ts...>::is_implemented
->> {
-    static constexpr bool value = true;
-};
-
-
 // Builds a list of prioritized concpets.
 
 // Associates a concept with a priority (the higher the more prioritized).
@@ -98,11 +86,12 @@ namespace detail {
         struct accept_concept {
             static constexpr bool value = is_detected_v<PrioConcept::template concept, Ts...>;
         };
+        // When the concept declares 'is_implemented', it has the last word.
         template <class PrioConcept>
-        struct accept_concept<PrioConcept, std::enable_if_t<
+        struct accept_concept<PrioConcept, std::void_t<decltype(
             PrioConcept::template concept<Ts...>::is_implemented
-        >> {
-            static constexpr bool value = true;
+        )>> {
+            static constexpr bool value = PrioConcept::template concept<Ts...>::is_implemented;
         };
         using type = find_first_or_t<
             List<PrioConcepts...>,
@@ -121,7 +110,7 @@ using pick_concept_t = typename detail::extract_concept<
 
 template <class PrioConceptsList, class...Ts>
 constexpr bool has_concept_v = !std::is_same_v<
-    detail::get_priority_concept<PrioConceptsList, Ts...>::type,
+    typename detail::get_priority_concept<PrioConceptsList, Ts...>::type,
     void
 >;
 
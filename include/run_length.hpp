@@ -0,0 +1,114 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+/*
+    Kernels of the run-length encoding of trivial arrays, which works on the bytes of the values.
+
+    A block of up to 'run_block' values is written in the smallest of three modes (1 byte) :
+        - raw    : the values.
+        - runs   : the number of runs (1 byte), then the length (1 byte) and the value of each run.
+        - sparse : the number of values which are not zero (1 byte), their indices in the block
+                   (1 byte each, increasing), then these values. The other values are zero.
+*/
+
+namespace tom {
+
+namespace detail::run_length {
+
+    constexpr size_t run_block = 128;
+
+    enum class block_mode : std::uint8_t { raw, runs, sparse };
+
+    inline unsigned popcount(unsigned value) noexcept {
+    #if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_popcount(value));
+    #else
+        unsigned count = 0;
+        for (; value != 0; value &= value - 1) ++count;
+        return count;
+    #endif
+    }
+
+    inline bool is_zero(std::uint8_t const* value, size_t size) noexcept {
+        for (size_t i = 0; i < size; ++i) if (value[i] != 0) return false;
+        return true;
+    }
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+    // From a mask of equal bytes, one bit at the first byte of each equal value.
+    template <size_t Size>
+    unsigned equal_values(unsigned bytes) noexcept {
+        if constexpr (Size >= 2) bytes &= bytes >> 1;
+        if constexpr (Size >= 4) bytes &= bytes >> 2;
+        if constexpr (Size >= 8) bytes &= bytes >> 4;
+        constexpr unsigned firsts[] = { 0, 0xFFFF, 0x5555, 0, 0x1111, 0, 0, 0, 0x0101 };
+        return bytes & firsts[Size];
+    }
+
+    template <size_t Size>
+    size_t count_equal_sse2(std::uint8_t const* lhs, std::uint8_t const* rhs, size_t count) noexcept {
+        size_t equal = 0, i = 0;
+        for (auto const chunks = count * Size / 16 * 16; i < chunks; i += 16) {
+            auto const values = _mm_loadu_si128(reinterpret_cast<__m128i const*>(lhs + i));
+            auto const others = rhs ? _mm_loadu_si128(reinterpret_cast<__m128i const*>(rhs + i)) : _mm_setzero_si128();
+            auto const bytes = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(values, others)));
+            equal += popcount(equal_values<Size>(bytes));
+        }
+        for (; i < count * Size; i += Size) {
+            equal += rhs ? std::memcmp(lhs + i, rhs + i, Size) == 0 : is_zero(lhs + i, Size);
+        }
+        return equal;
+    }
+
+#endif
+
+    // The number of values of 'size' bytes equal in 'lhs' and 'rhs', or equal to zero if 'rhs' is null.
+    inline size_t count_equal(std::uint8_t const* lhs, std::uint8_t const* rhs, size_t count, size_t size) noexcept {
+    #if defined(__SSE2__) || defined(_M_X64)
+        switch (size) {
+            case 1: return count_equal_sse2<1>(lhs, rhs, count);
+            case 2: return count_equal_sse2<2>(lhs, rhs, count);
+            case 4: return count_equal_sse2<4>(lhs, rhs, count);
+            case 8: return count_equal_sse2<8>(lhs, rhs, count);
+            default: break;
+        }
+    #endif
+        size_t equal = 0;
+        for (size_t i = 0; i < count * size; i += size) {
+            equal += rhs ? std::memcmp(lhs + i, rhs + i, size) == 0 : is_zero(lhs + i, size);
+        }
+        return equal;
+    }
+
+    // Chooses the mode of a block of 'count' (> 0) values, and gives it's size without the mode byte.
+    inline block_mode choose_mode(std::uint8_t const* bytes, size_t count, size_t size, size_t& encoded) noexcept {
+        auto const runs = count - count_equal(bytes + size, bytes, count - 1, size);
+        auto const values = count - count_equal(bytes, nullptr, count, size);
+        auto const raw_size = count * size;
+        auto const runs_size = 1 + runs * (1 + size);
+        auto const sparse_size = 1 + values * (1 + size);
+        encoded = raw_size;
+        auto mode = block_mode::raw;
+        if (runs_size < encoded) {
+            encoded = runs_size;
+            mode = block_mode::runs;
+        }
+        if (sparse_size < encoded) {
+            encoded = sparse_size;
+            mode = block_mode::sparse;
+        }
+        return mode;
+    }
+
+} // ::detail::run_length
+
+} // ::tom
@@ -0,0 +1,154 @@
+
+#pragma once
+
+#include "field_path.hpp"
+#include "framing.hpp"
+#include <utility>
+
+/*
+    Scans of streams of serialized tuple-like records with predicate pushdown : the predicate reads
+    a few members, which are the only ones decoded for the rejected records, and only the matches
+    are fully deserialized.
+
+    Streams :
+        - 'scan_records' : records serialized one after another. Records of constant size are skipped by
+          their size after reading the members of the predicate, the others by skipping their remaining members.
+        - 'scan_frames' : records written by 'serialize_framed' (see framing.hpp). The rejected records are
+          skipped by the size of their frame after reading the members of the predicate, and the checksum
+          is only verified on the matches.
+
+    auto const matches = tom::scan_records<trade, 0, 2>(span,
+        [] (std::uint64_t id, std::int32_t price) { return price > 1000; },
+        [&] (trade&& value) { ... });
+*/
+
+namespace tom {
+
+namespace detail::scan {
+
+    template <class T, size_t...Is>
+    using fields_t = std::tuple<std::tuple_element_t<Is, path::members_t<T>>...>;
+
+    template <class T, size_t...Is>
+    constexpr void check_fields() noexcept {
+        using members = path::members_t<T>;
+        static_assert(sizeof...(Is) != 0, "The predicate must read at least one member.");
+        static_assert(path::is_strictly_increasing<Is...>(), "The member indexes must be strictly increasing.");
+        static_assert(((Is < std::tuple_size_v<members>) && ...), "Member index out of range");
+    }
+
+    // Reads the members Is... and skips the other members Js...
+    template <class T, size_t...Is, class Span, size_t...Js>
+    fields_t<T, Is...> read_fields(Span& span, std::index_sequence<Js...> members) {
+        fields_t<T, Is...> fields{};
+        path::read_members<path::members_t<T>, Is...>(span, fields, members);
+        return fields;
+    }
+
+    // Reads the members Is..., the span is left after the last one.
+    template <class T, size_t...Is, class Span>
+    fields_t<T, Is...> read_prefix(Span& span) {
+        constexpr size_t indexes[] = { Is... };
+        constexpr auto last = indexes[sizeof...(Is) - 1];
+        return read_fields<T, Is...>(span, std::make_index_sequence<last + 1>{});
+    }
+
+    // The bytes allocated by a copy of a limited span since it was 'start', zero for other spans.
+    template <class Span>
+    size_t allocated_since(Span const& start, Span const& copy) noexcept {
+        if constexpr (serial::detail::has_limits_v<Span>) return copy.allocated() - start.allocated();
+        else return 0;
+    }
+
+    // Counts against the budget of the span the allocations made through a copy of it.
+    template <class Span>
+    bool charge(Span& span, size_t bytes) {
+        if constexpr (serial::detail::has_limits_v<Span>) return span.allocate(bytes);
+        else return true;
+    }
+
+    // Deserializes a record from 'start' and passes it to 'f'.
+    // If 'whole', the record must take all the bytes of 'start' (eg. a frame payload).
+    template <class T, class Span, class F>
+    bool decode_match(Span& span, Span const& start, bool whole, F& f) {
+        auto record = start;
+        T value{};
+        tom::deserialize(record, value);
+        if (record.failed() || (whole && record.size() != 0)) return false;
+        if (!charge(span, allocated_since(start, record))) return false;
+        f(std::move(value));
+        return true;
+    }
+
+} // ::detail::scan
+
+// Calls 'f(T&&)' on the records of a stream of serialized T whose members Is... satisfy 'predicate(members...)'.
+// Stops at the end of the span or when it fails. Returns the number of matches.
+template <class T, size_t...Is, class Span, class Predicate, class F>
+size_t scan_records(Span& span, Predicate&& predicate, F&& f) {
+    static_assert(Span::is_input, "Records are scanned from an input span");
+    detail::scan::check_fields<T, Is...>();
+    size_t matches = 0;
+    while (span.size() != 0 && !span.failed()) {
+        auto const start = span;
+        detail::scan::fields_t<T, Is...> fields;
+        if constexpr (has_constant_size_v<T>) {
+            if (!span.check(constant_size_v<T>)) break;
+            fields = detail::scan::read_prefix<T, Is...>(span);
+            if (span.failed()) break;
+            span.advance(constant_size_v<T> - static_cast<size_t>(span.begin() - start.begin()));
+        }
+        else {
+            constexpr auto members = std::tuple_size_v<detail::path::members_t<T>>;
+            fields = detail::scan::read_fields<T, Is...>(span, std::make_index_sequence<members>{});
+        }
+        if (span.failed()) break;
+        if (!std::apply(predicate, std::as_const(fields))) continue;
+
+        if (!detail::scan::decode_match<T>(span, start, false, f)) {
+            span.fail("tapeworm : invalid record");
+            break;
+        }
+        ++matches;
+    }
+    return matches;
+}
+
+// Calls 'f(T&&)' on the framed records whose members Is... satisfy 'predicate(members...)'.
+// Stops at the end of the span or when it fails. Returns the number of matches.
+template <class T, size_t...Is, class Span, class Predicate, class F>
+size_t scan_frames(Span& span, Predicate&& predicate, F&& f) {
+    static_assert(Span::is_input, "Frames are scanned from an input span");
+    detail::scan::check_fields<T, Is...>();
+    size_t matches = 0;
+    while (span.size() != 0 && !span.failed()) {
+        length_type length = 0;
+        std::uint32_t crc = 0;
+        span.read_value(length);
+        span.read_value(crc);
+        if (span.failed() || !span.check(length)) break;
+        auto const data = span.advance(length);
+
+        auto const start = serial::detail::sub_span(span, data, length);
+        auto payload = start;
+        auto const fields = detail::scan::read_prefix<T, Is...>(payload);
+        if (payload.failed() || !detail::scan::charge(span, detail::scan::allocated_since(start, payload))) {
+            span.fail("tapeworm : invalid frame payload");
+            break;
+        }
+        if (!std::apply(predicate, fields)) continue;
+
+        if (tom::crc32c(0, data, length) != crc) {
+            span.fail("tapeworm : frame checksum mismatch");
+            break;
+        }
+        if (!detail::scan::decode_match<T>(span, start, true, f)) {
+            span.fail("tapeworm : invalid frame payload");
+            break;
+        }
+        ++matches;
+    }
+    return matches;
+}
+
+} // ::tom
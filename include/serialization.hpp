@@ -1,47 +1,95 @@
 
 #pragma once
 
-#include "meta.hpp"
+#include "adaptive_coding.hpp"
+#include "bit_packing.hpp"
+#include "delta_coding.hpp"
+#include "dictionary.hpp"
+#include "io_span.hpp"
+#include "prefix_coding.hpp"
+#include "run_length.hpp"
+#include "varint.hpp"
+#include "xor_coding.hpp"
+#include "tuple_like.hpp"
+#include <algorithm>
 #include <array>
 #include <cstdint>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <string_view>
 
 /*
     Concepts : default constructible +
         - trivially_serializable
             - white-list of trivially copyable types
             - T[N] and std::array<T, N> of theses
+        - xor_encoding
+            - data(), size(), resize() + float or double values + time_series_v
+        - delta_encoding
+            - data(), size(), resize() + integer values + delta_order_v
+        - prefix_encoding
+            - data(), size(), resize() + string values + prefix_restart_v
+        - dictionary_encoding
+            - data(), size(), resize() + string values + dictionary_coding_v
+            - data(), size(), resize() + tuple_like values with string members + dictionary_coding_v
+        - adaptive_encoding
+            - data(), size(), resize() + integer values + adaptive_coding_v
+        - run_length_encoding
+            - data(), size(), resize() + trivially_serializable values + run_length_v
+        - frame_of_reference
+            - data(), size(), resize() + integer values + bit_packing_v
         - trivial_array
-            - data(), size(), resize(), [i] + trivially_serializable values
-        - array
-            - data(), size(), resize(), [i]
+            - data(), size(), resize() + trivially_serializable values
+        - optional
+            - operator*, operator bool + has_optional_semantics_v
         - tuple_like
             - std::get + std::tuple_size
             - static_visitable
             - deconstructible aggregate
         - range
-            - begin(), end(), push(v), remove_deep_const_t<value_type>
-        - optional
-            - operator*, operator->, put_value(v)
-        - visitable
-            - visit(visitor, type)
+            - begin(), end(), clear(), insert(end, v), remove_deep_const_t<value_type>
+
+    Wire format :
+        - trivially_serializable : the object bytes.
+        - trivial_array and range : a 'length_type' followed by the elements.
+        - frame_of_reference : a 'length_type' followed by blocks of up to 128 values, each made of
+          their minimum, the width in bits of their offsets to it (1 byte) and the packed offsets
+          (see bit_packing.hpp).
+        - delta_encoding : a 'length_type', the first 'order' values, then the following deltas (order 1)
+          or deltas of deltas (order 2) zigzag-encoded, as varints or as frame_of_reference blocks.
+        - xor_encoding : a 'length_type', the size in bytes of the bit stream ('length_type'), then
+          the bit stream of the values XORed with the previous ones (see xor_coding.hpp).
+        - run_length_encoding : a 'length_type' followed by blocks of up to 128 values, each written
+          raw, as runs or as sparse values (see run_length.hpp).
+        - adaptive_encoding : a 'length_type' followed by blocks of up to 128 values, each made of
+          the codec chosen for the block (1 byte) and the values encoded (see adaptive_coding.hpp).
+        - dictionary_encoding : a 'length_type', the number of distinct strings ('length_type'),
+          these strings, then the index of each value in them (see dictionary.hpp).
+          The values may be tuple_like records with string members instead, sharing the dictionary :
+          their members follow it, in order, each string member written as it's index.
+        - prefix_encoding : a 'length_type', the size in bytes of the entries ('length_type'), the entries
+          sharing the prefix of the previous string, then the offset of each restart entry ('length_type')
+          (see prefix_coding.hpp).
+        - optional : a byte (0 or 1) followed by the value if any.
+        - tuple_like : the elements one after another.
 */
 
 namespace tom
 {
 
+// The type used to prefix ranges with their number of elements.
+using length_type = std::uint32_t;
+
 template <class T>
-constexpr bool is_trivially_serializable_v = false;
+constexpr bool is_trivially_serializable_v = std::is_arithmetic_v<T> || std::is_enum_v<T>;
 
 template <class T, size_t Size>
 constexpr bool is_trivially_serializable_v<T [Size]> = is_trivially_serializable_v<T>;
 template <class T, size_t Size>
 constexpr bool is_trivially_serializable_v<std::array<T, Size>> = is_trivially_serializable_v<T>;
 
-template <>
-constexpr bool is_trivially_serializable_v<int32_t> = true;
-// ...
-
 template <class T>
 constexpr bool has_optional_semantics_v = false;
 
@@ -50,71 +98,140 @@ constexpr bool has_optional_semantics_v<std::optional<T>> = true;
 template <class T, class DeleterT>
 constexpr bool has_optional_semantics_v<std::unique_ptr<T, DeleterT>> = true;
 
-namespace serial::concept
-{
-    template <class T>
-    struct forbidden_types {
-        static constexpr bool is_implemented =
-            std::is_empty_v<T>   ||
-            std::is_union_v<T>   ||
-            std::is_pointer_v<T> ||
-            std::is_member_pointer_v<T>;
+// Specialize to serialize a container of integers with the frame-of-reference encoding.
+template <class T>
+constexpr bool bit_packing_v = false;
 
-        static_assert(!is_implemented, "Raw pointers, empty types and unions are not allowed to be serialized.");
-    };
-    
-    template <class T, std::void_t<decltype(
-        std::size(std::declval<T const&>()),
-        std::data(std::declval<T const&>()),
-        // resize, default construct
-    )>>
-    struct trivial_array {
-        using value_type = remove_cvref_t<decltype(*std::size(std::declval<T const&>()))>;
-        static constexpr bool is_implemented = is_trivially_serializable_v<value_type>;
+// A container of integers serialized with the frame-of-reference encoding.
+template <class Container>
+struct bit_packed : Container {
+    using Container::Container;
 
-        // ...
-    };
+    bit_packed() = default;
+    bit_packed(Container container) : Container(std::move(container)) {}
+};
 
-    template <class T, std::void_t<decltype(
-        std::begin(std::declval<T const&>()),
-        std::end  (std::declval<T const&>()),
-        // add_element, default_construct
-    )>>
-    struct range {
-        using value_type = remove_cvref_t<decltype(*std::begin(std::declval<T const&>()))>;
+template <class Container>
+constexpr bool bit_packing_v<bit_packed<Container>> = true;
 
-        // ...
-    };
+// How the deltas of the delta encoding are written.
+enum class delta_packing { varint, bit_packed };
 
-    template <class T, std::void_t<decltype(
-                         *std::declval<T const&>(),
-        static_cast<bool>(std::declval<T const&>()),
-        // make_optional() -> default construct T&
-    )>>
-    struct optional {
-        static constexpr bool is_implemented = has_optional_semantics_v<value_type>;
+// Specialize to serialize a container of integers with the delta encoding : 1 to write the
+// deltas of the values (eg. sorted ids), 2 to write the deltas of the deltas (eg. timestamps).
+template <class T>
+constexpr int delta_order_v = 0;
 
-        // ...
-    }
-    
-    template <class T>
-    struct tuple {
-        static constexpr bool is_implemented = false;
-    }
-    template <class...Ts>
-    struct tuple<std::tuple<Ts...>> {
-        static constexpr bool is_implemented = true;
-        using value_type = remove_deep_const_t<std::tuple<Ts...>>;
-    }
+template <class T>
+constexpr delta_packing delta_packing_v = delta_packing::bit_packed;
+
+// A container of integers serialized with the delta encoding.
+template <class Container, int Order = 1, delta_packing Packing = delta_packing::bit_packed>
+struct delta_coded : Container {
+    static_assert(Order == 1 || Order == 2, "The delta encoding is of order 1 or 2");
+
+    using Container::Container;
+
+    delta_coded() = default;
+    delta_coded(Container container) : Container(std::move(container)) {}
+};
 
+template <class Container, int Order, delta_packing Packing>
+constexpr int delta_order_v<delta_coded<Container, Order, Packing>> = Order;
 
-} // ::serial::tag
+template <class Container, int Order, delta_packing Packing>
+constexpr delta_packing delta_packing_v<delta_coded<Container, Order, Packing>> = Packing;
 
+// Specialize to serialize a container of floating-point values with the XOR encoding,
+// made for series whose values change slowly (eg. metric samples).
 template <class T>
-struct expression_tree {};
+constexpr bool time_series_v = false;
 
+// A container of floating-point values serialized with the XOR encoding.
+template <class Container>
+struct time_series : Container {
+    using Container::Container;
+
+    time_series() = default;
+    time_series(Container container) : Container(std::move(container)) {}
+};
+
+template <class Container>
+constexpr bool time_series_v<time_series<Container>> = true;
+
+// Specialize to serialize a container with the run-length encoding, made for values
+// mostly repeated or zero (eg. occupancy grids).
 template <class T>
-using expression_tree_t = typename expression_tree<T>::type;
+constexpr bool run_length_v = false;
+
+// A container serialized with the run-length encoding.
+template <class Container>
+struct run_length_coded : Container {
+    using Container::Container;
+
+    run_length_coded() = default;
+    run_length_coded(Container container) : Container(std::move(container)) {}
+};
+
+template <class Container>
+constexpr bool run_length_v<run_length_coded<Container>> = true;
+
+// Specialize to serialize a container of integers with the adaptive encoding, which picks
+// the cheapest codec for each block of values.
+template <class T>
+constexpr bool adaptive_coding_v = false;
+
+// A container of integers serialized with the adaptive encoding.
+template <class Container>
+struct adaptive_coded : Container {
+    using Container::Container;
+
+    adaptive_coded() = default;
+    adaptive_coded(Container container) : Container(std::move(container)) {}
+};
+
+template <class Container>
+constexpr bool adaptive_coding_v<adaptive_coded<Container>> = true;
+
+// Specialize to serialize a container of strings with the dictionary encoding,
+// made for strings repeated many times (eg. hostnames, labels).
+// A container of records (tuple_like values) has one dictionary for all their string members.
+template <class T>
+constexpr bool dictionary_coding_v = false;
+
+// A container of strings serialized with the dictionary encoding.
+template <class Container>
+struct dictionary_coded : Container {
+    using Container::Container;
+
+    dictionary_coded() = default;
+    dictionary_coded(Container container) : Container(std::move(container)) {}
+};
+
+template <class Container>
+constexpr bool dictionary_coding_v<dictionary_coded<Container>> = true;
+
+// Specialize to serialize a container of strings with the prefix encoding, made for sorted strings
+// (eg. index keys). The value is the number of entries between two restart entries, 0 to disable it.
+template <class T>
+constexpr size_t prefix_restart_v = 0;
+
+// A container of strings serialized with the prefix encoding.
+template <class Container, size_t RestartInterval = 16>
+struct prefix_coded : Container {
+    static_assert(RestartInterval != 0, "The restart interval can't be 0");
+
+    using Container::Container;
+
+    prefix_coded() = default;
+    prefix_coded(Container container) : Container(std::move(container)) {}
+};
+
+template <class Container, size_t RestartInterval>
+constexpr size_t prefix_restart_v<prefix_coded<Container, RestartInterval>> = RestartInterval;
+
+// The expression tree describes how a type is serialized : each node holds the type,
+// the concept used to serialize it and the trees of it's elements.
 
 namespace expression
 {
@@ -128,27 +245,1541 @@ namespace expression
 
     template <class Tree>
     struct traits {};
-    
+
     template <class T, class Concept, class...Trees>
     struct traits<node<T, Concept, Trees...>>
     {
+        using type         = T;
+        using concept_type = Concept;
+        using children     = std::tuple<Trees...>;
+
         static constexpr bool is_leaf = false;
         static constexpr bool is_empty = node<T, Concept, Trees...>::size == 0;
 
-        static constexpr bool has_constant_size = (traits<Trees>::has_constant_size && ...);
-
-
+        // Ranges have elements of constant size but are not constant themselves,
+        // so the concept has the last word.
+        static constexpr bool   has_constant_size = Concept::has_constant_size;
+        static constexpr size_t constant_size     = Concept::constant_size;
     };
 
     template <class T, class Concept>
     struct traits<leaf<T, Concept>>
     {
+        using type         = T;
+        using concept_type = Concept;
+        using children     = std::tuple<>;
+
         static constexpr bool is_leaf = true;
         static constexpr bool is_empty = false;
 
-        static constexpr bool has_constant_size = Concept::has_constant_size;
+        static constexpr bool   has_constant_size = Concept::has_constant_size;
+        static constexpr size_t constant_size     = Concept::constant_size;
     };
 
+    template <class Tree, size_t I>
+    using child_t = std::tuple_element_t<I, typename traits<Tree>::children>;
+
 } // ::expression
 
+template <class T>
+struct expression_tree;
+
+template <class T>
+using expression_tree_t = typename expression_tree<std::remove_cv_t<T>>::type;
+
+// True if all the values of T are serialized with the same number of bytes.
+template <class T>
+constexpr bool has_constant_size_v = expression::traits<expression_tree_t<T>>::has_constant_size;
+
+// The number of bytes used to serialize T if it has a constant size, 0 otherwise.
+template <class T>
+constexpr size_t constant_size_v = expression::traits<expression_tree_t<T>>::constant_size;
+
+template <class T>
+size_t serialized_size(T const& value);
+
+template <class Span, class T>
+void serialize(Span& span, T const& value);
+
+template <class Span, class T>
+void deserialize(Span& span, T& value);
+
+template <class T, class Span>
+void skip(Span& span);
+
+template <class T>
+bool serialized_equal(T const& lhs, T const& rhs);
+
+namespace serial::detail
+{
+    template <class T>
+    T& emplace_value(std::optional<T>& optional) {
+        return optional.emplace();
+    }
+    template <class T, class DeleterT>
+    T& emplace_value(std::unique_ptr<T, DeleterT>& ptr) {
+        ptr = std::unique_ptr<T, DeleterT>{ new T{} };
+        return *ptr;
+    }
+
+    template <class T>
+    constexpr bool is_std_optional_v = false;
+    template <class T>
+    constexpr bool is_std_optional_v<std::optional<T>> = true;
+
+    template <class T>
+    using optional_value_t = remove_cvref_t<decltype(*std::declval<T const&>())>;
+
+    template <class T>
+    using range_value_t = remove_deep_const_t<typename T::value_type>;
+
+    template <class T>
+    using string_data_t = decltype(
+        std::size(std::declval<T const&>()),
+        std::declval<T&>().resize(size_t{}),
+        *std::data(std::declval<T&>()));
+
+    // Contiguous containers of chars, like std::string.
+    template <class T, class = void>
+    constexpr bool is_string_like_v = false;
+    template <class T>
+    constexpr bool is_string_like_v<T, std::enable_if_t<is_detected_v<string_data_t, T>>> =
+        std::is_same_v<remove_cvref_t<string_data_t<T>>, char>;
+
+    template <class Tuple>
+    constexpr size_t string_member_count_v = 0;
+    template <class...Ts>
+    constexpr size_t string_member_count_v<std::tuple<Ts...>> = (size_t{ 0 } + ... + size_t{ is_string_like_v<Ts> });
+
+    // Tuple-like values with string members, which a dictionary encoding can intern (eg. records of logs).
+    template <class T, class = void>
+    constexpr size_t dictionary_members_v = 0;
+    template <class T>
+    constexpr size_t dictionary_members_v<T, std::enable_if_t<has_concept_v<tuple_concepts, T> && !is_string_like_v<T>>> =
+        string_member_count_v<typename pick_concept_t<tuple_concepts, T>::tuple_type>;
+
+    // The strings of each value of a dictionary coded container : 1, or the string members of a record.
+    // Only computed for the containers marked with 'dictionary_coding_v'.
+    template <class T, class Value, class = void>
+    constexpr size_t dictionary_strings_v = 0;
+    template <class T, class Value>
+    constexpr size_t dictionary_strings_v<T, Value, std::enable_if_t<dictionary_coding_v<T>>> =
+        is_string_like_v<Value> ? 1 : dictionary_members_v<Value>;
+
+    // Spans carrying decoding limits (see decode_limits.hpp).
+    template <class Span>
+    using limits_t = decltype(std::declval<Span&>().limits());
+
+    template <class Span>
+    constexpr bool has_limits_v = is_detected_v<limits_t, Span>;
+
+    // Reads a length prefix, returns false if the span failed.
+    template <class Span>
+    bool read_length(Span& span, length_type& length) {
+        length = 0;
+        span.read_value(length);
+        if constexpr (has_limits_v<Span>) {
+            if (!span.failed() && length > span.limits().max_length) {
+                span.fail("tapeworm : container length limit exceeded");
+            }
+        }
+        return !span.failed();
+    }
+
+    // Counts 'count' values of T against the allocation budget of the span if any.
+    template <class T, class Span>
+    bool allocate(Span& span, size_t count) {
+        if constexpr (has_limits_v<Span>) {
+            return span.allocate(count * sizeof(T));
+        }
+        else return true;
+    }
+
+    // A span on 'size' bytes of 'span' (eg. a delimited payload), with it's limits, allocations and depth if any.
+    template <class Span>
+    Span sub_span(Span const& span, typename Span::byte_type* data, size_t size) noexcept {
+        if constexpr (has_limits_v<Span>) return span.sub_span(data, size);
+        else return Span{ data, size };
+    }
+
+    // Counts against the limits of 'span' the allocations made through a sub span.
+    template <class Span>
+    void join_sub_span([[maybe_unused]] Span& span, [[maybe_unused]] Span const& sub) noexcept {
+        if constexpr (has_limits_v<Span>) span.join(sub);
+    }
+
+    template <class Span>
+    using release_t = decltype(std::declval<Span&>().release());
+
+    // Tells a span holding back the bytes consumed by 'advance' (eg. a crc32c_span) that they won't be patched anymore.
+    // The span may stream them, so this can throw like a write.
+    template <class Span>
+    void release([[maybe_unused]] Span& span) {
+        if constexpr (is_detected_v<release_t, Span>) span.release();
+    }
+
+    // Moves the span past 'size' bytes.
+    template <class Span>
+    void skip_bytes(Span& span, size_t size) {
+        if (span.check(size)) span.advance(size);
+    }
+
+    // Writes a 'length_type' holding the number of bytes written by 'write()', before them.
+    // A counting_span only counts them.
+    template <class Span, class F>
+    void write_sized(Span& span, F&& write) {
+        if constexpr (std::is_same_v<Span, counting_span>) {
+            span.write_value(length_type{});
+            write();
+        }
+        else {
+            if (!span.check(sizeof(length_type))) return;
+            auto const size_ptr = span.advance(sizeof(length_type));
+            auto const begin = span.begin();
+            write();
+            if (span.failed()) return;
+            auto const size = static_cast<size_t>(span.begin() - begin);
+            if (size > std::numeric_limits<length_type>::max()) {
+                span.fail("tapeworm : value too large");
+                return;
+            }
+            auto const stored = static_cast<length_type>(size);
+            std::memcpy(size_ptr, &stored, sizeof(length_type));
+            release(span);
+        }
+    }
+
+    // Calls 'write(bytes)' to fill 'size' bytes reserved in the span.
+    // A counting_span only counts them.
+    template <class Span, class F>
+    void write_in_place(Span& span, size_t size, F&& write) {
+        if constexpr (std::is_same_v<Span, counting_span>) {
+            span.write(nullptr, size);
+        }
+        else if (span.check(size)) {
+            write(reinterpret_cast<std::uint8_t*>(span.advance(size)));
+            release(span);
+        }
+    }
+
+} // ::serial::detail
+
+namespace serial::concept
+{
+    template <class T>
+    struct forbidden_types {
+        static constexpr bool is_implemented =
+            std::is_empty_v<T>   ||
+            std::is_union_v<T>   ||
+            std::is_pointer_v<T> ||
+            std::is_member_pointer_v<T>;
+
+        static_assert(!is_implemented, "Raw pointers, empty types and unions are not allowed to be serialized.");
+    };
+
+    template <class T>
+    struct trivially_serializable {
+        static constexpr bool is_implemented = is_trivially_serializable_v<T>;
+
+        static constexpr bool   has_constant_size = true;
+        static constexpr size_t constant_size     = sizeof(T);
+
+        using tree = expression::leaf<T, trivially_serializable>;
+
+        static constexpr size_t serialized_size(T const&) noexcept {
+            return sizeof(T);
+        }
+        template <class Span>
+        static void serialize(Span& span, T const& value) {
+            span.write(&value, sizeof(T));
+        }
+        template <class Span>
+        static void deserialize(Span& span, T& value) {
+            span.read(&value, sizeof(T));
+        }
+        template <class Span>
+        static void skip(Span& span) {
+            serial::detail::skip_bytes(span, sizeof(T));
+        }
+        static bool equal(T const& lhs, T const& rhs) noexcept {
+            return std::memcmp(&lhs, &rhs, sizeof(T)) == 0;
+        }
+    };
+
+    template <class T, class = std::void_t<decltype(
+        std::size(std::declval<T const&>()),
+        std::data(std::declval<T&>()),
+        std::declval<T&>().resize(size_t{})
+    )>>
+    struct xor_encoding {
+        using value_type = remove_cvref_t<decltype(*std::data(std::declval<T&>()))>;
+
+        static constexpr bool is_implemented = time_series_v<T> &&
+            (std::is_same_v<value_type, float> || std::is_same_v<value_type, double>) &&
+            std::numeric_limits<value_type>::is_iec559;
+
+        static constexpr bool   has_constant_size = false;
+        static constexpr size_t constant_size     = 0;
+
+        using tree = expression::node<T, xor_encoding, expression::leaf<value_type,
+            trivially_serializable<value_type>>>;
+
+        static size_t serialized_size(T const& array) noexcept {
+            counting_span span;
+            serialize(span, array);
+            return span.count();
+        }
+        template <class Span>
+        static void serialize(Span& span, T const& array) {
+            span.write_value(static_cast<length_type>(std::size(array)));
+            serial::detail::write_sized(span, [&] { write_stream(span, array); });
+        }
+        // Each value takes at least one bit, which is checked before resizing the array.
+        template <class Span>
+        static void deserialize(Span& span, T& array) {
+            length_type length, size = 0;
+            if (!serial::detail::read_length(span, length)) return;
+            span.read_value(size);
+            if (span.failed()) return;
+            if (length > 8 * size_t{ size } || (length != 0 && size < sizeof(value_type))) {
+                span.fail("tapeworm : invalid bit stream size");
+                return;
+            }
+            if (!span.check(size)) return;
+            if (!serial::detail::allocate<value_type>(span, length)) return;
+            array.resize(length);
+            if (length == 0) return;
+
+            basic_io_span<std::byte const, span_policy::error> stream{ span.advance(size), size };
+            bit_reader<decltype(stream)> reader{ stream };
+            auto const valid = tom::detail::xor_coding::decode(reader, length, std::data(array));
+            if (!valid || stream.failed()) span.fail("tapeworm : corrupted bit stream");
+        }
+        template <class Span>
+        static void skip(Span& span) {
+            length_type length, size = 0;
+            if (!serial::detail::read_length(span, length)) return;
+            span.read_value(size);
+            serial::detail::skip_bytes(span, size);
+        }
+        static bool equal(T const& lhs, T const& rhs) noexcept {
+            auto const size = std::size(lhs);
+            return size == std::size(rhs) &&
+                (size == 0 || std::memcmp(std::data(lhs), std::data(rhs), size * sizeof(value_type)) == 0);
+        }
+    private:
+        template <class Span>
+        static void write_stream(Span& span, T const& array) {
+            auto const length = std::size(array);
+            if (length == 0) return;
+            bit_writer<Span> writer{ span };
+            tom::detail::xor_coding::encode(std::data(array), length, writer);
+            writer.flush();
+        }
+    };
+
+    template <class T, class = std::void_t<decltype(
+        std::size(std::declval<T const&>()),
+        std::data(std::declval<T&>()),
+        std::declval<T&>().resize(size_t{})
+    )>>
+    struct delta_encoding {
+        using value_type = remove_cvref_t<decltype(*std::data(std::declval<T&>()))>;
+
+        static constexpr int  order   = delta_order_v<T>;
+        static constexpr auto packing = delta_packing_v<T>;
+        static constexpr bool is_implemented = (order == 1 || order == 2) &&
+            std::is_integral_v<value_type> && !std::is_same_v<value_type, bool>;
+
+        static constexpr bool   has_constant_size = false;
+        static constexpr size_t constant_size     = 0;
+
+        using tree = expression::node<T, delta_encoding, expression::leaf<value_type,
+            trivially_serializable<value_type>>>;
+    private:
+        using unsigned_type = typename std::conditional_t<is_implemented,
+            std::make_unsigned<value_type>, type_tag<value_type>>::type;
+
+        static constexpr size_t block = tom::detail::packing::packed_block;
+        static constexpr size_t header_size = sizeof(value_type) + 1;
+
+        static constexpr size_t seeds(size_t length) noexcept {
+            return std::min(length, static_cast<size_t>(order));
+        }
+
+        // Calls 'f(terms, count)' on the zigzag-encoded terms, by blocks.
+        template <class F>
+        static void for_each_block(value_type const* data, size_t length, F&& f) {
+            unsigned_type terms[block];
+            for (size_t first = order; first < length; first += block) {
+                auto const count = std::min(block, length - first);
+                for (size_t i = 0; i < count; ++i) {
+                    terms[i] = tom::detail::delta_coding::term<order>(data, first + i);
+                }
+                f(static_cast<unsigned_type const*>(terms), count);
+            }
+        }
+
+        template <class Span>
+        static bool read_width(Span& span, std::uint8_t& width) {
+            span.read_value(width);
+            if (span.failed()) return false;
+            if (width <= 8 * sizeof(value_type)) return true;
+            span.fail("tapeworm : invalid bit width");
+            return false;
+        }
+    public:
+        static size_t serialized_size(T const& array) noexcept {
+            using namespace tom::detail::packing;
+            auto const length = std::size(array);
+            size_t size = sizeof(length_type) + seeds(length) * sizeof(value_type);
+            for_each_block(std::data(array), length, [&] (unsigned_type const* terms, size_t count) {
+                if constexpr (packing == delta_packing::varint) {
+                    for (size_t i = 0; i < count; ++i) size += varint_size(terms[i]);
+                }
+                else {
+                    unsigned_type min;
+                    size += header_size + packed_size(count, block_width(terms, count, min));
+                }
+            });
+            return size;
+        }
+        template <class Span>
+        static void serialize(Span& span, T const& array) {
+            using namespace tom::detail::packing;
+            auto const length = std::size(array);
+            auto const data = std::data(array);
+            span.write_value(static_cast<length_type>(length));
+            if (length != 0) span.write(data, seeds(length) * sizeof(value_type));
+            for_each_block(data, length, [&] (unsigned_type const* terms, size_t count) {
+                if constexpr (packing == delta_packing::varint) {
+                    for (size_t i = 0; i < count; ++i) write_varint(span, terms[i]);
+                }
+                else {
+                    unsigned_type min{};
+                    auto const width = block_width(terms, count, min);
+                    auto const size = packed_size(count, width);
+                    span.write_value(min);
+                    span.write_value(static_cast<std::uint8_t>(width));
+                    serial::detail::write_in_place(span, size, [&] (std::uint8_t* bytes) {
+                        encode_block(terms, count, min, width, bytes);
+                    });
+                }
+            });
+        }
+        // The smallest possible size of the terms is checked before resizing the array.
+        template <class Span>
+        static void deserialize(Span& span, T& array) {
+            using namespace tom::detail::packing;
+            using tom::detail::delta_coding::prefix_sum;
+            using tom::detail::delta_coding::zigzag_decode;
+
+            length_type length;
+            if (!serial::detail::read_length(span, length)) return;
+            auto const seed_count = seeds(length);
+            auto const term_count = length - seed_count;
+            auto const min_size = seed_count * sizeof(value_type) + (packing == delta_packing::varint ?
+                term_count : (term_count + block - 1) / block * header_size);
+            if (!span.check(min_size)) return;
+            if (!serial::detail::allocate<value_type>(span, length)) return;
+            array.resize(length);
+            if (length == 0) return;
+
+            auto const data = std::data(array);
+            span.read(data, seed_count * sizeof(value_type));
+            auto value = static_cast<unsigned_type>(data[seed_count - 1]);
+            auto delta = static_cast<unsigned_type>(order == 2 && length >= 2 ?
+                static_cast<unsigned_type>(data[1]) - static_cast<unsigned_type>(data[0]) : 0);
+
+            unsigned_type terms[block];
+            for (size_t first = order; first < length; first += block) {
+                auto const count = std::min(block, size_t{ length } - first);
+                if constexpr (packing == delta_packing::varint) {
+                    for (size_t i = 0; i < count; ++i) {
+                        std::uint64_t term = 0;
+                        read_varint(span, term);
+                        if (span.failed()) return;
+                        if (term > std::numeric_limits<unsigned_type>::max()) {
+                            span.fail("tapeworm : invalid delta");
+                            return;
+                        }
+                        terms[i] = static_cast<unsigned_type>(term);
+                    }
+                }
+                else {
+                    unsigned_type min{};
+                    std::uint8_t width = 0;
+                    span.read_value(min);
+                    if (!read_width(span, width)) return;
+                    auto const size = packed_size(count, width);
+                    if (!span.check(size)) return;
+                    decode_block(reinterpret_cast<std::uint8_t const*>(span.advance(size)), count, min, width, terms);
+                }
+                for (size_t i = 0; i < count; ++i) terms[i] = zigzag_decode(terms[i]);
+                if constexpr (order == 2) {
+                    delta = prefix_sum(terms, count, delta);
+                }
+                value = prefix_sum(terms, count, value);
+                std::memcpy(data + first, terms, count * sizeof(value_type));
+            }
+        }
+        template <class Span>
+        static void skip(Span& span) {
+            length_type length;
+            if (!serial::detail::read_length(span, length)) return;
+            serial::detail::skip_bytes(span, seeds(length) * sizeof(value_type));
+            for (size_t first = order; first < length && !span.failed(); first += block) {
+                auto const count = std::min(block, size_t{ length } - first);
+                if constexpr (packing == delta_packing::varint) {
+                    std::uint64_t term;
+                    for (size_t i = 0; i < count && !span.failed(); ++i) read_varint(span, term);
+                }
+                else {
+                    std::uint8_t width = 0;
+                    serial::detail::skip_bytes(span, sizeof(value_type));
+                    if (!read_width(span, width)) return;
+                    serial::detail::skip_bytes(span, tom::detail::packing::packed_size(count, width));
+                }
+            }
+        }
+        static bool equal(T const& lhs, T const& rhs) noexcept {
+            auto const size = std::size(lhs);
+            return size == std::size(rhs) &&
+                (size == 0 || std::memcmp(std::data(lhs), std::data(rhs), size * sizeof(value_type)) == 0);
+        }
+    };
+
+    template <class T, class = std::void_t<decltype(
+        std::size(std::declval<T const&>()),
+        std::data(std::declval<T&>()),
+        std::declval<T&>().resize(size_t{})
+    )>>
+    struct prefix_encoding {
+        using value_type = remove_cvref_t<decltype(*std::data(std::declval<T&>()))>;
+
+        static constexpr size_t interval = prefix_restart_v<T>;
+        static constexpr bool is_implemented = interval != 0 && serial::detail::is_string_like_v<value_type>;
+
+        static constexpr bool   has_constant_size = false;
+        static constexpr size_t constant_size     = 0;
+
+        using tree = expression::node<T, prefix_encoding, expression_tree_t<value_type>>;
+    private:
+        // Calls 'f(i, shared)' for each string.
+        template <class F>
+        static void for_each_entry(T const& array, F&& f) {
+            auto const data = std::data(array);
+            for (size_t i = 0, length = std::size(array); i < length; ++i) {
+                auto const shared = i % interval == 0 ? 0 : tom::detail::prefix::shared_prefix(
+                    std::data(data[i - 1]), std::size(data[i - 1]), std::data(data[i]), std::size(data[i]));
+                f(i, shared);
+            }
+        }
+    public:
+        static size_t serialized_size(T const& array) noexcept {
+            auto const restarts = tom::detail::prefix::restart_count(std::size(array), interval);
+            size_t size = (2 + restarts) * sizeof(length_type);
+            for_each_entry(array, [&] (size_t i, size_t shared) {
+                size += tom::detail::prefix::entry_size(shared, std::size(std::data(array)[i]));
+            });
+            return size;
+        }
+        template <class Span>
+        static void serialize(Span& span, T const& array) {
+            auto const data = std::data(array);
+            std::vector<length_type> restarts;
+            restarts.reserve(tom::detail::prefix::restart_count(std::size(array), interval));
+            span.write_value(static_cast<length_type>(std::size(array)));
+            serial::detail::write_sized(span, [&] {
+                size_t offset = 0;
+                for_each_entry(array, [&] (size_t i, size_t shared) {
+                    auto const size = std::size(data[i]);
+                    if (i % interval == 0) restarts.push_back(static_cast<length_type>(offset));
+                    tom::detail::prefix::write_entry(span, shared, std::data(data[i]), size);
+                    offset += tom::detail::prefix::entry_size(shared, size);
+                });
+            });
+            if (!restarts.empty()) span.write(restarts.data(), restarts.size() * sizeof(length_type));
+        }
+        // The entries are checked to be in the span before resizing the array, and each string
+        // is counted against the allocation budget of the span.
+        template <class Span>
+        static void deserialize(Span& span, T& array) {
+            length_type length, size;
+            if (!read_header(span, length, size)) return;
+            if (!serial::detail::allocate<value_type>(span, length)) return;
+            array.resize(length);
+            auto const data = std::data(array);
+
+            input_span<span_policy::error> entries{ span.begin(), size };
+            auto const restarts = reinterpret_cast<std::byte const*>(span.begin() + size);
+            tom::detail::prefix::entry entry;
+            for (size_t i = 0; i < length; ++i) {
+                auto const restart = i % interval == 0;
+                if (restart) {
+                    // The restart offsets are only used by views, but must agree with the entries.
+                    length_type offset;
+                    std::memcpy(&offset, restarts + i / interval * sizeof(length_type), sizeof(length_type));
+                    if (offset != static_cast<size_t>(entries.begin() - span.begin())) {
+                        entries.fail();
+                        break;
+                    }
+                }
+                auto const prev_size = i == 0 ? 0 : std::size(data[i - 1]);
+                if (!tom::detail::prefix::read_entry(entries, prev_size, restart, entry)) break;
+                if (!serial::detail::allocate<char>(span, entry.shared + entry.size)) return;
+                data[i].resize(entry.shared + entry.size);
+                if (entry.shared != 0) std::memcpy(std::data(data[i]), std::data(data[i - 1]), entry.shared);
+                if (entry.size != 0) std::memcpy(std::data(data[i]) + entry.shared, entry.rest, entry.size);
+            }
+            if (entries.failed() || entries.size() != 0) {
+                span.fail("tapeworm : invalid prefix entries");
+                return;
+            }
+            span.advance(size + tom::detail::prefix::restart_count(length, interval) * sizeof(length_type));
+        }
+        template <class Span>
+        static void skip(Span& span) {
+            length_type length, size;
+            if (!read_header(span, length, size)) return;
+            span.advance(size + tom::detail::prefix::restart_count(length, interval) * sizeof(length_type));
+        }
+        static bool equal(T const& lhs, T const& rhs) noexcept {
+            auto const size = std::size(lhs);
+            if (size != std::size(rhs)) return false;
+            for (size_t i = 0; i < size; ++i) {
+                auto const& l = std::data(lhs)[i];
+                auto const& r = std::data(rhs)[i];
+                if (std::size(l) != std::size(r) || (std::size(l) != 0 && std::memcmp(std::data(l), std::data(r), std::size(l)) != 0)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Reads the number of strings and the size of the entries,
+        // and checks that the entries and the restart offsets are in the span.
+        // Each entry takes at least two bytes.
+        template <class Span>
+        static bool read_header(Span& span, length_type& length, length_type& size) {
+            size = 0;
+            if (!serial::detail::read_length(span, length)) return false;
+            span.read_value(size);
+            if (span.failed()) return false;
+            if (size < 2 * size_t{ length }) {
+                span.fail("tapeworm : invalid prefix entries");
+                return false;
+            }
+            return span.check(size + tom::detail::prefix::restart_count(length, interval) * sizeof(length_type));
+        }
+    };
+
+    template <class T, class = std::void_t<decltype(
+        std::size(std::declval<T const&>()),
+        std::data(std::declval<T&>()),
+        std::declval<T&>().resize(size_t{})
+    )>>
+    struct dictionary_encoding {
+        using value_type = remove_cvref_t<decltype(*std::data(std::declval<T&>()))>;
+        static constexpr size_t strings_per_value = serial::detail::dictionary_strings_v<T, value_type>;
+        static constexpr bool is_records = !serial::detail::is_string_like_v<value_type>;
+        static constexpr bool is_implemented = strings_per_value != 0;
+
+        static constexpr bool   has_constant_size = false;
+        static constexpr size_t constant_size     = 0;
+
+        using tree = expression::node<T, dictionary_encoding, expression_tree_t<value_type>>;
+    private:
+        using string_table = tom::detail::dictionary::string_table;
+
+        template <class String>
+        static std::string_view view(String const& value) noexcept {
+            return { std::data(value), std::size(value) };
+        }
+
+        // Calls 'f(member)' on each member of a record.
+        template <class Value, class F>
+        static void for_each_member(Value& value, F&& f) {
+            using tuple_concept = pick_concept_t<tuple_concepts, value_type>;
+            std::apply([&] (auto&...members) { (f(members), ...); }, tuple_concept::as_tuple(value));
+        }
+
+        // Fills the table, returns the index of each string.
+        static std::vector<std::uint32_t> build(T const& array, string_table& table) {
+            std::vector<std::uint32_t> indices;
+            indices.reserve(std::size(array) * strings_per_value);
+            for (auto const& value : array) {
+                if constexpr (is_records) {
+                    for_each_member(value, [&] (auto const& member) {
+                        if constexpr (serial::detail::is_string_like_v<remove_cvref_t<decltype(member)>>) {
+                            indices.push_back(table.insert(view(member)));
+                        }
+                    });
+                }
+                else indices.push_back(table.insert(view(value)));
+            }
+            return indices;
+        }
+
+        // Writes the indices, between the other members of the records.
+        template <class Index, class Span>
+        static void write_values(Span& span, T const& array, std::vector<std::uint32_t> const& indices) {
+            if constexpr (is_records) {
+                auto index = indices.begin();
+                for (auto const& value : array) {
+                    for_each_member(value, [&] (auto const& member) {
+                        if constexpr (serial::detail::is_string_like_v<remove_cvref_t<decltype(member)>>) {
+                            span.write_value(static_cast<Index>(*index++));
+                        }
+                        else tom::serialize(span, member);
+                    });
+                }
+            }
+            else {
+                for (auto index : indices) span.write_value(static_cast<Index>(index));
+            }
+        }
+
+        // Reads a string as a copy of it's entry.
+        template <class Span, class String>
+        static void read_string(Span& span, std::vector<std::string_view> const& entries, String& string) {
+            auto const index = read_index(span, entries.size());
+            if (span.failed()) return;
+            auto const entry = entries[index];
+            if (!serial::detail::allocate<char>(span, entry.size())) return;
+            string.resize(entry.size());
+            if (!entry.empty()) std::memcpy(std::data(string), entry.data(), entry.size());
+        }
+    public:
+        static size_t serialized_size(T const& array) {
+            string_table table;
+            auto const indices = build(array, table);
+            auto const& entries = table.entries();
+            size_t size = 2 * sizeof(length_type) +
+                indices.size() * tom::detail::dictionary::index_size(entries.size());
+            for (auto entry : entries) size += sizeof(length_type) + entry.size();
+            if constexpr (is_records) {
+                for (auto const& value : array) {
+                    for_each_member(value, [&] (auto const& member) {
+                        if constexpr (!serial::detail::is_string_like_v<remove_cvref_t<decltype(member)>>) {
+                            size += tom::serialized_size(member);
+                        }
+                    });
+                }
+            }
+            return size;
+        }
+        template <class Span>
+        static void serialize(Span& span, T const& array) {
+            string_table table;
+            auto const indices = build(array, table);
+            auto const& entries = table.entries();
+            span.write_value(static_cast<length_type>(std::size(array)));
+            span.write_value(static_cast<length_type>(entries.size()));
+            for (auto entry : entries) {
+                span.write_value(static_cast<length_type>(entry.size()));
+                span.write(entry.data(), entry.size());
+            }
+            switch (tom::detail::dictionary::index_size(entries.size())) {
+                case 1:  write_values<std::uint8_t>(span, array, indices); break;
+                case 2:  write_values<std::uint16_t>(span, array, indices); break;
+                default: write_values<std::uint32_t>(span, array, indices); break;
+            }
+        }
+        // The strings are read before resizing the array, and each copy of a string
+        // is counted against the allocation budget of the span.
+        template <class Span>
+        static void deserialize(Span& span, T& array) {
+            std::vector<std::string_view> entries;
+            length_type length;
+            if (!read_dictionary(span, length, entries)) return;
+            if (!serial::detail::allocate<value_type>(span, length)) return;
+            array.resize(length);
+            auto const data = std::data(array);
+            for (size_t i = 0; i < length && !span.failed(); ++i) {
+                if constexpr (is_records) {
+                    for_each_member(data[i], [&] (auto& member) {
+                        if (span.failed()) return;
+                        if constexpr (serial::detail::is_string_like_v<remove_cvref_t<decltype(member)>>) {
+                            read_string(span, entries, member);
+                        }
+                        else tom::deserialize(span, member);
+                    });
+                }
+                else read_string(span, entries, data[i]);
+            }
+        }
+        // The indices are checked, so that a validated buffer decodes safely.
+        template <class Span>
+        static void skip(Span& span) {
+            std::vector<std::string_view> entries;
+            length_type length;
+            if (!read_dictionary(span, length, entries)) return;
+            for (size_t i = 0; i < length && !span.failed(); ++i) {
+                if constexpr (is_records) {
+                    using tuple_type = typename pick_concept_t<tuple_concepts, value_type>::tuple_type;
+                    skip_members(span, entries.size(), static_cast<tuple_type*>(nullptr));
+                }
+                else read_index(span, entries.size());
+            }
+        }
+        static bool equal(T const& lhs, T const& rhs) {
+            auto const size = std::size(lhs);
+            if (size != std::size(rhs)) return false;
+            for (size_t i = 0; i < size; ++i) {
+                if constexpr (is_records) {
+                    if (!tom::serialized_equal(std::data(lhs)[i], std::data(rhs)[i])) return false;
+                }
+                else if (view(std::data(lhs)[i]) != view(std::data(rhs)[i])) return false;
+            }
+            return true;
+        }
+
+        // Reads the number of values and the distinct strings, which are views on the span.
+        // Checks that the indices are in the span.
+        template <class Span>
+        static bool read_dictionary(Span& span, length_type& length, std::vector<std::string_view>& entries) {
+            length_type count;
+            if (!serial::detail::read_length(span, length)) return false;
+            if (!serial::detail::read_length(span, count)) return false;
+            if (count > length * std::uint64_t{ strings_per_value } || (count == 0) != (length == 0)) {
+                span.fail("tapeworm : invalid dictionary");
+                return false;
+            }
+            if (!span.check(count * sizeof(length_type))) return false;
+            entries.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                length_type size;
+                if (!serial::detail::read_length(span, size)) return false;
+                if (!span.check(size)) return false;
+                entries.emplace_back(reinterpret_cast<char const*>(span.advance(size)), size);
+            }
+            return span.check(length * strings_per_value * tom::detail::dictionary::index_size(count));
+        }
+
+        // Reads an index and checks it.
+        template <class Span>
+        static size_t read_index(Span& span, size_t entries) {
+            size_t index = 0;
+            switch (tom::detail::dictionary::index_size(entries)) {
+                case 1:  { std::uint8_t value = 0;  span.read_value(value); index = value; break; }
+                case 2:  { std::uint16_t value = 0; span.read_value(value); index = value; break; }
+                default: { std::uint32_t value = 0; span.read_value(value); index = value; break; }
+            }
+            if (index >= entries) {
+                span.fail("tapeworm : invalid dictionary index");
+                return 0;
+            }
+            return index;
+        }
+    private:
+        template <class Span, class...Ts>
+        static void skip_members(Span& span, size_t entries, std::tuple<Ts...>*) {
+            ([&] {
+                if (span.failed()) return;
+                if constexpr (serial::detail::is_string_like_v<Ts>) read_index(span, entries);
+                else tom::skip<Ts>(span);
+            }(), ...);
+        }
+    };
+
+    template <class T, class = std::void_t<decltype(
+        std::size(std::declval<T const&>()),
+        std::data(std::declval<T&>()),
+        std::declval<T&>().resize(size_t{})
+    )>>
+    struct adaptive_encoding {
+        using value_type = remove_cvref_t<decltype(*std::data(std::declval<T&>()))>;
+        static constexpr bool is_implemented = adaptive_coding_v<T> &&
+            std::is_integral_v<value_type> && !std::is_same_v<value_type, bool>;
+
+        static constexpr bool   has_constant_size = false;
+        static constexpr size_t constant_size     = 0;
+
+        using tree = expression::node<T, adaptive_encoding, expression::leaf<value_type,
+            trivially_serializable<value_type>>>;
+    private:
+        static constexpr size_t block = tom::detail::adaptive::adaptive_block;
+
+        using block_codec = tom::detail::adaptive::block_codec;
+
+        // Decodes a block through the table of decoders.
+        template <class Span>
+        static void decode_block(Span& span, value_type* values, size_t count) {
+            using namespace tom::detail::adaptive;
+            std::uint8_t codec = 0;
+            span.read_value(codec);
+            if (span.failed()) return;
+            if (codec >= static_cast<std::uint8_t>(block_codec::count)) {
+                span.fail("tapeworm : invalid block codec");
+                return;
+            }
+            block_span block{ span.begin(), span.size() };
+            decoders<value_type>[codec](block, count, values);
+            if (block.failed()) {
+                span.fail("tapeworm : invalid block");
+                return;
+            }
+            span.advance(static_cast<size_t>(block.begin() - span.begin()));
+        }
+    public:
+        static size_t serialized_size(T const& array) noexcept {
+            auto const length = std::size(array);
+            size_t size = sizeof(length_type);
+            for (size_t first = 0; first < length; first += block) {
+                size_t encoded;
+                tom::detail::adaptive::choose_codec(std::data(array) + first, std::min(block, length - first), encoded);
+                size += 1 + encoded;
+            }
+            return size;
+        }
+        template <class Span>
+        static void serialize(Span& span, T const& array) {
+            auto const length = std::size(array);
+            span.write_value(static_cast<length_type>(length));
+            for (size_t first = 0; first < length && !span.failed(); first += block) {
+                auto const values = std::data(array) + first;
+                auto const count = std::min(block, length - first);
+                size_t encoded;
+                auto const codec = tom::detail::adaptive::choose_codec(values, count, encoded);
+                span.write_value(codec);
+                serial::detail::write_in_place(span, encoded, [&] (std::uint8_t* bytes) {
+                    tom::detail::adaptive::encode(codec, values, count, bytes);
+                });
+            }
+        }
+        // The codec bytes of the blocks are checked before resizing the array.
+        template <class Span>
+        static void deserialize(Span& span, T& array) {
+            length_type length;
+            if (!serial::detail::read_length(span, length)) return;
+            if (!span.check((size_t{ length } + block - 1) / block * 2)) return;
+            if (!serial::detail::allocate<value_type>(span, length)) return;
+            array.resize(length);
+            for (size_t first = 0; first < length && !span.failed(); first += block) {
+                decode_block(span, std::data(array) + first, std::min(block, size_t{ length } - first));
+            }
+        }
+        // The blocks are decoded to find their sizes.
+        template <class Span>
+        static void skip(Span& span) {
+            length_type length;
+            if (!serial::detail::read_length(span, length)) return;
+            value_type values[block];
+            for (size_t first = 0; first < length && !span.failed(); first += block) {
+                decode_block(span, values, std::min(block, size_t{ length } - first));
+            }
+        }
+        static bool equal(T const& lhs, T const& rhs) noexcept {
+            auto const size = std::size(lhs);
+            return size == std::size(rhs) &&
+                (size == 0 || std::memcmp(std::data(lhs), std::data(rhs), size * sizeof(value_type)) == 0);
+        }
+    };
+
+    template <class T, class = std::void_t<decltype(
+        std::size(std::declval<T const&>()),
+        std::data(std::declval<T&>()),
+        std::declval<T&>().resize(size_t{})
+    )>>
+    struct run_length_encoding {
+        using value_type = remove_cvref_t<decltype(*std::data(std::declval<T&>()))>;
+        static constexpr bool is_implemented = run_length_v<T> && is_trivially_serializable_v<value_type>;
+
+        static constexpr bool   has_constant_size = false;
+        static constexpr size_t constant_size     = 0;
+
+        using tree = expression::node<T, run_length_encoding, expression::leaf<value_type,
+            trivially_serializable<value_type>>>;
+    private:
+        static constexpr size_t block = tom::detail::run_length::run_block;
+        static constexpr size_t value_size = sizeof(value_type);
+
+        using block_mode = tom::detail::run_length::block_mode;
+
+        static std::uint8_t const* bytes_of(T const& array, size_t first) noexcept {
+            return reinterpret_cast<std::uint8_t const*>(std::data(array) + first);
+        }
+
+        // Reads a count of up to 'max' entries of 'entry_size' bytes, and checks them.
+        template <class Span>
+        static bool read_entries(Span& span, size_t max, size_t entry_size, std::uint8_t& count) {
+            span.read_value(count);
+            if (span.failed()) return false;
+            if (count > max) {
+                span.fail("tapeworm : invalid block");
+                return false;
+            }
+            return span.check(count * entry_size);
+        }
+
+        // Reads the runs of a block, calling 'run(first, length, value)' on each of them, and checks that they fill it.
+        template <class Span, class F>
+        static void for_each_run(Span& span, size_t count, F&& run) {
+            std::uint8_t runs;
+            if (!read_entries(span, count, 1 + value_size, runs)) return;
+            size_t filled = 0;
+            for (size_t i = 0; i < runs; ++i) {
+                auto const length = static_cast<std::uint8_t>(*span.advance(1));
+                auto const value = span.advance(value_size);
+                if (length == 0 || length > count - filled) break;
+                run(filled, size_t{ length }, value);
+                filled += length;
+            }
+            if (filled != count) span.fail("tapeworm : invalid block");
+        }
+
+        // Reads the values of a sparse block, calling 'value(index, data)' on each of them, and checks their indices.
+        template <class Span, class F>
+        static void for_each_sparse(Span& span, size_t count, F&& value) {
+            std::uint8_t values;
+            if (!read_entries(span, count, 1 + value_size, values)) return;
+            auto const indices = reinterpret_cast<std::uint8_t const*>(span.advance(values));
+            auto const data = span.advance(values * value_size);
+            for (size_t i = 0; i < values; ++i) {
+                if (indices[i] >= count || (i != 0 && indices[i] <= indices[i - 1])) {
+                    span.fail("tapeworm : invalid block");
+                    return;
+                }
+                value(size_t{ indices[i] }, data + i * value_size);
+            }
+        }
+
+        template <class Span>
+        static void read_runs(Span& span, std::uint8_t* dst, size_t count) {
+            for_each_run(span, count, [dst] (size_t first, size_t length, auto value) {
+                for (size_t j = first; j < first + length; ++j) std::memcpy(dst + j * value_size, value, value_size);
+            });
+        }
+
+        template <class Span>
+        static void read_sparse(Span& span, std::uint8_t* dst, size_t count) {
+            std::memset(dst, 0, count * value_size);
+            for_each_sparse(span, count, [dst] (size_t index, auto value) {
+                std::memcpy(dst + index * value_size, value, value_size);
+            });
+        }
+    public:
+        static size_t serialized_size(T const& array) noexcept {
+            auto const length = std::size(array);
+            size_t size = sizeof(length_type);
+            for (size_t first = 0; first < length; first += block) {
+                size_t encoded;
+                tom::detail::run_length::choose_mode(bytes_of(array, first), std::min(block, length - first), value_size, encoded);
+                size += 1 + encoded;
+            }
+            return size;
+        }
+        template <class Span>
+        static void serialize(Span& span, T const& array) {
+            auto const length = std::size(array);
+            span.write_value(static_cast<length_type>(length));
+            for (size_t first = 0; first < length; first += block) {
+                auto const count = std::min(block, length - first);
+                auto const bytes = bytes_of(array, first);
+                auto const value = [bytes] (size_t i) { return bytes + i * value_size; };
+                size_t encoded;
+                auto const mode = tom::detail::run_length::choose_mode(bytes, count, value_size, encoded);
+                span.write_value(mode);
+                if (mode == block_mode::raw) {
+                    span.write(bytes, count * value_size);
+                }
+                else if (mode == block_mode::runs) {
+                    span.write_value(static_cast<std::uint8_t>((encoded - 1) / (1 + value_size)));
+                    for (size_t i = 0, end; i < count; i = end) {
+                        for (end = i + 1; end < count && std::memcmp(value(end), value(i), value_size) == 0; ++end);
+                        span.write_value(static_cast<std::uint8_t>(end - i));
+                        span.write(value(i), value_size);
+                    }
+                }
+                else {
+                    std::uint8_t indices[block];
+                    std::uint8_t values = 0;
+                    for (size_t i = 0; i < count; ++i) {
+                        if (!tom::detail::run_length::is_zero(value(i), value_size)) {
+                            indices[values++] = static_cast<std::uint8_t>(i);
+                        }
+                    }
+                    span.write_value(values);
+                    span.write(indices, values);
+                    for (size_t i = 0; i < values; ++i) span.write(value(indices[i]), value_size);
+                }
+            }
+        }
+        // The mode bytes and counts of the blocks are checked before resizing the array.
+        template <class Span>
+        static void deserialize(Span& span, T& array) {
+            length_type length;
+            if (!serial::detail::read_length(span, length)) return;
+            if (!span.check((size_t{ length } + block - 1) / block * 2)) return;
+            if (!serial::detail::allocate<value_type>(span, length)) return;
+            array.resize(length);
+            for (size_t first = 0; first < length && !span.failed(); first += block) {
+                auto const count = std::min(block, size_t{ length } - first);
+                auto const dst = reinterpret_cast<std::uint8_t*>(std::data(array) + first);
+                block_mode mode{};
+                span.read_value(mode);
+                if (span.failed()) return;
+                switch (mode) {
+                    case block_mode::raw:    span.read(dst, count * value_size); break;
+                    case block_mode::runs:   read_runs(span, dst, count); break;
+                    case block_mode::sparse: read_sparse(span, dst, count); break;
+                    default: span.fail("tapeworm : invalid block mode");
+                }
+            }
+        }
+        // The blocks are checked like 'deserialize' does, so that a validated buffer decodes safely.
+        // 'visit(data, count)' is called on the bytes of the 'count' values written (eg. to check booleans).
+        template <class Span, class F>
+        static void skip(Span& span, F&& visit) {
+            length_type length;
+            if (!serial::detail::read_length(span, length)) return;
+            for (size_t first = 0; first < length && !span.failed(); first += block) {
+                auto const count = std::min(block, size_t{ length } - first);
+                block_mode mode{};
+                span.read_value(mode);
+                if (span.failed()) return;
+                switch (mode) {
+                    case block_mode::raw:
+                        if (span.check(count * value_size)) visit(span.advance(count * value_size), count);
+                        break;
+                    case block_mode::runs:
+                        for_each_run(span, count, [&] (size_t, size_t, auto value) { visit(value, size_t{ 1 }); });
+                        break;
+                    case block_mode::sparse:
+                        for_each_sparse(span, count, [&] (size_t, auto value) { visit(value, size_t{ 1 }); });
+                        break;
+                    default: span.fail("tapeworm : invalid block mode");
+                }
+            }
+        }
+        template <class Span>
+        static void skip(Span& span) {
+            skip(span, [] (auto, size_t) {});
+        }
+        static bool equal(T const& lhs, T const& rhs) noexcept {
+            auto const size = std::size(lhs);
+            return size == std::size(rhs) &&
+                (size == 0 || std::memcmp(std::data(lhs), std::data(rhs), size * sizeof(value_type)) == 0);
+        }
+    };
+
+    template <class T, class = std::void_t<decltype(
+        std::size(std::declval<T const&>()),
+        std::data(std::declval<T&>()),
+        std::declval<T&>().resize(size_t{})
+    )>>
+    struct frame_of_reference {
+        using value_type = remove_cvref_t<decltype(*std::data(std::declval<T&>()))>;
+        static constexpr bool is_implemented = bit_packing_v<T> &&
+            std::is_integral_v<value_type> && !std::is_same_v<value_type, bool>;
+
+        static constexpr bool   has_constant_size = false;
+        static constexpr size_t constant_size     = 0;
+
+        using tree = expression::node<T, frame_of_reference, expression::leaf<value_type,
+            trivially_serializable<value_type>>>;
+    private:
+        static constexpr size_t block = tom::detail::packing::packed_block;
+        static constexpr size_t header_size = sizeof(value_type) + 1;
+    public:
+        static size_t serialized_size(T const& array) noexcept {
+            using namespace tom::detail::packing;
+            auto const length = std::size(array);
+            auto const data = std::data(array);
+            size_t size = sizeof(length_type);
+            for (size_t first = 0; first < length; first += block) {
+                auto const count = std::min(block, length - first);
+                value_type min{};
+                size += header_size + packed_size(count, block_width(data + first, count, min));
+            }
+            return size;
+        }
+        template <class Span>
+        static void serialize(Span& span, T const& array) {
+            using namespace tom::detail::packing;
+            auto const length = std::size(array);
+            auto const data = std::data(array);
+            span.write_value(static_cast<length_type>(length));
+            for (size_t first = 0; first < length; first += block) {
+                auto const count = std::min(block, length - first);
+                value_type min{};
+                auto const width = block_width(data + first, count, min);
+                auto const size = packed_size(count, width);
+                span.write_value(min);
+                span.write_value(static_cast<std::uint8_t>(width));
+                serial::detail::write_in_place(span, size, [&] (std::uint8_t* bytes) {
+                    encode_block(data + first, count, min, width, bytes);
+                });
+                if (span.failed()) return;
+            }
+        }
+        // The headers of the blocks are checked before resizing the array.
+        template <class Span>
+        static void deserialize(Span& span, T& array) {
+            using namespace tom::detail::packing;
+            length_type length;
+            if (!serial::detail::read_length(span, length)) return;
+            if (!span.check((size_t{ length } + block - 1) / block * header_size)) return;
+            if (!serial::detail::allocate<value_type>(span, length)) return;
+            array.resize(length);
+            auto const data = std::data(array);
+            for (size_t first = 0; first < length; first += block) {
+                auto const count = std::min(block, size_t{ length } - first);
+                value_type min{};
+                std::uint8_t width = 0;
+                span.read_value(min);
+                span.read_value(width);
+                if (span.failed()) return;
+                if (width > 8 * sizeof(value_type)) {
+                    span.fail("tapeworm : invalid bit width");
+                    return;
+                }
+                auto const size = packed_size(count, width);
+                if (!span.check(size)) return;
+                decode_block(reinterpret_cast<std::uint8_t const*>(span.advance(size)), count, min, width, data + first);
+            }
+        }
+        template <class Span>
+        static void skip(Span& span) {
+            length_type length;
+            if (!serial::detail::read_length(span, length)) return;
+            for (size_t first = 0; first < length && !span.failed(); first += block) {
+                std::uint8_t width = 0;
+                serial::detail::skip_bytes(span, sizeof(value_type));
+                span.read_value(width);
+                if (span.failed()) return;
+                if (width > 8 * sizeof(value_type)) {
+                    span.fail("tapeworm : invalid bit width");
+                    return;
+                }
+                serial::detail::skip_bytes(span, tom::detail::packing::packed_size(std::min(block, length - first), width));
+            }
+        }
+        static bool equal(T const& lhs, T const& rhs) noexcept {
+            auto const size = std::size(lhs);
+            return size == std::size(rhs) &&
+                (size == 0 || std::memcmp(std::data(lhs), std::data(rhs), size * sizeof(value_type)) == 0);
+        }
+    };
+
+    template <class T, class = std::void_t<decltype(
+        std::size(std::declval<T const&>()),
+        std::data(std::declval<T&>()),
+        std::declval<T&>().resize(size_t{})
+    )>>
+    struct trivial_array {
+        using value_type = remove_cvref_t<decltype(*std::data(std::declval<T&>()))>;
+        static constexpr bool is_implemented = is_trivially_serializable_v<value_type>;
+
+        static constexpr bool   has_constant_size = false;
+        static constexpr size_t constant_size     = 0;
+
+        using tree = expression::node<T, trivial_array, expression::leaf<value_type,
+            trivially_serializable<value_type>>>;
+
+        static size_t serialized_size(T const& array) noexcept {
+            return sizeof(length_type) + std::size(array) * sizeof(value_type);
+        }
+        template <class Span>
+        static void serialize(Span& span, T const& array) {
+            auto const length = static_cast<length_type>(std::size(array));
+            span.write_value(length);
+            // The data of empty containers may be null, which memcpy does not allow.
+            if (length != 0) span.write(std::data(array), length * sizeof(value_type));
+        }
+        // The bytes are checked before resizing the array.
+        template <class Span>
+        static void deserialize(Span& span, T& array) {
+            length_type length;
+            if (!serial::detail::read_length(span, length)) return;
+            auto const bytes = size_t{ length } * sizeof(value_type);
+            if (!span.check(bytes)) return;
+            if (!serial::detail::allocate<value_type>(span, length)) return;
+            array.resize(length);
+            if (length != 0) std::memcpy(std::data(array), span.advance(bytes), bytes);
+        }
+        template <class Span>
+        static void skip(Span& span) {
+            length_type length;
+            if (!serial::detail::read_length(span, length)) return;
+            serial::detail::skip_bytes(span, size_t{ length } * sizeof(value_type));
+        }
+        static bool equal(T const& lhs, T const& rhs) noexcept {
+            auto const size = std::size(lhs);
+            return size == std::size(rhs) &&
+                (size == 0 || std::memcmp(std::data(lhs), std::data(rhs), size * sizeof(value_type)) == 0);
+        }
+    };
+
+    template <class T, class = std::void_t<decltype(
+                          *std::declval<T const&>(),
+        static_cast<bool>(std::declval<T const&>())
+    )>>
+    struct optional {
+        using value_type = serial::detail::optional_value_t<T>;
+        static constexpr bool is_implemented = has_optional_semantics_v<T>;
+
+        static constexpr bool   has_constant_size = false;
+        static constexpr size_t constant_size     = 0;
+
+        using tree = expression::node<T, optional, expression_tree_t<value_type>>;
+
+        static size_t serialized_size(T const& optional) {
+            return 1 + (optional ? tom::serialized_size(*optional) : 0);
+        }
+        template <class Span>
+        static void serialize(Span& span, T const& optional) {
+            span.write_value(static_cast<std::uint8_t>(optional ? 1 : 0));
+            if (optional) tom::serialize(span, *optional);
+        }
+        template <class Span>
+        static void deserialize(Span& span, T& optional) {
+            std::uint8_t flag = 0;
+            span.read_value(flag);
+            if (span.failed()) return;
+            if (flag == 0) {
+                optional = T{};
+            }
+            else if (flag == 1) {
+                if constexpr (!serial::detail::is_std_optional_v<T>) {
+                    if (!serial::detail::allocate<value_type>(span, 1)) return;
+                }
+                tom::deserialize(span, serial::detail::emplace_value(optional));
+            }
+            else span.fail("tapeworm : invalid optional flag");
+        }
+        template <class Span>
+        static void skip(Span& span) {
+            std::uint8_t flag = 0;
+            span.read_value(flag);
+            if (span.failed()) return;
+            if (flag == 1) {
+                tom::skip<value_type>(span);
+            }
+            else if (flag != 0) span.fail("tapeworm : invalid optional flag");
+        }
+        static bool equal(T const& lhs, T const& rhs) {
+            if (!lhs || !rhs) return !lhs && !rhs;
+            return tom::serialized_equal(*lhs, *rhs);
+        }
+    };
+
+    template <class T, class = std::enable_if_t<
+        has_concept_v<tuple_concepts, T>
+    >>
+    struct tuple_like {
+        using tuple_concept = pick_concept_t<tuple_concepts, T>;
+        using tuple_type    = typename tuple_concept::tuple_type;
+    private:
+        template <class Tuple>
+        struct members {};
+        template <class...Ts>
+        struct members<std::tuple<Ts...>> {
+            static constexpr bool   has_constant_size = (has_constant_size_v<Ts> && ...);
+            static constexpr size_t constant_size     = has_constant_size ? (size_t{ 0 } + ... + constant_size_v<Ts>) : 0;
+
+            using tree = expression::node<T, tuple_like, expression_tree_t<Ts>...>;
+
+            template <class Span>
+            static void skip(Span& span) {
+                (tom::skip<Ts>(span), ...);
+            }
+        };
+        using members_t = members<tuple_type>;
+    public:
+        static constexpr bool   has_constant_size = members_t::has_constant_size;
+        static constexpr size_t constant_size     = members_t::constant_size;
+
+        using tree = typename members_t::tree;
+
+        static size_t serialized_size(T const& value) {
+            if constexpr (has_constant_size) {
+                return constant_size;
+            }
+            else return std::apply([] (auto const&...members) {
+                return (size_t{ 0 } + ... + tom::serialized_size(members));
+            }, tuple_concept::as_tuple(value));
+        }
+        template <class Span>
+        static void serialize(Span& span, T const& value) {
+            std::apply([&] (auto const&...members) {
+                (tom::serialize(span, members), ...);
+            }, tuple_concept::as_tuple(value));
+        }
+        template <class Span>
+        static void deserialize(Span& span, T& value) {
+            std::apply([&] (auto&...members) {
+                (tom::deserialize(span, members), ...);
+            }, tuple_concept::as_tuple(value));
+        }
+        template <class Span>
+        static void skip(Span& span) {
+            if constexpr (has_constant_size) {
+                serial::detail::skip_bytes(span, constant_size);
+            }
+            else members_t::skip(span);
+        }
+        static bool equal(T const& lhs, T const& rhs) {
+            return std::apply([&] (auto const&...lhs_members) {
+                return std::apply([&] (auto const&...rhs_members) {
+                    return (tom::serialized_equal(lhs_members, rhs_members) && ...);
+                }, tuple_concept::as_tuple(rhs));
+            }, tuple_concept::as_tuple(lhs));
+        }
+    };
+
+    template <class T, class = std::void_t<decltype(
+        std::begin(std::declval<T const&>()),
+        std::end  (std::declval<T const&>()),
+        std::declval<T&>().clear(),
+        std::declval<T&>().insert(std::end(std::declval<T&>()),
+            std::declval<serial::detail::range_value_t<T>>())
+    )>>
+    struct range {
+        using value_type = serial::detail::range_value_t<T>;
+
+        static constexpr bool   has_constant_size = false;
+        static constexpr size_t constant_size     = 0;
+
+        using tree = expression::node<T, range, expression_tree_t<value_type>>;
+
+        static size_t serialized_size(T const& range) {
+            if constexpr (has_constant_size_v<value_type>) {
+                auto const length = static_cast<size_t>(std::distance(std::begin(range), std::end(range)));
+                return sizeof(length_type) + length * constant_size_v<value_type>;
+            }
+            else {
+                size_t size = sizeof(length_type);
+                for (auto const& value : range) size += tom::serialized_size(value);
+                return size;
+            }
+        }
+        template <class Span>
+        static void serialize(Span& span, T const& range) {
+            auto const length = static_cast<length_type>(std::distance(std::begin(range), std::end(range)));
+            span.write_value(length);
+            for (auto const& value : range) tom::serialize(span, value);
+        }
+        template <class Span>
+        static void deserialize(Span& span, T& range) {
+            length_type length;
+            if (!serial::detail::read_length(span, length)) return;
+            // Each element takes at least 'min_size' bytes, so a hostile length
+            // can't reserve more elements than the input holds.
+            if (!span.check(size_t{ length } * min_size)) return;
+            if (!serial::detail::allocate<value_type>(span, length)) return;
+            range.clear();
+            if constexpr (is_detected_v<reserve_t, T>) {
+                range.reserve(std::min<size_t>(length, span.size() / min_size));
+            }
+            for (length_type i = 0; i < length && !span.failed(); ++i) {
+                value_type value{};
+                tom::deserialize(span, value);
+                range.insert(std::end(range), std::move(value));
+            }
+        }
+        template <class Span>
+        static void skip(Span& span) {
+            length_type length;
+            if (!serial::detail::read_length(span, length)) return;
+            if constexpr (has_constant_size_v<value_type>) {
+                serial::detail::skip_bytes(span, size_t{ length } * constant_size_v<value_type>);
+            }
+            else for (length_type i = 0; i < length && !span.failed(); ++i) {
+                tom::skip<value_type>(span);
+            }
+        }
+        static bool equal(T const& lhs, T const& rhs) {
+            return std::equal(std::begin(lhs), std::end(lhs), std::begin(rhs), std::end(rhs),
+                [] (auto const& l, auto const& r) { return tom::serialized_equal(l, r); });
+        }
+    private:
+        template <class U>
+        using reserve_t = decltype(std::declval<U&>().reserve(size_t{}));
+
+        static constexpr size_t min_size = has_constant_size_v<value_type> ? constant_size_v<value_type> : 1;
+    };
+
+} // ::serial::concept
+
+using serial_concepts = build_concept_list
+    <serial::concept::forbidden_types,        13>::add
+    <serial::concept::trivially_serializable, 12>::add
+    <serial::concept::xor_encoding,           11>::add
+    <serial::concept::delta_encoding,         10>::add
+    <serial::concept::prefix_encoding,        9>::add
+    <serial::concept::dictionary_encoding,    8>::add
+    <serial::concept::adaptive_encoding,      7>::add
+    <serial::concept::run_length_encoding,    6>::add
+    <serial::concept::frame_of_reference,     5>::add
+    <serial::concept::trivial_array,          4>::add
+    <serial::concept::optional,               3>::add
+    <serial::concept::tuple_like,             2>::add
+    <serial::concept::range,                  1>;
+
+template <class T>
+constexpr bool is_serializable_v = has_concept_v<serial_concepts, std::remove_cv_t<T>>;
+
+template <class T>
+using serial_concept_t = pick_concept_t<serial_concepts, std::remove_cv_t<T>>;
+
+// True if T is serialized with the given serial concept.
+
+namespace serial::detail {
+    template <class Concept, template <class...> class Expected>
+    constexpr bool is_concept = false;
+    template <template <class...> class Expected, class...Ts>
+    constexpr bool is_concept<Expected<Ts...>, Expected> = true;
+} // ::serial::detail
+
+template <class T, template <class...> class Concept>
+constexpr bool uses_concept_v = serial::detail::is_concept<serial_concept_t<T>, Concept>;
+
+template <class T>
+struct expression_tree {
+    using type = typename serial_concept_t<T>::tree;
+};
+
+template <class T>
+size_t serialized_size(T const& value) {
+    return serial_concept_t<T>::serialized_size(value);
+}
+
+template <class Span, class T>
+void serialize(Span& span, T const& value) {
+    static_assert(!Span::is_input, "Can't serialize in an input span");
+    serial_concept_t<T>::serialize(span, value);
+}
+
+template <class Span, class T>
+void deserialize(Span& span, T& value) {
+    if constexpr (serial::detail::has_limits_v<Span> && !expression::traits<expression_tree_t<T>>::is_leaf) {
+        if (!span.enter()) return;
+        serial_concept_t<T>::deserialize(span, value);
+        span.leave();
+    }
+    else serial_concept_t<T>::deserialize(span, value);
+}
+
+// Moves the span past a serialized T without constructing it.
+template <class T, class Span>
+void skip(Span& span) {
+    serial_concept_t<T>::skip(span);
+}
+
+// True if both values are serialized with the same bytes.
+template <class T>
+bool serialized_equal(T const& lhs, T const& rhs) {
+    return serial_concept_t<T>::equal(lhs, rhs);
+}
+
+// Deserializes a default constructed T.
+template <class T, class Span>
+T deserialize(Span& span) {
+    T value{};
+    tom::deserialize(span, value);
+    return value;
+}
+
 } // ::tom
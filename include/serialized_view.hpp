@@ -0,0 +1,114 @@
+
+#pragma once
+
+#include "serialization.hpp"
+#include <iterator>
+#include <stdexcept>
+
+namespace tom {
+
+// A read-only view on a serialized range whose elements have a constant size.
+// Nothing is decoded upfront : the offset of an element is computed from it's index,
+// and only this element is deserialized on access.
+template <class Range>
+class serialized_view {
+    using concept_type = serial_concept_t<Range>;
+    static_assert(
+        std::is_same_v<concept_type, serial::concept::trivial_array<Range>> ||
+        std::is_same_v<concept_type, serial::concept::range<Range>>,
+        "serialized_view only applies to types serialized as ranges.");
+public:
+    using value_type = typename concept_type::value_type;
+    using size_type  = size_t;
+
+    static_assert(has_constant_size_v<value_type>,
+        "The elements of a serialized_view must have a constant serialized size.");
+
+    static constexpr size_t element_size = constant_size_v<value_type>;
+
+    class iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = typename serialized_view::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = value_type;
+        using pointer           = void;
+
+        constexpr iterator() noexcept = default;
+
+        value_type operator*() const { return decode(ptr_); }
+        value_type operator[](difference_type i) const { return decode(ptr_ + i * element_size); }
+
+        constexpr iterator& operator++() noexcept { ptr_ += element_size; return *this; }
+        constexpr iterator& operator--() noexcept { ptr_ -= element_size; return *this; }
+        constexpr iterator operator++(int) noexcept { auto it = *this; ++*this; return it; }
+        constexpr iterator operator--(int) noexcept { auto it = *this; --*this; return it; }
+
+        constexpr iterator& operator+=(difference_type n) noexcept { ptr_ += n * difference_type{ element_size }; return *this; }
+        constexpr iterator& operator-=(difference_type n) noexcept { ptr_ -= n * difference_type{ element_size }; return *this; }
+
+        constexpr friend iterator operator+(iterator it, difference_type n) noexcept { return it += n; }
+        constexpr friend iterator operator+(difference_type n, iterator it) noexcept { return it += n; }
+        constexpr friend iterator operator-(iterator it, difference_type n) noexcept { return it -= n; }
+        constexpr friend difference_type operator-(iterator lhs, iterator rhs) noexcept {
+            return (lhs.ptr_ - rhs.ptr_) / difference_type{ element_size };
+        }
+
+        constexpr friend bool operator==(iterator lhs, iterator rhs) noexcept { return lhs.ptr_ == rhs.ptr_; }
+        constexpr friend bool operator!=(iterator lhs, iterator rhs) noexcept { return lhs.ptr_ != rhs.ptr_; }
+        constexpr friend bool operator< (iterator lhs, iterator rhs) noexcept { return lhs.ptr_ <  rhs.ptr_; }
+        constexpr friend bool operator> (iterator lhs, iterator rhs) noexcept { return lhs.ptr_ >  rhs.ptr_; }
+        constexpr friend bool operator<=(iterator lhs, iterator rhs) noexcept { return lhs.ptr_ <= rhs.ptr_; }
+        constexpr friend bool operator>=(iterator lhs, iterator rhs) noexcept { return lhs.ptr_ >= rhs.ptr_; }
+    private:
+        friend class serialized_view;
+        constexpr explicit iterator(std::byte const* ptr) noexcept : ptr_{ ptr } {}
+
+        std::byte const* ptr_ = nullptr;
+    };
+
+    constexpr serialized_view() noexcept = default;
+
+    // Reads the length prefix and checks that all the elements are in the span,
+    // then moves the span past the range. The view is empty if the check fails.
+    template <class Span>
+    explicit serialized_view(Span& span) {
+        static_assert(Span::is_input, "serialized_view reads from an input span");
+        length_type length;
+        if (!serial::detail::read_length(span, length)) return;
+        auto const bytes = size_t{ length } * element_size;
+        if (!span.check(bytes)) return;
+        data_ = span.advance(bytes);
+        size_ = length;
+    }
+
+    constexpr size_type size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+
+    // The serialized elements, without the length prefix.
+    constexpr std::byte const* data() const noexcept { return data_; }
+
+    value_type operator[](size_type i) const {
+        return decode(data_ + i * element_size);
+    }
+    value_type at(size_type i) const {
+        if (i >= size_) throw std::out_of_range{ "tapeworm : serialized_view index out of range" };
+        return (*this)[i];
+    }
+    value_type front() const { return (*this)[0]; }
+    value_type back()  const { return (*this)[size_ - 1]; }
+
+    constexpr iterator begin() const noexcept { return iterator{ data_ }; }
+    constexpr iterator end()   const noexcept { return iterator{ data_ + size_ * element_size }; }
+private:
+    // The bounds have been checked at construction.
+    static value_type decode(std::byte const* ptr) {
+        input_span<span_policy::unsafe> span{ ptr, element_size };
+        return tom::deserialize<value_type>(span);
+    }
+
+    std::byte const* data_ = nullptr;
+    size_type size_ = 0;
+};
+
+} // ::tom
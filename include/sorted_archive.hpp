@@ -0,0 +1,350 @@
+
+#pragma once
+
+#include "bloom_filter.hpp"
+#include "crc32c.hpp"
+#include "dictionary.hpp"
+#include "fingerprint.hpp"
+#include "key_encoding.hpp"
+#include "mapped_file.hpp"
+#include "prefix_coding.hpp"
+#include <algorithm>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/*
+    Immutable sorted key/value files, read by point lookups on a mapped file
+    without loading the values, as the SSTables of LevelDB.
+
+    File format :
+        - the values, serialized one after another in the order of the keys.
+        - the key blocks : the keys (see key_encoding.hpp) of 'restart_interval' values, prefix coded
+          (see prefix_coding.hpp), each one followed by the size of it's value (varint).
+        - the Bloom filters of the blocks, if enabled.
+        - the index : for each block, the offset of it's keys, of it's first value and of it's filter (8 bytes each).
+        - the footer : the sizes of the regions, the number of values, the fingerprints of the key and value types,
+          the restart interval, the number of Bloom probes, the CRC32C of the keys, filters and index, and a magic number.
+
+    A lookup binary searches the first key of the blocks, checks the filter of the block, then scans at most
+    'restart_interval' keys. The value is returned as a span on the mapped bytes.
+*/
+
+namespace tom {
+
+struct archive_options {
+    size_t restart_interval = 16;   // The number of keys in a block.
+    size_t bloom_bits_per_key = 10; // The size of the Bloom filters, 0 to disable them.
+};
+
+namespace detail::archive {
+
+    constexpr std::uint32_t magic = 0x4B575441; // "ATWK"
+
+    constexpr size_t max_restart_interval = 0xFFFF;
+
+    struct block_index {
+        std::uint64_t key_offset;
+        std::uint64_t value_offset;
+        std::uint64_t filter_offset;
+    };
+
+    struct footer {
+        std::uint64_t value_size;
+        std::uint64_t key_size;
+        std::uint64_t filter_size;
+        std::uint64_t entries;
+        std::uint64_t key_fingerprint;
+        std::uint64_t value_fingerprint;
+        std::uint32_t restart_interval;
+        std::uint32_t bloom_probes;
+        std::uint32_t checksum;
+        std::uint32_t magic;
+    };
+
+    static_assert(sizeof(block_index) == 24 && sizeof(footer) == 64, "Archive structures must not be padded");
+
+    inline std::uint64_t key_hash(std::string_view key) noexcept { return dictionary::hash(key); }
+
+} // ::detail::archive
+
+// Writes a sorted archive in a stream : the values are written as they are added,
+// the keys are kept in memory until 'finish'.
+template <class Key, class Value>
+class sorted_archive_writer {
+public:
+    explicit sorted_archive_writer(std::ostream& out, archive_options options = {}) :
+        out_{ out }, options_{ options } {
+        if (options_.restart_interval == 0 || options_.restart_interval > detail::archive::max_restart_interval) {
+            throw std::invalid_argument{ "tapeworm : invalid archive restart interval" };
+        }
+    }
+
+    // Keys must be added in strictly increasing order (of their key encoding).
+    void add(Key const& key, Value const& value) {
+        key_.resize(serialized_key_size(key));
+        output_span<> key_span{ reinterpret_cast<std::byte*>(key_.data()), key_.size() };
+        serialize_key(key_span, key);
+        if (entries_ != 0 && !(previous_ < key_)) {
+            throw std::invalid_argument{ "tapeworm : archive keys must be added in increasing order" };
+        }
+
+        auto const value_size = serialized_size(value);
+        value_.resize(value_size);
+        output_span<> value_span{ value_.data(), value_size };
+        serialize(value_span, value);
+        out_.write(reinterpret_cast<char const*>(value_.data()), static_cast<std::streamsize>(value_size));
+
+        auto const restart = entries_ % options_.restart_interval == 0;
+        if (restart) {
+            finish_block();
+            index_.push_back({ keys_.size(), value_offset_, filters_.size() });
+        }
+        auto const shared = restart ? 0 : detail::prefix::shared_prefix(previous_.data(), previous_.size(), key_.data(), key_.size());
+        auto const offset = keys_.size();
+        keys_.resize(offset + detail::prefix::entry_size(shared, key_.size()) + varint_size(value_size));
+        output_span<span_policy::unsafe> entry{ keys_.data() + offset, keys_.size() - offset };
+        detail::prefix::write_entry(entry, shared, key_.data(), key_.size());
+        write_varint(entry, value_size);
+
+        if (options_.bloom_bits_per_key != 0) hashes_.push_back(detail::archive::key_hash(key_));
+        value_offset_ += value_size;
+        ++entries_;
+        previous_.swap(key_);
+    }
+
+    // Writes the keys, the filters, the index and the footer.
+    // Throws a 'serialization_error' if the stream failed.
+    void finish() {
+        finish_block();
+        auto const index_size = index_.size() * sizeof(detail::archive::block_index);
+        auto checksum = crc32c(0, keys_.data(), keys_.size());
+        checksum = crc32c(checksum, filters_.data(), filters_.size());
+        checksum = crc32c(checksum, index_.data(), index_size);
+
+        detail::archive::footer const footer{
+            value_offset_, keys_.size(), filters_.size(), entries_,
+            fingerprint_v<Key>, fingerprint_v<Value>,
+            static_cast<std::uint32_t>(options_.restart_interval),
+            options_.bloom_bits_per_key != 0 ? detail::bloom::hash_count(options_.bloom_bits_per_key) : 0,
+            checksum, detail::archive::magic
+        };
+        write(keys_.data(), keys_.size());
+        write(filters_.data(), filters_.size());
+        write(index_.data(), index_size);
+        write(&footer, sizeof(footer));
+        out_.flush();
+        if (!out_) throw serialization_error{ "tapeworm : can't write the archive" };
+    }
+private:
+    void finish_block() {
+        if (hashes_.empty()) return;
+        auto const size = detail::bloom::filter_size(hashes_.size(), options_.bloom_bits_per_key);
+        auto const probes = detail::bloom::hash_count(options_.bloom_bits_per_key);
+        auto const offset = filters_.size();
+        filters_.resize(offset + size);
+        for (auto hash : hashes_) detail::bloom::add(filters_.data() + offset, size, hash, probes);
+        hashes_.clear();
+    }
+
+    void write(void const* data, size_t size) {
+        out_.write(static_cast<char const*>(data), static_cast<std::streamsize>(size));
+    }
+
+    std::ostream& out_;
+    archive_options options_;
+    std::string key_, previous_;
+    std::vector<std::byte> value_;
+    std::vector<std::byte> keys_;
+    std::vector<std::uint8_t> filters_;
+    std::vector<std::uint64_t> hashes_;
+    std::vector<detail::archive::block_index> index_;
+    std::uint64_t value_offset_ = 0;
+    std::uint64_t entries_ = 0;
+};
+
+// Point lookups in a sorted archive, mapped from a file or on bytes which outlive it.
+template <class Key, class Value>
+class sorted_archive {
+public:
+    // A value, on the bytes of the archive.
+    using value_span = input_span<span_policy::error>;
+
+    sorted_archive() = default;
+
+    // Checks the footer, the checksum and the index. Throws a 'serialization_error' if they are invalid.
+    sorted_archive(std::byte const* data, size_t size) { load(data, size); }
+
+    // Maps the file, throws a 'std::system_error' if it can't be.
+    static sorted_archive open(std::string const& path) {
+        sorted_archive archive;
+        archive.file_ = mapped_file{ path };
+        archive.file_.advise_random();
+        archive.load(archive.file_.data(), archive.file_.size());
+        return archive;
+    }
+
+    size_t size() const noexcept { return static_cast<size_t>(footer_.entries); }
+    bool empty() const noexcept { return footer_.entries == 0; }
+
+    // The serialized value of the key, nothing being copied.
+    std::optional<value_span> find(Key const& key) const {
+        std::string encoded(serialized_key_size(key), '\0');
+        output_span<> span{ reinterpret_cast<std::byte*>(encoded.data()), encoded.size() };
+        serialize_key(span, key);
+        return find_encoded(encoded);
+    }
+    bool contains(Key const& key) const { return find(key).has_value(); }
+
+    // Deserializes the value of the key, returns false if it is absent.
+    bool get(Key const& key, Value& value) const {
+        auto span = find(key);
+        if (!span) return false;
+        deserialize(*span, value);
+        if (span->failed() || span->size() != 0) throw serialization_error{ "tapeworm : invalid archive value" };
+        return true;
+    }
+
+    // The serialized value of an encoded key (see key_encoding.hpp).
+    std::optional<value_span> find_encoded(std::string_view key) const {
+        // The last block whose first key is not greater than the key.
+        size_t low = 0, high = blocks_;
+        while (low < high) {
+            auto const mid = low + (high - low) / 2;
+            if (first_key(mid) <= key) low = mid + 1;
+            else high = mid;
+        }
+        if (low == 0) return std::nullopt;
+        auto const block = low - 1;
+        if (footer_.bloom_probes != 0) {
+            auto const filter = filter_of(block);
+            if (!detail::bloom::may_contain(filter.first, filter.second, detail::archive::key_hash(key), footer_.bloom_probes)) {
+                return std::nullopt;
+            }
+        }
+        std::optional<value_span> found;
+        scan_block(block, [&] (std::string_view current, value_span value) {
+            if (current < key) return true;
+            if (current == key) found = value;
+            return false;
+        });
+        return found;
+    }
+
+    // Calls 'f(encoded_key, value_span)' on all the values, in order of the keys.
+    template <class F>
+    void for_each(F&& f) const {
+        for (size_t block = 0; block < blocks_; ++block) {
+            scan_block(block, [&] (std::string_view key, value_span value) {
+                f(key, value);
+                return true;
+            });
+        }
+    }
+private:
+    void load(std::byte const* data, size_t size) {
+        using detail::archive::footer;
+        using detail::archive::block_index;
+        auto const invalid = [] { throw serialization_error{ "tapeworm : invalid archive" }; };
+        if (size < sizeof(footer)) invalid();
+        std::memcpy(&footer_, data + size - sizeof(footer), sizeof(footer));
+        // The footer is not checksummed : the values bounding the work of a lookup are checked against the limits of the writer.
+        if (footer_.magic != detail::archive::magic || footer_.restart_interval == 0 ||
+            footer_.restart_interval > detail::archive::max_restart_interval || footer_.bloom_probes > detail::bloom::max_hash_count) {
+            invalid();
+        }
+        if (footer_.key_fingerprint != fingerprint_v<Key> || footer_.value_fingerprint != fingerprint_v<Value>) {
+            throw serialization_error{ "tapeworm : schema fingerprint mismatch" };
+        }
+
+        // Each region is checked to fit in the rest of the file, against overflows.
+        auto rest = size - sizeof(footer);
+        for (auto region : { footer_.value_size, footer_.key_size, footer_.filter_size }) {
+            if (region > rest) invalid();
+            rest -= static_cast<size_t>(region);
+        }
+        if (footer_.entries > footer_.key_size) invalid();
+        blocks_ = detail::prefix::restart_count(static_cast<size_t>(footer_.entries), footer_.restart_interval);
+        if (rest != blocks_ * sizeof(block_index)) invalid();
+
+        values_ = data;
+        keys_ = values_ + footer_.value_size;
+        filters_ = reinterpret_cast<std::uint8_t const*>(keys_ + footer_.key_size);
+        index_ = reinterpret_cast<std::byte const*>(filters_) + footer_.filter_size;
+        auto checksum = crc32c(0, keys_, static_cast<size_t>(footer_.key_size + footer_.filter_size));
+        checksum = crc32c(checksum, index_, rest);
+        if (checksum != footer_.checksum) invalid();
+
+        for (size_t i = 0; i < blocks_; ++i) {
+            auto const block = block_at(i);
+            auto const next = i + 1 < blocks_ ? block_at(i + 1) : block_index{ footer_.key_size, footer_.value_size, footer_.filter_size };
+            if (block.key_offset >= next.key_offset || block.value_offset > next.value_offset || block.filter_offset > next.filter_offset ||
+                (i == 0 && (block.key_offset != 0 || block.value_offset != 0 || block.filter_offset != 0)) ||
+                (footer_.bloom_probes != 0 && block.filter_offset == next.filter_offset)) {
+                invalid();
+            }
+        }
+    }
+
+    detail::archive::block_index block_at(size_t i) const noexcept {
+        detail::archive::block_index block;
+        std::memcpy(&block, index_ + i * sizeof(block), sizeof(block));
+        return block;
+    }
+
+    value_span keys_of(size_t block) const noexcept {
+        auto const begin = block_at(block).key_offset;
+        auto const end = block + 1 < blocks_ ? block_at(block + 1).key_offset : footer_.key_size;
+        return { keys_ + begin, static_cast<size_t>(end - begin) };
+    }
+
+    std::pair<std::uint8_t const*, size_t> filter_of(size_t block) const noexcept {
+        auto const begin = block_at(block).filter_offset;
+        auto const end = block + 1 < blocks_ ? block_at(block + 1).filter_offset : footer_.filter_size;
+        return { filters_ + begin, static_cast<size_t>(end - begin) };
+    }
+
+    // The first key of a block, which shares no prefix. Empty if the block is corrupted.
+    std::string_view first_key(size_t block) const {
+        auto span = keys_of(block);
+        detail::prefix::entry entry;
+        if (!detail::prefix::read_entry(span, 0, true, entry)) return {};
+        return { entry.rest, entry.size };
+    }
+
+    // Calls 'f(key, value_span)' on the values of a block while it returns true.
+    // Throws a 'serialization_error' if the block is corrupted.
+    template <class F>
+    void scan_block(size_t block, F&& f) const {
+        auto span = keys_of(block);
+        auto value_offset = block_at(block).value_offset;
+        auto const count = std::min<std::uint64_t>(footer_.restart_interval, footer_.entries - block * footer_.restart_interval);
+        std::string key;
+        detail::prefix::entry entry;
+        for (size_t i = 0; i < count; ++i) {
+            std::uint64_t value_size = 0;
+            if (detail::prefix::read_entry(span, key.size(), i == 0, entry)) read_varint(span, value_size);
+            if (span.failed() || value_size > footer_.value_size - value_offset) {
+                throw serialization_error{ "tapeworm : invalid archive keys" };
+            }
+            key.resize(entry.shared);
+            key.append(entry.rest, entry.size);
+            if (!f(std::string_view{ key }, value_span{ values_ + value_offset, static_cast<size_t>(value_size) })) return;
+            value_offset += value_size;
+        }
+    }
+
+    mapped_file file_;
+    detail::archive::footer footer_{};
+    std::byte const* values_ = nullptr;
+    std::byte const* keys_ = nullptr;
+    std::uint8_t const* filters_ = nullptr;
+    std::byte const* index_ = nullptr;
+    size_t blocks_ = 0;
+};
+
+} // ::tom
@@ -1,7 +1,10 @@
 
 #pragma once
 
+#include <cstddef>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 
 namespace tom {
 
@@ -31,7 +34,7 @@ namespace tom {
         template <class...Ts>
         struct static_visitor_expression : std::tuple<Ts&...> {
             template <class, class>
-            friend class concept::static_visitable;
+            friend struct concept::static_visitable;
         public:
             static constexpr auto is_visitor_expression = true;
 
@@ -96,6 +99,8 @@ namespace tom {
 
             using seq_type = std::make_index_sequence<expression_t::tuple_size>;
         public:
+            static constexpr auto is_implemented = true;
+
             static constexpr auto as_tuple(T& value) noexcept {
                 return make_expression(value).lref_tuple(seq_type{});
             }
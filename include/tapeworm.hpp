@@ -1,2 +1,22 @@
 
 #pragma once
+
+#include "serialization.hpp"
+#include "block_compression.hpp"
+#include "columnar_archive.hpp"
+#include "decode_limits.hpp"
+#include "delta.hpp"
+#include "dictionary_view.hpp"
+#include "evolution.hpp"
+#include "external_sort.hpp"
+#include "field_mask.hpp"
+#include "filter.hpp"
+#include "fingerprint.hpp"
+#include "key_encoding.hpp"
+#include "framing.hpp"
+#include "parallel_compression.hpp"
+#include "prefix_view.hpp"
+#include "scan.hpp"
+#include "serialized_view.hpp"
+#include "sorted_archive.hpp"
+#include "validation.hpp"
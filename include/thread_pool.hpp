@@ -0,0 +1,68 @@
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tom {
+
+// A fixed set of threads running the submitted jobs in order of submission.
+class thread_pool {
+public:
+    explicit thread_pool(size_t threads = std::thread::hardware_concurrency()) {
+        threads = std::max(threads, size_t{ 1 });
+        workers_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { run(); });
+        }
+    }
+    // Waits for the submitted jobs.
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            stopped_ = true;
+        }
+        condition_.notify_all();
+        for (auto& worker : workers_) worker.join();
+    }
+    thread_pool(thread_pool const&) = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+
+    size_t size() const noexcept { return workers_.size(); }
+
+    // Jobs must not throw.
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            jobs_.push_back(std::move(job));
+        }
+        condition_.notify_one();
+    }
+private:
+    void run() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock{ mutex_ };
+                condition_.wait(lock, [this] { return stopped_ || !jobs_.empty(); });
+                if (jobs_.empty()) return;
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> jobs_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stopped_ = false;
+};
+
+} // ::tom
@@ -3,6 +3,7 @@
 
 #include "static_visit.hpp"
 #include "aggregate_to_tuple.hpp"
+#include "priority_concept.hpp"
 
 /*
 Concepts interface :
@@ -25,15 +26,15 @@ namespace concept {
 
 // Implemented for types with the form Tuple<Ts...> with
 // std::get<I>(tuple) and std::tuple_size_v<Tuple<Ts...>>.
-template <class T, class SFINAE>
+template <class T, class SFINAE = void>
 struct tuple {
     static constexpr auto is_implemented = false;
 };
 
 template <template <class...> class Tuple, class...Ts>
 struct tuple<Tuple<Ts...>, std::void_t<
-    std::get<sizeof...(Ts) - 1>(std::declval<Tuple<Ts...>>()),
-    tuple_size_v<Tuple<Ts...>>
+    decltype(std::get<sizeof...(Ts) - 1>(std::declval<Tuple<Ts...>>())),
+    decltype(std::tuple_size<Tuple<Ts...>>::value)
 >> {
 private:
     template <class T>
@@ -88,6 +89,7 @@ template <class T, class = std::enable_if_t<
     is_aggregate_v<T>
 >>
 struct aggregate {
+private:
     template <class Tuple, class Seq>
     struct seq {};
     template <class...Ts, size_t...Is>
@@ -116,11 +118,13 @@ struct aggregate {
             return { std::move(std::get<Is>(tuple))... };
         }
     };
-    using seq_t = seq<as_tuple_t<T>, std::make_index_sequence<sizeof...(Ts)>>;*
+    using seq_t = seq<as_tuple_t<T>, std::make_index_sequence<std::tuple_size_v<as_tuple_t<T>>>>;
 public:
+    static constexpr auto is_implemented = true;
+
     static constexpr auto tuple_size = seq_t::tuple_size;
 
-    using tuple_type = seq_t::tuple_type;
+    using tuple_type = typename seq_t::tuple_type;
 
     static constexpr auto as_tuple(T& agg) noexcept {
         return seq_t::as_tuple(agg);
@@ -142,5 +146,10 @@ public:
 
 } // ::concept
 
+// Concepts giving a tuple interface to a type, the best one is picked.
+using tuple_concepts = build_concept_list
+    <concept::static_visitable, 3>::add
+    <concept::tuple,            2>::add
+    <concept::aggregate,        1>;
 
 } // ::tom
@@ -0,0 +1,191 @@
+
+#pragma once
+
+#include "decode_limits.hpp"
+
+/*
+    Validates a serialized T once, then decodes it any number of times without checks.
+
+    The validation walks the buffer like 'skip' : every length prefix, optional flag and bound
+    is checked, without allocating nor constructing anything. Bytes of booleans are checked
+    too, since decoding another value than 0 or 1 in a bool is undefined behaviour.
+
+    if (auto const message = tom::validate<message_type>(span)) {
+        auto const value = message->deserialize();
+        ...
+    }
+*/
+
+namespace tom {
+
+namespace detail::validation {
+
+    // True if T is a bool or an array of bools.
+    template <class T>
+    constexpr bool is_bool_v = std::is_same_v<T, bool>;
+    template <class T, size_t Size>
+    constexpr bool is_bool_v<T [Size]> = is_bool_v<T>;
+    template <class T, size_t Size>
+    constexpr bool is_bool_v<std::array<T, Size>> = is_bool_v<T>;
+
+    template <class Tree>
+    struct tree_info {};
+
+    template <class T, class Concept>
+    struct tree_info<expression::leaf<T, Concept>> {
+        static constexpr bool has_bool = is_bool_v<T>;
+        static constexpr int depth = 0;
+    };
+    template <class T, class Concept, class...Trees>
+    struct tree_info<expression::node<T, Concept, Trees...>> {
+        static constexpr bool has_bool = (false || ... || tree_info<Trees>::has_bool);
+        static constexpr int depth = 1 + std::max({ 0, tree_info<Trees>::depth... });
+    };
+
+    template <class Span>
+    void check_bools(Span& span, std::byte const* bytes, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (static_cast<std::uint8_t>(bytes[i]) > 1) {
+                span.fail("tapeworm : invalid boolean");
+                return;
+            }
+        }
+    }
+
+    template <class Span>
+    void check_bools(Span& span, size_t count) {
+        if (span.check(count)) check_bools(span, span.advance(count), count);
+    }
+
+    template <class Tree, class Span>
+    void walk(Span& span);
+
+    template <class...Trees, class Span>
+    void walk_members(type_tag<std::tuple<Trees...>>, Span& span) {
+        (walk<Trees>(span), ...);
+    }
+
+    // The members of a record of a dictionary, the strings being indices in it.
+    template <class Concept, class...Trees, class Span>
+    void walk_record(type_tag<std::tuple<Trees...>>, Span& span, size_t entries) {
+        ([&] {
+            if (span.failed()) return;
+            if constexpr (serial::detail::is_string_like_v<typename expression::traits<Trees>::type>) {
+                Concept::read_index(span, entries);
+            }
+            else walk<Trees>(span);
+        }(), ...);
+    }
+
+    // Skips the value described by the tree, checking the bytes of booleans on the way.
+    template <class Tree, class Span>
+    void walk(Span& span) {
+        using traits = expression::traits<Tree>;
+        using type   = typename traits::type;
+        if constexpr (!tree_info<Tree>::has_bool) {
+            tom::skip<type>(span);
+        }
+        else if constexpr (uses_concept_v<type, serial::concept::trivially_serializable>) {
+            check_bools(span, sizeof(type));
+        }
+        else if constexpr (uses_concept_v<type, serial::concept::trivial_array>) {
+            length_type length;
+            if (!serial::detail::read_length(span, length)) return;
+            using value_type = typename expression::traits<expression::child_t<Tree, 0>>::type;
+            check_bools(span, size_t{ length } * sizeof(value_type));
+        }
+        else if constexpr (uses_concept_v<type, serial::concept::run_length_encoding>) {
+            serial_concept_t<type>::skip(span, [&span] (std::byte const* values, size_t count) {
+                check_bools(span, values, count * sizeof(typename serial_concept_t<type>::value_type));
+            });
+        }
+        else if constexpr (uses_concept_v<type, serial::concept::dictionary_encoding>) {
+            // Only records hold booleans.
+            using concept_type = serial_concept_t<type>;
+            using record = typename expression::traits<expression::child_t<Tree, 0>>::children;
+            std::vector<std::string_view> entries;
+            length_type length;
+            if (!concept_type::read_dictionary(span, length, entries)) return;
+            for (length_type i = 0; i < length && !span.failed(); ++i) {
+                walk_record<concept_type>(type_tag<record>{}, span, entries.size());
+            }
+        }
+        else if constexpr (uses_concept_v<type, serial::concept::optional>) {
+            std::uint8_t flag = 0;
+            span.read_value(flag);
+            if (span.failed()) return;
+            if (flag == 1) {
+                walk<expression::child_t<Tree, 0>>(span);
+            }
+            else if (flag != 0) span.fail("tapeworm : invalid optional flag");
+        }
+        else if constexpr (uses_concept_v<type, serial::concept::tuple_like>) {
+            walk_members(type_tag<typename traits::children>{}, span);
+        }
+        else if constexpr (uses_concept_v<type, serial::concept::range>) {
+            length_type length;
+            if (!serial::detail::read_length(span, length)) return;
+            for (length_type i = 0; i < length && !span.failed(); ++i) {
+                walk<expression::child_t<Tree, 0>>(span);
+            }
+        }
+        // The other encodings (delta, xor, prefix, adaptive, frame of reference) hold no booleans.
+        else static_assert(always_false_v<type>, "The validation doesn't handle the encoding of T");
+    }
+
+} // ::detail::validation
+
+// The number of nested nodes in the expression tree of T, 0 for numbers.
+template <class T>
+constexpr int nesting_depth_v = detail::validation::tree_info<expression_tree_t<T>>::depth;
+
+// A buffer holding a valid serialized T, which can be decoded without checks.
+template <class T>
+class validated {
+public:
+    constexpr std::byte const* data() const noexcept { return data_; }
+    constexpr size_t size() const noexcept { return size_; }
+
+    input_span<span_policy::unsafe> span() const noexcept {
+        return { data_, size_ };
+    }
+
+    void deserialize(T& value) const {
+        auto span = this->span();
+        tom::deserialize(span, value);
+    }
+    T deserialize() const {
+        auto span = this->span();
+        return tom::deserialize<T>(span);
+    }
+private:
+    template <class U, class Span>
+    friend std::optional<validated<U>> validate(Span& span, int max_depth);
+
+    constexpr validated(std::byte const* data, size_t size) noexcept :
+        data_{ data }, size_{ size } {}
+
+    std::byte const* data_;
+    size_t size_;
+};
+
+// Checks that the span starts with a valid serialized T, nested at most 'max_depth' times.
+// On success the span is moved past it, otherwise the span fails and nothing is returned.
+template <class T, class Span>
+std::optional<validated<T>> validate(Span& span, int max_depth = default_max_depth) {
+    static_assert(Span::is_input, "Only input spans can be validated");
+    if (nesting_depth_v<T> > max_depth) {
+        span.fail("tapeworm : nesting limit exceeded");
+        return std::nullopt;
+    }
+    input_span<span_policy::error> walker{ span.begin(), span.end() };
+    detail::validation::walk<expression_tree_t<T>>(walker);
+    if (walker.failed()) {
+        span.fail("tapeworm : invalid serialized value");
+        return std::nullopt;
+    }
+    auto const size = static_cast<size_t>(walker.begin() - span.begin());
+    return validated<T>{ span.advance(size), size };
+}
+
+} // ::tom
@@ -0,0 +1,60 @@
+
+#pragma once
+
+#include "io_span.hpp"
+#include <cstdint>
+
+namespace tom {
+
+// LEB128 variable-length integers : 7 bits per byte, the high bit is set on all bytes but the last.
+
+constexpr size_t max_varint_size = 10;
+
+constexpr size_t varint_size(std::uint64_t value) noexcept {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+// Maps signed integers to unsigned ones so that small absolute values stay small.
+constexpr std::uint64_t zigzag_encode(std::int64_t value) noexcept {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+constexpr std::int64_t zigzag_decode(std::uint64_t value) noexcept {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+// Encodes in 'dst' which must hold at least 'max_varint_size' bytes, returns the size written.
+inline size_t encode_varint(std::uint8_t* dst, std::uint64_t value) noexcept {
+    size_t size = 0;
+    while (value >= 0x80) {
+        dst[size++] = static_cast<std::uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    dst[size++] = static_cast<std::uint8_t>(value);
+    return size;
+}
+
+template <class Span>
+void write_varint(Span& span, std::uint64_t value) {
+    std::uint8_t bytes[max_varint_size];
+    span.write(bytes, encode_varint(bytes, value));
+}
+
+// The span fails on truncated input or on encodings longer than 'max_varint_size'.
+template <class Span>
+void read_varint(Span& span, std::uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 7 * max_varint_size; shift += 7) {
+        if (!span.check(1)) return;
+        auto const byte = static_cast<std::uint8_t>(*span.advance(1));
+        value |= std::uint64_t{ byte & 0x7Fu } << shift;
+        if (byte < 0x80) return;
+    }
+    span.fail("tapeworm : invalid varint");
+}
+
+} // ::tom
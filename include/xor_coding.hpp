@@ -0,0 +1,125 @@
+
+#pragma once
+
+#include "bit_span.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/*
+    Kernels of the XOR encoding of floating-point series, from Facebook's Gorilla.
+
+    The first value is written raw, then each value is XORed with the previous one :
+        - '0'                 : the same value.
+        - '1' '0' + bits      : the meaningful bits fit in the window of the previous XOR.
+        - '1' '1' + leading zeros (5 bits) + meaningful length - 1 (6 bits, 5 for floats) + bits
+    The leading zeros are capped to 31.
+*/
+
+namespace tom {
+
+namespace detail::xor_coding {
+
+    template <class Float>
+    using bits_type = std::conditional_t<sizeof(Float) == 8, std::uint64_t, std::uint32_t>;
+
+    constexpr unsigned leading_bits = 5;
+    constexpr unsigned max_leading  = 31;
+
+    template <class U>
+    constexpr unsigned length_bits = sizeof(U) == 8 ? 6 : 5;
+
+    template <class U>
+    unsigned leading_zeros(U value) noexcept {
+    #if defined(__GNUC__) || defined(__clang__)
+        if constexpr (sizeof(U) == 8) return static_cast<unsigned>(__builtin_clzll(value));
+        else return static_cast<unsigned>(__builtin_clz(value));
+    #else
+        unsigned count = 0;
+        for (auto bit = U{ 1 } << (8 * sizeof(U) - 1); (value & bit) == 0; bit >>= 1) ++count;
+        return count;
+    #endif
+    }
+
+    template <class U>
+    unsigned trailing_zeros(U value) noexcept {
+    #if defined(__GNUC__) || defined(__clang__)
+        if constexpr (sizeof(U) == 8) return static_cast<unsigned>(__builtin_ctzll(value));
+        else return static_cast<unsigned>(__builtin_ctz(value));
+    #else
+        unsigned count = 0;
+        for (; (value & 1) == 0; value >>= 1) ++count;
+        return count;
+    #endif
+    }
+
+    // Writes 'count' (> 0) values in the bit stream.
+    template <class Float, class Writer>
+    void encode(Float const* values, size_t count, Writer& writer) {
+        using U = bits_type<Float>;
+        constexpr unsigned bits = 8 * sizeof(U);
+        auto const load = [values] (size_t i) noexcept {
+            U value;
+            std::memcpy(&value, values + i, sizeof(U));
+            return value;
+        };
+        auto prev = load(0);
+        writer.write(prev, bits);
+
+        // The window of meaningful bits of the previous XOR, none at first.
+        unsigned leading = bits, trailing = 0;
+        for (size_t i = 1; i < count; ++i) {
+            auto const value = load(i);
+            auto const x = static_cast<U>(value ^ prev);
+            prev = value;
+            if (x == 0) {
+                writer.write(0, 1);
+                continue;
+            }
+            auto const new_leading = std::min(leading_zeros(x), max_leading);
+            auto const new_trailing = trailing_zeros(x);
+            if (new_leading >= leading && new_trailing >= trailing) {
+                writer.write(0b01, 2);
+                writer.write(x >> trailing, bits - leading - trailing);
+                continue;
+            }
+            leading = new_leading;
+            trailing = new_trailing;
+            auto const length = bits - leading - trailing;
+            writer.write(0b11 | leading << 2 | (length - 1) << (2 + leading_bits), 2 + leading_bits + length_bits<U>);
+            writer.write(x >> trailing, length);
+        }
+    }
+
+    // Reads 'count' (> 0) values from the bit stream, returns false if it is invalid.
+    template <class Float, class Reader>
+    bool decode(Reader& reader, size_t count, Float* values) {
+        using U = bits_type<Float>;
+        constexpr unsigned bits = 8 * sizeof(U);
+        auto const store = [values] (size_t i, U value) noexcept {
+            std::memcpy(values + i, &value, sizeof(U));
+        };
+        auto prev = static_cast<U>(reader.read(bits));
+        store(0, prev);
+
+        unsigned leading = bits, trailing = 0;
+        for (size_t i = 1; i < count; ++i) {
+            if (reader.read_bit()) {
+                if (reader.read_bit()) {
+                    leading = static_cast<unsigned>(reader.read(leading_bits));
+                    auto const length = static_cast<unsigned>(reader.read(length_bits<U>)) + 1;
+                    if (leading + length > bits) return false;
+                    trailing = bits - leading - length;
+                }
+                else if (leading == bits) return false;
+                prev ^= static_cast<U>(reader.read(bits - leading - trailing) << trailing);
+            }
+            store(i, prev);
+        }
+        return true;
+    }
+
+} // ::detail::xor_coding
+
+} // ::tom
@@ -0,0 +1,115 @@
+#include "catch.hpp"
+#include "helpers.hpp"
+
+#include <fingerprint.hpp>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+    using tom::detail::adaptive::block_codec;
+
+    // Each block follows another distribution, so that each codec is used.
+    template <class Int>
+    std::vector<Int> mixed_values(size_t length, std::mt19937_64& random) {
+        using limits = std::numeric_limits<Int>;
+        std::vector<Int> values(length);
+        for (size_t i = 0; i < length; ++i) {
+            switch (i / 128 % 5) {
+                case 0: values[i] = static_cast<Int>(random()); break;
+                case 1: values[i] = static_cast<Int>(random() % 200) - (std::is_signed_v<Int> ? 100 : 0); break;
+                case 2: values[i] = static_cast<Int>(limits::max() - static_cast<Int>(random() % 16)); break;
+                case 3: values[i] = static_cast<Int>(i / 40); break;
+                case 4: values[i] = static_cast<Int>(static_cast<std::uint64_t>(limits::min()) + i * 1000 + random() % 3); break;
+            }
+        }
+        return values;
+    }
+
+    template <class Int>
+    void check_round_trips() {
+        std::mt19937_64 random{ sizeof(Int) };
+        for (size_t length : { 0, 1, 2, 127, 128, 129, 1000 }) {
+            tom::adaptive_coded<std::vector<Int>> values{ mixed_values<Int>(length, random) };
+            CHECK(round_trip(values) == values);
+        }
+    }
+
+    template <class Int>
+    block_codec codec_of(std::vector<Int> const& values) {
+        size_t encoded;
+        return tom::detail::adaptive::choose_codec(values.data(), values.size(), encoded);
+    }
+}
+
+TEST_CASE("Adaptive codec choice") {
+    std::vector<std::uint64_t> values(128);
+    std::mt19937_64 random{ 3 };
+
+    for (auto& value : values) value = random();
+    CHECK(codec_of(values) == block_codec::raw);
+
+    for (auto& value : values) value = random() % 100;
+    values[7] = 1ull << 40;
+    CHECK(codec_of(values) == block_codec::varint);
+
+    for (auto& value : values) value = (1ull << 60) + random() % 100;
+    CHECK(codec_of(values) == block_codec::frame_of_reference);
+
+    for (size_t i = 0; i < values.size(); ++i) values[i] = i / 64;
+    CHECK(codec_of(values) == block_codec::runs);
+
+    for (size_t i = 0; i < values.size(); ++i) values[i] = (1ull << 60) + i * 1000 + random() % 3;
+    CHECK(codec_of(values) == block_codec::delta);
+}
+
+TEST_CASE("Adaptive encoding") {
+    static_assert(tom::uses_concept_v<tom::adaptive_coded<std::vector<int>>, tom::serial::concept::adaptive_encoding>);
+    static_assert(!tom::uses_concept_v<tom::adaptive_coded<std::vector<float>>, tom::serial::concept::adaptive_encoding>);
+    static_assert(!tom::uses_concept_v<tom::adaptive_coded<std::vector<bool>>, tom::serial::concept::adaptive_encoding>);
+
+    check_round_trips<std::int8_t>();
+    check_round_trips<std::uint16_t>();
+    check_round_trips<std::int32_t>();
+    check_round_trips<std::uint32_t>();
+    check_round_trips<std::int64_t>();
+    check_round_trips<std::uint64_t>();
+
+    // Never larger than the raw values and a byte per block.
+    std::mt19937_64 random{ 17 };
+    tom::adaptive_coded<std::vector<std::int64_t>> values{ mixed_values<std::int64_t>(1280, random) };
+    auto const raw_size = tom::serialized_size(std::vector<std::int64_t>(values));
+    CHECK(tom::serialized_size(values) <= raw_size + 10);
+    CHECK(tom::serialized_size(values) * 2 < raw_size);
+
+    CHECK(tom::fingerprint_v<decltype(values)> != tom::fingerprint_v<std::vector<std::int64_t>>);
+}
+
+TEST_CASE("Adaptive encoding corruptions") {
+    tom::adaptive_coded<std::vector<std::uint16_t>> values(200, 5);
+    std::fill(values.begin() + 100, values.end(), 60'000);
+    std::vector<std::byte> bytes(tom::serialized_size(values));
+    tom::output_span<> out{ bytes.data(), bytes.size() };
+    tom::serialize(out, values);
+    CHECK(bytes[4] == std::byte{ static_cast<std::uint8_t>(block_codec::runs) });
+
+    auto const check_failure = [] (std::vector<std::byte> const& corrupted) {
+        tom::input_span<tom::span_policy::error> in{ corrupted.data(), corrupted.size() };
+        tom::adaptive_coded<std::vector<std::uint16_t>> result;
+        tom::deserialize(in, result);
+        CHECK(in.failed());
+    };
+    auto corrupted = bytes;
+    corrupted[4] = std::byte{ 5 }; // The codec of the first block.
+    check_failure(corrupted);
+
+    corrupted = bytes;
+    corrupted[6] = std::byte{ 120 }; // The length of the first run.
+    check_failure(corrupted);
+
+    corrupted = bytes;
+    corrupted[4] = std::byte{ static_cast<std::uint8_t>(block_codec::frame_of_reference) };
+    corrupted[4 + 1 + 2] = std::byte{ 17 }; // The width.
+    check_failure(corrupted);
+}
@@ -0,0 +1,94 @@
+#include "catch.hpp"
+#include "helpers.hpp"
+
+#include <fingerprint.hpp>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+    struct counters {
+        std::uint16_t kind;
+        tom::bit_packed<std::vector<std::uint32_t>> ids;
+        tom::bit_packed<std::vector<std::int64_t>> deltas;
+    };
+
+    template <class Int>
+    void check_round_trips() {
+        using limits = std::numeric_limits<Int>;
+        constexpr unsigned bits = 8 * sizeof(Int);
+        std::mt19937_64 random{ sizeof(Int) };
+        for (size_t length : { 0, 1, 127, 128, 129, 300, 1000 }) {
+            for (unsigned width : { 0u, 1u, 5u, bits - 1, bits }) {
+                tom::bit_packed<std::vector<Int>> values(length);
+                auto const base = static_cast<Int>(random());
+                for (auto& value : values) {
+                    auto const offset = width == 0 ? 0 : random() >> (64 - width);
+                    value = static_cast<Int>(static_cast<std::uint64_t>(base) + offset);
+                }
+                if (length > 2) {
+                    values[0] = limits::min();
+                    values[1] = limits::max();
+                }
+                CHECK(round_trip(values) == values);
+            }
+        }
+    }
+}
+
+TEST_CASE("Bit packing kernels") {
+    namespace impl = tom::detail::packing;
+    std::mt19937 random{ 3 };
+    for (unsigned width = 0; width <= 32; ++width) {
+        std::uint32_t values[impl::packed_block], packed[impl::packed_block], scalar[impl::packed_block];
+        for (auto& value : values) value = random() & impl::low_mask(width);
+
+        impl::pack(values, packed, width);
+        impl::pack_scalar(values, scalar, width);
+        CHECK(std::equal(packed, packed + 4 * width, scalar));
+
+        std::uint32_t unpacked[impl::packed_block], unpacked_scalar[impl::packed_block];
+        impl::unpack(packed, unpacked, width);
+        impl::unpack_scalar(packed, unpacked_scalar, width);
+        CHECK(std::equal(values, values + impl::packed_block, unpacked));
+        CHECK(std::equal(values, values + impl::packed_block, unpacked_scalar));
+    }
+}
+
+TEST_CASE("Frame-of-reference encoding") {
+    static_assert(tom::uses_concept_v<tom::bit_packed<std::vector<int>>, tom::serial::concept::frame_of_reference>);
+    static_assert(tom::uses_concept_v<std::vector<int>, tom::serial::concept::trivial_array>);
+    static_assert(!tom::uses_concept_v<tom::bit_packed<std::vector<bool>>, tom::serial::concept::frame_of_reference>);
+
+    check_round_trips<std::int8_t>();
+    check_round_trips<std::uint16_t>();
+    check_round_trips<std::int32_t>();
+    check_round_trips<std::uint64_t>();
+    check_round_trips<std::int64_t>();
+
+    // Ids close to each other take a few bits each.
+    counters value{ 3, {}, {} };
+    for (std::uint32_t i = 0; i < 1000; ++i) {
+        value.ids.push_back(1'000'000 + i * 7 % 1000);
+        value.deltas.push_back(static_cast<std::int64_t>(i % 50) - 25);
+    }
+    CHECK(tom::serialized_size(value) * 3 < tom::serialized_size(std::make_tuple(
+        value.kind, std::vector<std::uint32_t>(value.ids), std::vector<std::int64_t>(value.deltas))));
+    auto const result = round_trip(value);
+    CHECK(result.ids == value.ids);
+    CHECK(result.deltas == value.deltas);
+    CHECK(tom::fingerprint_v<counters> != tom::fingerprint_v<std::tuple<std::uint16_t, std::vector<std::uint32_t>, std::vector<std::int64_t>>>);
+}
+
+TEST_CASE("Frame-of-reference corruptions") {
+    tom::bit_packed<std::vector<std::uint32_t>> values(200, 5);
+    std::vector<std::byte> bytes(tom::serialized_size(values));
+    tom::output_span<> out{ bytes.data(), bytes.size() };
+    tom::serialize(out, values);
+
+    bytes[4 + 4] = std::byte{ 33 }; // The width of the first block.
+    tom::input_span<tom::span_policy::error> in{ bytes.data(), bytes.size() };
+    tom::bit_packed<std::vector<std::uint32_t>> result;
+    tom::deserialize(in, result);
+    CHECK(in.failed());
+}
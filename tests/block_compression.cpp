@@ -0,0 +1,156 @@
+#include "catch.hpp"
+
+#include <block_compression.hpp>
+#include <decode_limits.hpp>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    struct sample {
+        std::uint32_t id;
+        std::string name;
+        std::vector<std::int32_t> values;
+    };
+
+    std::vector<sample> make_samples(size_t count) {
+        std::vector<sample> samples(count);
+        for (size_t i = 0; i < count; ++i) {
+            samples[i].id = static_cast<std::uint32_t>(i);
+            samples[i].name = "sample_" + std::to_string(i % 100);
+            samples[i].values.assign(i % 13, static_cast<std::int32_t>(i % 7));
+        }
+        return samples;
+    }
+
+    // A header followed by 'count' compressed blocks of one byte.
+    std::vector<std::byte> hostile_blocks(tom::length_type block_size, std::uint64_t size, size_t count) {
+        std::vector<std::byte> bytes(sizeof(block_size) + sizeof(size) + count * (sizeof(tom::length_type) + 1));
+        std::memcpy(bytes.data(), &block_size, sizeof(block_size));
+        std::memcpy(bytes.data() + sizeof(block_size), &size, sizeof(size));
+        for (size_t i = 0; i < count; ++i) {
+            bytes[sizeof(block_size) + sizeof(size) + i * (sizeof(tom::length_type) + 1)] = std::byte{ 1 };
+        }
+        return bytes;
+    }
+
+    std::vector<std::byte> lz_round_trip(std::vector<std::byte> const& input) {
+        std::vector<std::byte> compressed(input.size() + input.size() / 255 + 16);
+        auto const size = tom::lz_codec::compress(input.data(), input.size(), compressed.data(), compressed.size());
+        REQUIRE(size != 0);
+        std::vector<std::byte> output(input.size());
+        CHECK(tom::lz_codec::decompress(compressed.data(), size, output.data(), output.size()));
+        return output;
+    }
+}
+
+TEST_CASE("LZ codec") {
+    std::mt19937 random{ 42 };
+    for (size_t size : { 0, 1, 12, 13, 100, 5000, 100000 }) {
+        std::vector<std::byte> repeated(size), noisy(size);
+        for (size_t i = 0; i < size; ++i) {
+            repeated[i] = static_cast<std::byte>("tapeworm"[i % 8] + i / 1000);
+            noisy[i] = static_cast<std::byte>(random());
+        }
+        CHECK(lz_round_trip(repeated) == repeated);
+        CHECK(lz_round_trip(noisy) == noisy);
+    }
+    // Overlapping matches and long lengths.
+    std::vector<std::byte> zeros(70000);
+    CHECK(lz_round_trip(zeros) == zeros);
+
+    // Too small outputs and corrupted inputs are rejected.
+    std::vector<std::byte> compressed(zeros.size());
+    auto const size = tom::lz_codec::compress(zeros.data(), zeros.size(), compressed.data(), compressed.size());
+    REQUIRE(size < 1000);
+    CHECK(tom::lz_codec::compress(zeros.data(), zeros.size(), compressed.data(), size - 1) == 0);
+    std::vector<std::byte> output(zeros.size());
+    CHECK(!tom::lz_codec::decompress(compressed.data(), size - 1, output.data(), output.size()));
+    CHECK(!tom::lz_codec::decompress(compressed.data(), size, output.data(), output.size() - 1));
+}
+
+TEST_CASE("Block compression") {
+    auto const samples = make_samples(5000);
+    auto const raw_size = tom::serialized_size(samples);
+
+    std::vector<std::byte> bytes(tom::compressed_bound(raw_size, 4096));
+    tom::output_span<> out{ bytes.data(), bytes.size() };
+    tom::serialize_compressed(out, samples, 4096);
+    auto const compressed_size = bytes.size() - out.size();
+    CHECK(compressed_size * 3 < raw_size);
+
+    tom::input_span<> in{ bytes.data(), compressed_size };
+    CHECK(tom::decompressed_size(in) == raw_size);
+    std::vector<sample> result;
+    tom::deserialize_compressed(in, result);
+    CHECK(in.size() == 0);
+    CHECK(tom::serialized_equal(result, samples));
+
+    // Streamed decompression.
+    std::vector<std::byte> streamed;
+    size_t blocks = 0;
+    tom::input_span<> stream{ bytes.data(), compressed_size };
+    tom::for_each_block(stream, [&] (std::byte const* data, size_t size) {
+        streamed.insert(streamed.end(), data, data + size);
+        ++blocks;
+    });
+    CHECK(blocks == (raw_size + 4095) / 4096);
+    CHECK(streamed.size() == raw_size);
+
+    // Corruptions are detected.
+    for (size_t offset : { size_t{ 4 }, size_t{ 12 }, compressed_size / 2 }) {
+        auto copy = bytes;
+        copy[offset] ^= std::byte{ 0x80 };
+        tom::input_span<tom::span_policy::error> span{ copy.data(), compressed_size };
+        std::vector<sample> corrupted;
+        tom::deserialize_compressed(span, corrupted);
+        CHECK((span.failed() || !tom::serialized_equal(corrupted, samples)));
+    }
+}
+
+TEST_CASE("Incompressible blocks") {
+    std::mt19937 random{ 7 };
+    std::vector<std::uint32_t> noise(10000);
+    for (auto& value : noise) value = random();
+
+    std::vector<std::byte> bytes(tom::compressed_bound(tom::serialized_size(noise), 1000));
+    tom::output_span<> out{ bytes.data(), bytes.size() };
+    tom::serialize_compressed(out, noise, 1000);
+
+    tom::input_span<> in{ bytes.data(), bytes.size() - out.size() };
+    std::vector<std::uint32_t> result;
+    tom::deserialize_compressed(in, result);
+    CHECK(result == noise);
+}
+
+TEST_CASE("Hostile compressed sizes") {
+    using error_span = tom::input_span<tom::span_policy::error>;
+    auto const rejected = [] (std::vector<std::byte> const& bytes) {
+        error_span span{ bytes.data(), bytes.size() };
+        std::vector<std::byte> result;
+        tom::deserialize_compressed(span, result);
+        return span.failed() && result.empty();
+    };
+    // The block count would overflow.
+    CHECK(rejected(hostile_blocks(2, std::numeric_limits<std::uint64_t>::max(), 0)));
+    // More blocks than the input can hold.
+    CHECK(rejected(hostile_blocks(1000, 1'000'000, 10)));
+    // One byte blocks can't decompress to 2 GB each.
+    auto const block_size = (tom::length_type{ 1 } << 31) - 1;
+    CHECK(rejected(hostile_blocks(block_size, std::uint64_t{ block_size } * 1000, 1000)));
+
+    // The decompressed value counts against the allocation budget.
+    auto const samples = make_samples(100);
+    std::vector<std::byte> bytes(tom::compressed_bound(tom::serialized_size(samples)));
+    tom::output_span<> out{ bytes.data(), bytes.size() };
+    tom::serialize_compressed(out, samples);
+    bytes.resize(bytes.size() - out.size());
+    for (size_t budget : { size_t{ 1 } << 20, size_t{ 100 } }) {
+        tom::limited_span span{ error_span{ bytes.data(), bytes.size() }, { budget } };
+        std::vector<sample> result;
+        tom::deserialize_compressed(span, result);
+        CHECK(span.failed() == (budget == 100));
+    }
+}
@@ -0,0 +1,174 @@
+#include "catch.hpp"
+
+#include <columnar_archive.hpp>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    enum class level : std::uint8_t { debug, info, warning, error };
+
+    struct event {
+        std::int64_t timestamp;
+        std::uint32_t user;
+        double latency;
+        level severity;
+        std::optional<std::string> tag;
+        std::vector<int> labels;
+
+        friend bool operator==(event const& lhs, event const& rhs) {
+            return lhs.timestamp == rhs.timestamp && lhs.user == rhs.user &&
+                (lhs.latency == rhs.latency || (std::isnan(lhs.latency) && std::isnan(rhs.latency))) &&
+                lhs.severity == rhs.severity && lhs.tag == rhs.tag && lhs.labels == rhs.labels;
+        }
+    };
+
+    using events_archive = tom::columnar_archive<event>;
+
+    std::vector<event> make_events(size_t count) {
+        std::vector<event> events;
+        for (size_t i = 0; i < count; ++i) {
+            events.push_back({
+                1'700'000'000 + static_cast<std::int64_t>(i) * 10,
+                static_cast<std::uint32_t>(i * 7919 % 1000),
+                i % 97 == 0 ? NAN : static_cast<double>(i % 50) / 4,
+                static_cast<level>(i % 4),
+                i % 3 == 0 ? std::nullopt : std::optional<std::string>{ "tag-" + std::to_string(i % 11) },
+                std::vector<int>(i % 3 + 1, static_cast<int>(i))
+            });
+        }
+        return events;
+    }
+
+    std::string write_archive(std::vector<event> const& events, size_t row_group_size) {
+        std::ostringstream out;
+        tom::columnar_writer<event> writer{ out, { row_group_size } };
+        for (auto const& e : events) writer.add(e);
+        writer.finish();
+        return out.str();
+    }
+
+    events_archive open_bytes(std::string const& bytes) {
+        return { reinterpret_cast<std::byte const*>(bytes.data()), bytes.size() };
+    }
+}
+
+TEST_CASE("Columnar archive round trip") {
+    for (size_t count : { 0, 1, 999, 1000, 1001, 10'000 }) {
+        auto const events = make_events(count);
+        auto const bytes = write_archive(events, 1000);
+        auto const archive = open_bytes(bytes);
+        CHECK(archive.rows() == count);
+        CHECK(archive.row_groups() == (count + 999) / 1000);
+
+        std::vector<event> rows;
+        for (size_t group = 0; group < archive.row_groups(); ++group) {
+            auto const read = archive.read(group);
+            rows.insert(rows.end(), read.begin(), read.end());
+        }
+        CHECK(rows == events);
+    }
+}
+
+TEST_CASE("Columnar archive statistics") {
+    auto const events = make_events(2500);
+    auto const bytes = write_archive(events, 1000);
+    auto const archive = open_bytes(bytes);
+    REQUIRE(archive.row_groups() == 3);
+
+    auto const timestamps = archive.stats<0>(1);
+    CHECK(*timestamps.min == events[1000].timestamp);
+    CHECK(*timestamps.max == events[1999].timestamp);
+    CHECK(timestamps.null_count == 0);
+    CHECK(timestamps.rows == 1000);
+
+    // NaNs are left out.
+    auto const latencies = archive.stats<2>(0);
+    CHECK(*latencies.min == 0.0);
+    CHECK(*latencies.max == 49.0 / 4);
+
+    CHECK(*archive.stats<3>(2).min == level::debug);
+    CHECK(*archive.stats<3>(2).max == level::error);
+
+    auto const tags = archive.stats<4>(2);
+    CHECK(tags.null_count == 167);
+    CHECK(tags.rows == 500);
+    CHECK(*tags.min == "tag-0");
+    CHECK(*tags.max == "tag-9");
+
+    // Ranges have no order.
+    CHECK(!archive.stats<5>(0).min);
+
+    auto const users = archive.column<1>(2);
+    REQUIRE(users.size() == 500);
+    CHECK(users[17] == events[2017].user);
+}
+
+TEST_CASE("Columnar archive scans") {
+    auto const events = make_events(10'000);
+    auto const bytes = write_archive(events, 1000);
+    auto const archive = open_bytes(bytes);
+
+    // A narrow time window reads one or two row groups.
+    auto const begin = events[4321].timestamp, end = events[5432].timestamp;
+    std::vector<event> matches;
+    auto const read = archive.scan(tom::column_between<0>(begin, end), [&] (event const& e) {
+        if (e.timestamp >= begin && e.timestamp <= end) matches.push_back(e);
+    });
+    CHECK(read == 2);
+    CHECK(matches == std::vector<event>(events.begin() + 4321, events.begin() + 5433));
+
+    CHECK(archive.scan(tom::column_between<0>(std::int64_t{ 0 }, std::int64_t{ 1000 }), [] (event const&) {}) == 0);
+    CHECK(archive.scan(tom::column_equal<4>(std::string{ "tag-55" }), [] (event const&) {}) == 10);
+    CHECK(archive.scan(tom::column_equal<4>(std::string{ "zzz" }), [] (event const&) {}) == 0);
+
+    // Predicates on the statistics can be combined.
+    auto const window = tom::column_between<0>(begin, end);
+    auto const read_groups = archive.scan([&] (events_archive const& a, size_t group) {
+        return window(a, group) && a.stats<4>(group).null_count > 0;
+    }, [] (event const&) {});
+    CHECK(read_groups == 2);
+}
+
+TEST_CASE("Columnar archive files") {
+    auto const events = make_events(3000);
+    auto const path = (std::filesystem::temp_directory_path() / "tapeworm_columnar_archive.twc").string();
+    {
+        std::ofstream file{ path, std::ios::binary };
+        tom::columnar_writer<event> writer{ file, { 1024 } };
+        for (auto const& e : events) writer.add(e);
+        writer.finish();
+    }
+    {
+        auto const archive = events_archive::open(path);
+        CHECK(archive.row_groups() == 3);
+        CHECK(archive.read(2).back() == events.back());
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Columnar archive errors") {
+    std::ostringstream out;
+    CHECK_THROWS_AS((tom::columnar_writer<event>{ out, { 0 } }), std::invalid_argument);
+
+    auto const bytes = write_archive(make_events(100), 50);
+    struct other { std::int64_t timestamp; };
+    CHECK_THROWS_AS((tom::columnar_archive<other>{
+        reinterpret_cast<std::byte const*>(bytes.data()), bytes.size() }), tom::serialization_error);
+    CHECK_THROWS_AS(open_bytes(bytes.substr(1)), tom::serialization_error);
+
+    auto corrupted = bytes;
+    corrupted[bytes.size() - 40] ^= 1; // In the metadata : the checksum fails.
+    CHECK_THROWS_AS(open_bytes(corrupted), tom::serialization_error);
+
+    corrupted = bytes;
+    corrupted[0] ^= 1; // The length of the first chunk : only this chunk fails.
+    auto const archive = open_bytes(corrupted);
+    CHECK_THROWS_AS(archive.column<0>(0), tom::serialization_error);
+    CHECK(archive.column<0>(1).size() == 50);
+}
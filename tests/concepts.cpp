@@ -28,7 +28,7 @@ namespace {
 
     template <class T>
     struct struct_to_tag {
-        using type = tag_<T::tag>;
+        using type = tag_<static_cast<int>(T::tag)>;
     };
 }
 
@@ -83,16 +83,16 @@ namespace {
 }
 
 TEST_CASE("Concept selection") {
-    using pos_pc = priority_concept<abs_concept_positive, 10>;
-    using neg_pc = priority_concept<abs_concept_negative, 0>;
+    using pos_pc = tom::priority_concept<abs_concept_positive, 10>;
+    using neg_pc = tom::priority_concept<abs_concept_negative, 0>;
     CHECK(std::is_same_v<
         absolute_tag_concepts,
-        priority_concept_list<pos_pc, neg_pc>
+        tom::priority_concept_list<pos_pc, neg_pc>
     >);
 
-    CHECK( has_concept_v<absolute_tag_concepts, Maxi>);
-    CHECK( has_concept_v<absolute_tag_concepts, Mini>);
-    CHECK(!has_concept_v<absolute_tag_concepts, Medium>);
+    CHECK( tom::has_concept_v<absolute_tag_concepts, Maxi>);
+    CHECK( tom::has_concept_v<absolute_tag_concepts, Mini>);
+    CHECK(!tom::has_concept_v<absolute_tag_concepts, Medium>);
 
     using mini_concept = tom::pick_concept_t<absolute_tag_concepts, Mini>;
     CHECK(mini_concept::absolute_tag() == 2);
@@ -0,0 +1,104 @@
+#include "catch.hpp"
+#include "helpers.hpp"
+
+#include <decode_limits.hpp>
+#include <evolution.hpp>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+    struct record {
+        std::uint32_t id;
+        std::string name;
+        std::unique_ptr<double> weight;
+    };
+
+    using error_span = tom::input_span<tom::span_policy::error>;
+}
+
+TEST_CASE("Decoding within limits") {
+    std::vector<record> records(3);
+    for (std::uint32_t i = 0; i < 3; ++i) {
+        records[i].id = i;
+        records[i].name = "record";
+        records[i].weight = std::make_unique<double>(i);
+    }
+    auto const bytes = to_bytes(records);
+
+    tom::limited_span span{ error_span{ bytes.data(), bytes.size() }, { 1024, 16, 4 } };
+    std::vector<record> result;
+    tom::deserialize(span, result);
+    REQUIRE(!span.failed());
+    CHECK(span.size() == 0);
+    CHECK(tom::serialized_equal(result, records));
+    CHECK(span.allocated() == 3 * sizeof(record) + 3 * 6 + 3 * sizeof(double));
+}
+
+TEST_CASE("Decoding limits exceeded") {
+    std::vector<std::string> const strings{ "a", "bb", "ccc" };
+    auto const bytes = to_bytes(strings);
+    auto const decode = [&] (tom::decode_limits const& limits) {
+        tom::limited_span span{ error_span{ bytes.data(), bytes.size() }, limits };
+        std::vector<std::string> result;
+        tom::deserialize(span, result);
+        return !span.failed();
+    };
+    CHECK(decode({}));
+    CHECK(decode({ 3 * sizeof(std::string) + 6, 3, 2 }));
+    CHECK(!decode({ 3 * sizeof(std::string) + 5, 3, 2 }));
+    CHECK(!decode({ 1024, 2, 2 }));
+    CHECK(!decode({ 1024, 3, 1 }));
+}
+
+TEST_CASE("Hostile lengths") {
+    // A length of 2^32 - 1 elements followed by a single one.
+    std::vector<std::byte> bytes(sizeof(tom::length_type) + 4);
+    auto const length = std::numeric_limits<tom::length_type>::max();
+    std::memcpy(bytes.data(), &length, sizeof(length));
+
+    {
+        error_span span{ bytes.data(), bytes.size() };
+        std::vector<std::vector<int>> result;
+        tom::deserialize(span, result);
+        CHECK(span.failed());
+        CHECK(result.capacity() == 0);
+    }
+    {
+        tom::limited_span span{ error_span{ bytes.data(), bytes.size() }, { 1024, 1024, 8 } };
+        std::vector<int> result;
+        tom::deserialize(span, result);
+        CHECK(span.failed());
+        CHECK(span.allocated() == 0);
+    }
+    {
+        tom::limited_span span{ tom::input_span<>{ bytes.data(), bytes.size() }, { 1024, 1024, 8 } };
+        std::vector<int> result;
+        CHECK_THROWS_AS(tom::deserialize(span, result), tom::serialization_error);
+    }
+}
+
+TEST_CASE("Evolvable decoding within limits") {
+    struct labeled {
+        std::uint32_t id;
+        std::string label;
+        std::vector<std::vector<int>> nested;
+    };
+    labeled const value{ 7, std::string(1000, 'x'), { { 1, 2 } } };
+    auto const bytes = evolvable_bytes(value);
+
+    auto const decode = [&] (tom::decode_limits const& limits, size_t* allocated = nullptr) {
+        tom::limited_span span{ error_span{ bytes.data(), bytes.size() }, limits };
+        labeled result;
+        tom::deserialize_evolvable(span, result);
+        if (allocated) *allocated = span.allocated();
+        return !span.failed();
+    };
+    // The limits apply inside the delimited members, and their allocations are counted by the span.
+    size_t allocated = 0;
+    CHECK(decode({}, &allocated));
+    CHECK(allocated == 1000 + sizeof(std::vector<int>) + 2 * sizeof(int));
+    CHECK(!decode({ 10 }));
+    CHECK(!decode({ 1024, 100 }));
+    CHECK(!decode({ 1024, 1024, 2 }));
+}
@@ -0,0 +1,83 @@
+
+#include "catch.hpp"
+
+#include <delta.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+    struct vec2 {
+        double x;
+        double y;
+    };
+
+    struct player {
+        std::uint32_t id;
+        std::string name;
+        vec2 position;
+        std::int64_t score;
+        std::vector<std::uint8_t> inventory;
+        std::vector<std::string> titles;
+    };
+
+    template <tom::numeric_delta Encoding, class T>
+    std::vector<std::byte> make_delta(T const& prev, T const& curr) {
+        std::vector<std::byte> bytes(tom::serialized_delta_size<Encoding>(prev, curr));
+        tom::output_span<> span{ bytes.data(), bytes.size() };
+        tom::serialize_delta<Encoding>(span, prev, curr);
+        CHECK(span.size() == 0);
+        return bytes;
+    }
+
+    template <tom::numeric_delta Encoding, class T>
+    void apply(std::vector<std::byte> const& bytes, T& value) {
+        tom::input_span<> span{ bytes.data(), bytes.size() };
+        tom::apply_delta<Encoding>(span, value);
+        CHECK(span.size() == 0);
+    }
+}
+
+TEST_CASE("Delta of unchanged values") {
+    player const prev{ 1, "bob", { 1, 2 }, 100, std::vector<std::uint8_t>(1000, 1), { "a" } };
+    CHECK(make_delta<tom::numeric_delta::raw>(prev, prev).size() == 1);
+    CHECK(make_delta<tom::numeric_delta::raw>(prev.inventory, prev.inventory).size() == 1);
+}
+
+TEST_CASE("Delta round-trip") {
+    player const prev{ 1, "bob", { 1, 2 }, 100, std::vector<std::uint8_t>(1000, 1), { "a" } };
+    player curr = prev;
+    curr.position.y = 2.5;
+    curr.score = 98;
+    curr.inventory[500] = 2;
+    curr.inventory.push_back(3);
+    curr.titles.push_back("b");
+
+    auto const check = [&] (auto encoding) {
+        constexpr auto value = decltype(encoding)::value;
+        auto const bytes = make_delta<value>(prev, curr);
+        CHECK(bytes.size() < 150);
+
+        player result = prev;
+        apply<value>(bytes, result);
+        CHECK(tom::serialized_equal(result, curr));
+        return bytes.size();
+    };
+    auto const raw      = check(std::integral_constant<tom::numeric_delta, tom::numeric_delta::raw>{});
+    auto const xor_bits = check(std::integral_constant<tom::numeric_delta, tom::numeric_delta::xor_bits>{});
+    auto const subtract = check(std::integral_constant<tom::numeric_delta, tom::numeric_delta::subtract>{});
+    CHECK(subtract < raw);
+    CHECK(xor_bits < raw);
+}
+
+TEST_CASE("Delta of trivial arrays") {
+    std::vector<int> const prev(100, 7);
+    std::vector<int> curr(prev.begin(), prev.begin() + 50);
+    curr[3] = 0;
+
+    auto const bytes = make_delta<tom::numeric_delta::raw>(prev, curr);
+    CHECK(bytes.size() == 1 + 4 + 1 + 64);
+
+    auto result = prev;
+    apply<tom::numeric_delta::raw>(bytes, result);
+    CHECK(result == curr);
+}
@@ -0,0 +1,137 @@
+#include "catch.hpp"
+#include "helpers.hpp"
+
+#include <fingerprint.hpp>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+    using tom::delta_packing;
+
+    template <class Int, int Order, delta_packing Packing>
+    void check_round_trips() {
+        using limits = std::numeric_limits<Int>;
+        std::mt19937_64 random{ sizeof(Int) + Order };
+        for (size_t length : { 0, 1, 2, 3, 127, 128, 129, 130, 1000 }) {
+            tom::delta_coded<std::vector<Int>, Order, Packing> sorted(length), noisy(length);
+            std::uint64_t value = random();
+            for (size_t i = 0; i < length; ++i) {
+                value += random() % 100;
+                sorted[i] = static_cast<Int>(value);
+                noisy[i] = static_cast<Int>(random());
+            }
+            if (length > 3) {
+                noisy[1] = limits::min();
+                noisy[2] = limits::max();
+            }
+            CHECK(round_trip(sorted) == sorted);
+            CHECK(round_trip(noisy) == noisy);
+        }
+    }
+
+    template <int Order, delta_packing Packing>
+    void check_all_round_trips() {
+        check_round_trips<std::int8_t, Order, Packing>();
+        check_round_trips<std::uint16_t, Order, Packing>();
+        check_round_trips<std::int32_t, Order, Packing>();
+        check_round_trips<std::uint32_t, Order, Packing>();
+        check_round_trips<std::int64_t, Order, Packing>();
+        check_round_trips<std::uint64_t, Order, Packing>();
+    }
+}
+
+TEST_CASE("Delta coding kernels") {
+    namespace impl = tom::detail::delta_coding;
+    CHECK(impl::zigzag_encode<std::uint8_t>(0xFF) == 1);
+    CHECK(impl::zigzag_encode<std::uint8_t>(1) == 2);
+    CHECK(impl::zigzag_decode<std::uint8_t>(0xFF) == 0x80);
+    for (std::uint32_t i = 0; i < 0x10000; ++i) {
+        auto const value = static_cast<std::uint16_t>(i);
+        CHECK(impl::zigzag_decode(impl::zigzag_encode(value)) == value);
+    }
+
+    std::mt19937_64 random{ 5 };
+    for (size_t count : { 0, 1, 3, 4, 5, 128 }) {
+        std::vector<std::uint32_t> narrow(count), narrow_scalar;
+        std::vector<std::uint64_t> wide(count), wide_scalar;
+        for (size_t i = 0; i < count; ++i) {
+            narrow[i] = static_cast<std::uint32_t>(random());
+            wide[i] = random();
+        }
+        narrow_scalar = narrow;
+        wide_scalar = wide;
+        std::uint32_t narrow_carry = 7;
+        std::uint64_t wide_carry = ~std::uint64_t{ 0 };
+        for (size_t i = 0; i < count; ++i) {
+            narrow_scalar[i] = narrow_carry += narrow_scalar[i];
+            wide_scalar[i] = wide_carry += wide_scalar[i];
+        }
+        CHECK(impl::prefix_sum(narrow.data(), count, std::uint32_t{ 7 }) == narrow_carry);
+        CHECK(impl::prefix_sum(wide.data(), count, ~std::uint64_t{ 0 }) == wide_carry);
+        CHECK(narrow == narrow_scalar);
+        CHECK(wide == wide_scalar);
+    }
+}
+
+TEST_CASE("Delta encoding") {
+    using ids = tom::delta_coded<std::vector<std::uint32_t>>;
+    static_assert(tom::uses_concept_v<ids, tom::serial::concept::delta_encoding>);
+    static_assert(!tom::uses_concept_v<tom::delta_coded<std::vector<bool>>, tom::serial::concept::delta_encoding>);
+    static_assert(!tom::uses_concept_v<std::vector<double>, tom::serial::concept::delta_encoding>);
+
+    check_all_round_trips<1, delta_packing::varint>();
+    check_all_round_trips<1, delta_packing::bit_packed>();
+    check_all_round_trips<2, delta_packing::varint>();
+    check_all_round_trips<2, delta_packing::bit_packed>();
+
+    // Regular timestamps in nanoseconds, with a few microseconds of jitter.
+    tom::delta_coded<std::vector<std::int64_t>, 2> timestamps;
+    tom::delta_coded<std::vector<std::int64_t>, 2, delta_packing::varint> varint_timestamps;
+    std::mt19937 random{ 9 };
+    std::int64_t time = 1'700'000'000'000'000'000;
+    for (int i = 0; i < 10'000; ++i) {
+        time += 1'000'000 + static_cast<std::int64_t>(random() % 4096);
+        timestamps.push_back(time);
+        varint_timestamps.push_back(time);
+    }
+    auto const raw_size = tom::serialized_size(std::vector<std::int64_t>(timestamps));
+    CHECK(tom::serialized_size(timestamps) * 4 < raw_size);
+    CHECK(tom::serialized_size(varint_timestamps) * 4 < raw_size);
+    CHECK(round_trip(timestamps) == timestamps);
+    CHECK(round_trip(varint_timestamps) == varint_timestamps);
+
+    // Sorted ids take a few bits each.
+    ids sorted;
+    for (std::uint32_t i = 0; i < 1000; ++i) sorted.push_back(1'000'000 + i * 3);
+    CHECK(tom::serialized_size(sorted) * 10 < tom::serialized_size(std::vector<std::uint32_t>(sorted)));
+
+    CHECK(tom::fingerprint_v<ids> != tom::fingerprint_v<std::vector<std::uint32_t>>);
+    CHECK(tom::fingerprint_v<ids> != tom::fingerprint_v<tom::delta_coded<std::vector<std::uint32_t>, 2>>);
+    CHECK(tom::fingerprint_v<ids> != tom::fingerprint_v<tom::delta_coded<std::vector<std::uint32_t>, 1, delta_packing::varint>>);
+}
+
+TEST_CASE("Delta encoding corruptions") {
+    tom::delta_coded<std::vector<std::uint32_t>> values(200, 5);
+    std::vector<std::byte> bytes(tom::serialized_size(values));
+    tom::output_span<> out{ bytes.data(), bytes.size() };
+    tom::serialize(out, values);
+
+    bytes[4 + 4 + 4] = std::byte{ 33 }; // The width of the first block.
+    tom::input_span<tom::span_policy::error> in{ bytes.data(), bytes.size() };
+    tom::delta_coded<std::vector<std::uint32_t>> result;
+    tom::deserialize(in, result);
+    CHECK(in.failed());
+
+    // A varint delta wider than the values.
+    tom::delta_coded<std::vector<std::uint8_t>, 1, delta_packing::varint> small(3, 1);
+    bytes.assign(tom::serialized_size(small), std::byte{});
+    tom::output_span<> small_out{ bytes.data(), bytes.size() };
+    tom::serialize(small_out, small);
+    bytes[5] = std::byte{ 0x80 };
+    bytes[6] = std::byte{ 0x02 };
+    tom::input_span<tom::span_policy::error> small_in{ bytes.data(), bytes.size() };
+    decltype(small) small_result;
+    tom::deserialize(small_in, small_result);
+    CHECK(small_in.failed());
+}
@@ -0,0 +1,178 @@
+#include "catch.hpp"
+#include "helpers.hpp"
+
+#include <dictionary_view.hpp>
+#include <fingerprint.hpp>
+#include <decode_limits.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    using strings = tom::dictionary_coded<std::vector<std::string>>;
+
+    struct events {
+        std::uint64_t day;
+        strings hosts;
+        strings labels;
+    };
+
+    struct log_record {
+        std::string host;
+        std::uint32_t status;
+        std::string label;
+        std::vector<std::int32_t> latencies;
+    };
+    using log_records = tom::dictionary_coded<std::vector<log_record>>;
+
+    strings repeated(size_t length, size_t distinct, std::mt19937& random) {
+        strings values;
+        for (size_t i = 0; i < length; ++i) {
+            auto const id = random() % distinct;
+            values.push_back(id % 7 == 0 ? std::string{} : "host-" + std::to_string(id) + ".example.com");
+        }
+        return values;
+    }
+}
+
+TEST_CASE("String table") {
+    tom::detail::dictionary::string_table table;
+    std::vector<std::string> strings;
+    for (int i = 0; i < 1000; ++i) strings.push_back(std::to_string(i * 7919));
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < strings.size(); ++i) CHECK(table.insert(strings[i]) == i);
+    }
+    CHECK(table.entries().size() == strings.size());
+    CHECK(table.insert("") == strings.size());
+}
+
+TEST_CASE("Dictionary encoding") {
+    static_assert(tom::uses_concept_v<strings, tom::serial::concept::dictionary_encoding>);
+    static_assert(!tom::uses_concept_v<tom::dictionary_coded<std::vector<int>>, tom::serial::concept::dictionary_encoding>);
+
+    std::mt19937 random{ 21 };
+    // 1, 2 and 4 bytes indices.
+    for (size_t distinct : { 1, 200, 300, 70'000 }) {
+        for (size_t length : { 0, 1, 10, 1000, 100'000 }) {
+            auto const values = repeated(length, distinct, random);
+            CHECK(round_trip(values) == values);
+        }
+    }
+
+    events value{ 19'000, repeated(10'000, 300, random), repeated(10'000, 20, random) };
+    auto const bytes = to_bytes(value);
+    CHECK(bytes.size() * 5 < tom::serialized_size(std::make_tuple(
+        value.day, std::vector<std::string>(value.hosts), std::vector<std::string>(value.labels))));
+    auto const result = round_trip(value);
+    CHECK(result.hosts == value.hosts);
+    CHECK(result.labels == value.labels);
+    CHECK(tom::fingerprint_v<strings> != tom::fingerprint_v<std::vector<std::string>>);
+}
+
+TEST_CASE("Dictionary encoding of records") {
+    static_assert(tom::uses_concept_v<log_records, tom::serial::concept::dictionary_encoding>);
+    static_assert(tom::serial::concept::dictionary_encoding<log_records>::strings_per_value == 2);
+    struct counter { std::uint64_t count; double rate; };
+    static_assert(!tom::uses_concept_v<tom::dictionary_coded<std::vector<counter>>, tom::serial::concept::dictionary_encoding>);
+
+    std::mt19937 random{ 25 };
+    for (size_t distinct : { 1, 100, 300, 70'000 }) {
+        auto const hosts = repeated(10'000, distinct, random);
+        log_records records;
+        for (size_t i = 0; i < hosts.size(); ++i) {
+            records.push_back({ hosts[i], static_cast<std::uint32_t>(200 + random() % 4), "label-" + std::to_string(random() % 10),
+                std::vector<std::int32_t>(i % 3, static_cast<std::int32_t>(i)) });
+        }
+        auto const result = round_trip(records);
+        CHECK(tom::serialized_equal(result, records));
+        REQUIRE(result.size() == records.size());
+        CHECK(result.back().host == records.back().host);
+        CHECK(result.back().latencies == records.back().latencies);
+        if (distinct <= 300) {
+            // One dictionary for the hosts and the labels.
+            CHECK(to_bytes(records).size() * 3 < 2 * tom::serialized_size(std::vector<log_record>(records)));
+        }
+    }
+    CHECK(round_trip(log_records{}).empty());
+    CHECK(tom::fingerprint_v<log_records> != tom::fingerprint_v<std::vector<log_record>>);
+
+    // The indices of the strings are checked between the other members.
+    auto bytes = to_bytes(log_records{ { "a", 1, "b", {} }, { "b", 2, "a", {} } });
+    auto const check_failure = [] (std::vector<std::byte> const& corrupted) {
+        tom::input_span<tom::span_policy::error> in{ corrupted.data(), corrupted.size() };
+        log_records result;
+        tom::deserialize(in, result);
+        CHECK(in.failed());
+
+        tom::input_span<tom::span_policy::error> skipped{ corrupted.data(), corrupted.size() };
+        tom::skip<log_records>(skipped);
+        CHECK(skipped.failed());
+    };
+    auto corrupted = bytes;
+    corrupted[2 * sizeof(tom::length_type) + 2 * (sizeof(tom::length_type) + 1)] = std::byte{ 2 }; // The first host.
+    check_failure(corrupted);
+    corrupted = bytes;
+    corrupted[4] = std::byte{ 5 }; // More strings than the members of the records.
+    check_failure(corrupted);
+    check_failure(std::vector<std::byte>(bytes.begin(), bytes.end() - 1));
+}
+
+TEST_CASE("Dictionary view") {
+    std::mt19937 random{ 23 };
+    auto const values = repeated(5000, 100, random);
+    auto const bytes = to_bytes(values);
+
+    tom::input_span<> span{ bytes.data(), bytes.size() };
+    tom::dictionary_view<strings> view{ span };
+    CHECK(span.size() == 0);
+    REQUIRE(view.size() == values.size());
+    CHECK(view.dictionary().size() <= 100);
+    size_t i = 0;
+    for (auto string : view) {
+        CHECK(string == values[i]);
+        // Interned : equal strings are the same bytes.
+        CHECK(string.data() == view.dictionary()[view.index(i)].data());
+        ++i;
+    }
+    CHECK(i == values.size());
+    CHECK_THROWS_AS(view.at(values.size()), std::out_of_range);
+}
+
+TEST_CASE("Dictionary encoding corruptions") {
+    strings const values{ "a", "bb", "a", "ccc" };
+    auto const bytes = to_bytes(values);
+
+    auto const check_failure = [] (std::vector<std::byte> const& corrupted) {
+        tom::input_span<tom::span_policy::error> in{ corrupted.data(), corrupted.size() };
+        strings result;
+        tom::deserialize(in, result);
+        CHECK(in.failed());
+
+        // 'skip' checks the indices, so that validated buffers decode safely.
+        tom::input_span<tom::span_policy::error> skipped{ corrupted.data(), corrupted.size() };
+        tom::skip<strings>(skipped);
+        CHECK(skipped.failed());
+
+        tom::input_span<tom::span_policy::error> view_in{ corrupted.data(), corrupted.size() };
+        tom::dictionary_view<strings> view{ view_in };
+        CHECK(view_in.failed());
+        CHECK(view.empty());
+    };
+    auto corrupted = bytes;
+    corrupted.back() = std::byte{ 3 }; // An index out of the dictionary.
+    check_failure(corrupted);
+
+    corrupted = bytes;
+    corrupted[4] = std::byte{ 5 }; // More strings than values.
+    check_failure(corrupted);
+
+    // The copies of the strings count against the allocation budget.
+    strings large(1000, std::string(1000, 'x'));
+    auto const large_bytes = to_bytes(large);
+    CHECK(large_bytes.size() < 3000);
+    tom::limited_span limited{ tom::input_span<tom::span_policy::error>{ large_bytes.data(), large_bytes.size() },
+        tom::decode_limits{ 100'000, 1'000'000, 64 } };
+    strings result;
+    tom::deserialize(limited, result);
+    CHECK(limited.failed());
+}
@@ -0,0 +1,117 @@
+
+#include "catch.hpp"
+#include "helpers.hpp"
+
+#include <evolution.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+    struct point_v1 {
+        std::int32_t x;
+        std::int32_t y;
+    };
+    struct point_v2 {
+        std::int32_t x;
+        std::int32_t y;
+        std::optional<std::string> label;
+    };
+
+    struct shape_v1 {
+        std::uint32_t id;
+        std::string name;
+        std::vector<point_v1> points;
+    };
+    // 'name' is removed, 'color' is added and 'points' is moved.
+    struct shape_v2 {
+        std::uint32_t id;
+        std::vector<point_v2> points;
+        std::uint16_t color;
+    };
+
+    struct series {
+        tom::bit_packed<std::vector<std::uint32_t>> ids;
+        tom::delta_coded<std::vector<std::int64_t>, 2> times;
+        tom::time_series<std::vector<double>> values;
+    };
+
+}
+
+template <>
+struct tom::field_tags<shape_v2> {
+    static constexpr std::uint32_t value[] = { 1, 3, 4 };
+};
+
+TEST_CASE("Evolvable encoding round-trip") {
+    shape_v1 const src{ 7, "square", {{0, 0}, {0, 1}, {1, 1}, {1, 0}} };
+    auto const bytes = evolvable_bytes(src);
+
+    shape_v1 dst;
+    tom::input_span<> span{ bytes.data(), bytes.size() };
+    tom::deserialize_evolvable(span, dst);
+    CHECK(span.size() == 0);
+    CHECK(tom::serialized_equal(src, dst));
+}
+
+TEST_CASE("Old and new readers") {
+    {
+        shape_v1 const src{ 7, "square", {{0, 0}, {1, 1}} };
+        auto const bytes = evolvable_bytes(src);
+
+        shape_v2 dst{ 1, {{ 5, 5, "old" }}, 3 };
+        tom::input_span<> span{ bytes.data(), bytes.size() };
+        tom::deserialize_evolvable(span, dst);
+        CHECK(span.size() == 0);
+        CHECK(dst.id == 7);
+        CHECK(dst.color == 0);
+        REQUIRE(dst.points.size() == 2);
+        CHECK(dst.points[1].y == 1);
+        CHECK(!dst.points[1].label);
+    }
+    {
+        shape_v2 const src{ 7, {{ 1, 2, "a" }, { 3, 4, std::nullopt }}, 0xFF };
+        auto const bytes = evolvable_bytes(src);
+
+        shape_v1 dst;
+        tom::input_span<> span{ bytes.data(), bytes.size() };
+        tom::deserialize_evolvable(span, dst);
+        CHECK(span.size() == 0);
+        CHECK(dst.id == 7);
+        CHECK(dst.name.empty());
+        REQUIRE(dst.points.size() == 2);
+        CHECK(dst.points[1].x == 3);
+    }
+}
+
+TEST_CASE("Positional fast path") {
+    shape_v1 const src{ 7, "square", {{0, 0}, {1, 1}} };
+    auto const fingerprint = tom::fingerprint_v<shape_v1>;
+
+    std::vector<std::byte> bytes(tom::evolvable_size(src, fingerprint));
+    CHECK(bytes.size() == 8 + 1 + tom::serialized_size(src));
+    tom::output_span<> out{ bytes.data(), bytes.size() };
+    tom::serialize_evolvable(out, src, fingerprint);
+    {
+        shape_v1 dst;
+        tom::input_span<> span{ bytes.data(), bytes.size() };
+        tom::deserialize_evolvable(span, dst);
+        CHECK(tom::serialized_equal(src, dst));
+    }
+    {
+        shape_v2 dst;
+        tom::input_span<tom::span_policy::error> span{ bytes.data(), bytes.size() };
+        tom::deserialize_evolvable(span, dst);
+        CHECK(span.failed());
+    }
+}
+
+TEST_CASE("Evolvable encoded containers") {
+    series const src{ {{ 1, 5, 9 }}, {{ 100, 200, 300 }}, {{ 0.5, 0.5, 0.75 }} };
+    auto const bytes = evolvable_bytes(src);
+
+    series dst;
+    tom::input_span<> span{ bytes.data(), bytes.size() };
+    tom::deserialize_evolvable(span, dst);
+    CHECK(span.size() == 0);
+    CHECK(tom::serialized_equal(src, dst));
+}
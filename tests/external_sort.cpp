@@ -0,0 +1,191 @@
+#include "catch.hpp"
+
+#include <external_sort.hpp>
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+    struct event {
+        std::uint32_t user;
+        std::int64_t timestamp;
+        std::string payload;
+        std::uint64_t sequence;
+    };
+
+    std::vector<event> make_events(size_t count) {
+        std::mt19937_64 random{ 7 };
+        std::vector<event> events;
+        for (size_t i = 0; i < count; ++i) {
+            events.push_back({ static_cast<std::uint32_t>(random() % 50), static_cast<std::int64_t>(random() % 200) - 100,
+                std::string(random() % 40, static_cast<char>('a' + i % 26)), i });
+        }
+        return events;
+    }
+
+    std::string write_events(std::vector<event> const& events) {
+        std::string bytes;
+        for (auto const& e : events) {
+            std::vector<std::byte> frame(tom::framed_size(e));
+            tom::output_span<> span{ frame.data(), frame.size() };
+            tom::serialize_framed(span, e);
+            bytes.append(reinterpret_cast<char const*>(frame.data()), frame.size());
+        }
+        return bytes;
+    }
+
+    std::vector<event> read_events(std::string const& bytes) {
+        std::vector<event> events;
+        tom::input_span<> span{ reinterpret_cast<std::byte const*>(bytes.data()), bytes.size() };
+        while (span.size() != 0) {
+            event e{};
+            tom::deserialize_framed(span, e);
+            events.push_back(std::move(e));
+        }
+        return events;
+    }
+
+    auto const by_user_and_time = [] (event const& e) { return std::tuple{ e.user, e.timestamp }; };
+
+    // The expected order : by user then timestamp, the input order being kept on equal keys.
+    bool sorted(std::vector<event> const& events) {
+        return std::is_sorted(events.begin(), events.end(), [] (event const& lhs, event const& rhs) {
+            return std::tie(lhs.user, lhs.timestamp, lhs.sequence) < std::tie(rhs.user, rhs.timestamp, rhs.sequence);
+        });
+    }
+
+    std::string sort(std::string const& bytes, tom::sort_options const& options) {
+        std::istringstream in{ bytes };
+        std::ostringstream out;
+        tom::sort_records<event>(in, out, by_user_and_time, options);
+        return out.str();
+    }
+}
+
+TEST_CASE("External sort") {
+    auto const events = make_events(5000);
+    auto const bytes = write_events(events);
+
+    for (bool io_thread : { true, false }) {
+        // Many runs, merged in several passes, through buffers smaller than some records.
+        tom::sort_options options;
+        options.memory_budget = 8 * 1024;
+        options.buffer_size = 48;
+        options.max_fan_in = 3;
+        options.io_thread = io_thread;
+        std::istringstream in{ bytes };
+        std::ostringstream out;
+        CHECK(tom::sort_records<event>(in, out, by_user_and_time, options) == events.size());
+
+        auto const result = read_events(out.str());
+        CHECK(result.size() == events.size());
+        CHECK(sorted(result));
+        CHECK(out.str().size() == bytes.size());
+    }
+
+    // In memory, without runs.
+    auto const result = read_events(sort(bytes, {}));
+    CHECK(result.size() == events.size());
+    CHECK(sorted(result));
+
+    // A single merge.
+    tom::sort_options options;
+    options.memory_budget = 64 * 1024;
+    CHECK(sort(bytes, options) == sort(bytes, {}));
+
+    CHECK(sort("", options).empty());
+}
+
+TEST_CASE("External sort on strings") {
+    // Keys sharing long prefixes, compared past their first 8 bytes.
+    std::vector<event> events;
+    for (std::uint64_t i = 0; i < 1000; ++i) {
+        events.push_back({ 0, 0, "common/prefix/" + std::to_string(i * 7919 % 1000), i });
+    }
+    events.push_back({ 0, 0, std::string{ "common/\0", 8 }, 1000 });
+    events.push_back({ 0, 0, "common/", 1001 });
+
+    tom::sort_options options;
+    options.memory_budget = 4096;
+    std::istringstream in{ write_events(events) };
+    std::ostringstream out;
+    tom::sort_records<event>(in, out, [] (event const& e) { return e.payload; }, options);
+    auto const result = read_events(out.str());
+    REQUIRE(result.size() == events.size());
+    CHECK(result[0].payload == "common/");
+    CHECK(result[1].payload == std::string{ "common/\0", 8 });
+    CHECK(std::is_sorted(result.begin(), result.end(), [] (event const& lhs, event const& rhs) { return lhs.payload < rhs.payload; }));
+}
+
+TEST_CASE("External sort of frames") {
+    // Sorted on the leading members of the payloads, as the 'tapeworm_sort' tool does.
+    auto const events = make_events(2000);
+    tom::sort_options options;
+    options.memory_budget = 4096;
+    auto const leading_members = [] (tom::input_span<tom::span_policy::error>& payload, std::vector<std::byte>& key) {
+        std::uint32_t user;
+        std::int64_t timestamp;
+        tom::deserialize(payload, user);
+        tom::deserialize(payload, timestamp);
+        if (!payload.failed()) tom::append_key(key, std::tuple{ user, timestamp });
+    };
+    std::istringstream in{ write_events(events) };
+    std::ostringstream out;
+    CHECK(tom::sort_frames(in, out, leading_members, options) == events.size());
+    CHECK(out.str() == sort(write_events(events), options));
+
+    // A payload too short for the key.
+    std::istringstream truncated{ write_events({ event{ 1, 2, "", 3 } }) };
+    CHECK_THROWS_AS(tom::sort_frames(truncated, out, [] (auto& payload, std::vector<std::byte>&) {
+        std::array<std::uint64_t, 8> rest;
+        tom::deserialize(payload, rest);
+    }), tom::serialization_error);
+}
+
+TEST_CASE("External sort files") {
+    auto const events = make_events(3000);
+    auto const directory = std::filesystem::temp_directory_path() / "tapeworm_external_sort";
+    std::filesystem::create_directories(directory);
+    auto const input = (directory / "events.bin").string(), output = (directory / "sorted.bin").string();
+    {
+        std::ofstream file{ input, std::ios::binary };
+        auto const bytes = write_events(events);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    tom::sort_options options;
+    options.memory_budget = 16 * 1024;
+    options.temp_directory = directory.string();
+    CHECK(tom::sort_file<event>(input, output, by_user_and_time, options) == events.size());
+    {
+        std::ifstream file{ output, std::ios::binary };
+        std::stringstream bytes;
+        bytes << file.rdbuf();
+        CHECK(sorted(read_events(bytes.str())));
+    }
+    // The runs are removed.
+    CHECK(std::distance(std::filesystem::directory_iterator{ directory }, std::filesystem::directory_iterator{}) == 2);
+
+    CHECK_THROWS_AS(tom::sort_file<event>((directory / "missing.bin").string(), output, by_user_and_time), std::system_error);
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("External sort errors") {
+    auto const bytes = write_events(make_events(100));
+    tom::sort_options options;
+    options.memory_budget = 1024;
+
+    CHECK_THROWS_AS(sort(bytes.substr(0, bytes.size() - 1), options), tom::serialization_error);
+    auto corrupted = bytes;
+    corrupted[10] ^= 1; // The checksum of the first record fails.
+    CHECK_THROWS_AS(sort(corrupted, options), tom::serialization_error);
+
+    options.max_fan_in = 1;
+    CHECK_THROWS_AS(sort(bytes, options), std::invalid_argument);
+}
@@ -0,0 +1,156 @@
+#include "catch.hpp"
+
+#include <filter.hpp>
+#include <columnar_archive.hpp>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace {
+    using tom::detail::filter::compare_op;
+    using tom::detail::filter::simd_level;
+
+    template <class T>
+    bool naive(compare_op op, T value, T a, T b) {
+        switch (op) {
+            case compare_op::equal: return value == a;
+            case compare_op::less: return value < a;
+            default: return a <= value && value <= b;
+        }
+    }
+
+    template <class T>
+    std::vector<T> make_values(size_t count, std::mt19937_64& random) {
+        std::vector<T> values(count);
+        for (auto& value : values) {
+            if constexpr (std::is_floating_point_v<T>) {
+                value = random() % 50 == 0 ? std::numeric_limits<T>::quiet_NaN() : static_cast<T>(static_cast<int>(random() % 200) - 100) / 4;
+            }
+            else if constexpr (std::is_signed_v<T>) value = static_cast<T>(static_cast<int>(random() % 200) - 100);
+            else value = static_cast<T>(random() % 2 == 0 ? random() % 200 : std::numeric_limits<T>::max() - random() % 200);
+        }
+        return values;
+    }
+
+    // Every instruction set supported by the CPU selects the same rows as the naive comparisons.
+    template <class T>
+    void check_kernels() {
+        std::mt19937_64 random{ 42 };
+        for (size_t count : { 0, 1, 63, 64, 65, 127, 1000 }) {
+            auto const values = make_values<T>(count, random);
+            auto const bounds = make_values<T>(8, random);
+            for (auto op : { compare_op::equal, compare_op::less, compare_op::between }) {
+                for (size_t k = 0; k + 1 < bounds.size(); ++k) {
+                    auto const a = std::min(bounds[k], bounds[k + 1]), b = std::max(bounds[k], bounds[k + 1]);
+                    for (auto level : { simd_level::scalar, simd_level::avx2, simd_level::avx512 }) {
+                        if (level > tom::detail::filter::detect_simd()) continue;
+                        tom::selection selected{ count };
+                        tom::detail::filter::select(level, values.data(), count, op, a, b, selected.words());
+                        for (size_t i = 0; i < count; ++i) {
+                            if (selected[i] != naive(op, values[i], a, b)) {
+                                FAIL("level " << static_cast<int>(level) << ", op " << static_cast<int>(op) << ", row " << i);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    struct order {
+        std::uint32_t customer;
+        std::int64_t quantity;
+        double price;
+    };
+}
+
+TEST_CASE("Selections") {
+    tom::selection a{ 130 }, b{ 130, true };
+    CHECK(a.count() == 0);
+    CHECK(!a.any());
+    CHECK(b.count() == 130);
+    for (size_t i : { 0, 3, 64, 129 }) a.set(i);
+    b.set(3, false);
+
+    CHECK((a & b).indices() == std::vector<size_t>{ 0, 64, 129 });
+    CHECK((a | b).count() == 130);
+    // The bits past the size stay clear.
+    CHECK((~a).count() == 126);
+    CHECK((~~a).indices() == a.indices());
+    CHECK((~tom::selection{ 100 }).count() == 100);
+
+    std::vector<size_t> visited;
+    a.for_each([&] (size_t i) { visited.push_back(i); });
+    CHECK(visited == std::vector<size_t>{ 0, 3, 64, 129 });
+
+    CHECK_THROWS_AS(a &= tom::selection{ 129 }, std::invalid_argument);
+    CHECK_THROWS_AS(a | tom::selection{ 131 }, std::invalid_argument);
+}
+
+TEST_CASE("Filter kernels") {
+    check_kernels<std::int32_t>();
+    check_kernels<std::uint32_t>();
+    check_kernels<std::int64_t>();
+    check_kernels<std::uint64_t>();
+    check_kernels<float>();
+    check_kernels<double>();
+    // Scalar only.
+    check_kernels<std::int16_t>();
+    check_kernels<std::uint8_t>();
+}
+
+TEST_CASE("Filter columns") {
+    std::vector<std::int32_t> values;
+    for (int i = 0; i < 1000; ++i) values.push_back(i % 100 - 50);
+
+    CHECK(tom::select_equal(values, 7).count() == 10);
+    CHECK(tom::select_less(values, -40).count() == 100);
+    CHECK(tom::select_between(values, -5, 4).count() == 100);
+    CHECK(tom::select_between(values, 4, -5).count() == 0);
+    CHECK(tom::select_in(values, { 1, 2, 3, 1000 }).count() == 30);
+    CHECK(tom::select_in(values, {}).count() == 0);
+
+    auto const both = tom::select_less(values, 0) & ~tom::select_in(values, { -1, -2 });
+    CHECK(both.count() == 480);
+    auto const rows = tom::gather(values, both);
+    CHECK(rows.size() == 480);
+    CHECK(std::all_of(rows.begin(), rows.end(), [] (std::int32_t v) { return v < -2; }));
+
+    std::vector<double> prices{ 1.5, NAN, 3.0, -0.0 };
+    CHECK(tom::select_equal(prices, 0.0).indices() == std::vector<size_t>{ 3 });
+    CHECK(tom::select_between(prices, -1.0, 10.0).count() == 3);
+
+    CHECK_THROWS_AS(tom::gather(values, tom::selection{ 10 }), std::invalid_argument);
+}
+
+TEST_CASE("Filter columnar archives") {
+    std::vector<order> orders;
+    for (std::uint32_t i = 0; i < 5000; ++i) {
+        orders.push_back({ i % 37, static_cast<std::int64_t>(i % 100), static_cast<double>(i % 250) / 2 });
+    }
+    std::ostringstream out;
+    tom::columnar_writer<order> writer{ out, { 2048 } };
+    for (auto const& o : orders) writer.add(o);
+    writer.finish();
+    auto const bytes = out.str();
+    tom::columnar_archive<order> archive{ reinterpret_cast<std::byte const*>(bytes.data()), bytes.size() };
+
+    size_t matches = 0;
+    for (size_t group = 0; group < archive.row_groups(); ++group) {
+        auto const customers = archive.column<0>(group);
+        auto const quantities = archive.column<1>(group);
+        auto const selected = tom::select_equal(customers, 5u) & tom::select_between(quantities, std::int64_t{ 10 }, std::int64_t{ 19 });
+        for (auto const& o : tom::gather(archive.read(group), selected)) {
+            CHECK(o.customer == 5);
+            CHECK(o.quantity >= 10);
+            CHECK(o.quantity <= 19);
+        }
+        matches += selected.count();
+    }
+    auto const expected = std::count_if(orders.begin(), orders.end(), [] (order const& o) {
+        return o.customer == 5 && o.quantity >= 10 && o.quantity <= 19;
+    });
+    CHECK(matches == static_cast<size_t>(expected));
+}
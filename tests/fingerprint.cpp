@@ -0,0 +1,61 @@
+
+#include "catch.hpp"
+
+#include <fingerprint.hpp>
+#include <list>
+#include <string>
+#include <vector>
+
+namespace {
+    struct version_1 {
+        std::uint32_t id;
+        std::string name;
+    };
+    struct same_layout {
+        std::uint32_t key;
+        std::vector<char> value;
+    };
+    struct version_2 {
+        std::uint32_t id;
+        std::string name;
+        std::optional<double> weight;
+    };
+    struct nested {
+        version_1 header;
+        std::vector<version_1> items;
+    };
+}
+
+TEST_CASE("Fingerprints") {
+    constexpr auto fingerprint = tom::fingerprint_v<version_1>;
+    static_assert(fingerprint != 0);
+
+    CHECK(tom::fingerprint_v<version_1> == tom::fingerprint_v<same_layout>);
+    CHECK(tom::fingerprint_v<version_1> == tom::fingerprint_v<std::pair<std::uint32_t, std::string>>);
+    CHECK(tom::fingerprint_v<version_1> != tom::fingerprint_v<version_2>);
+    CHECK(tom::fingerprint_v<std::int32_t> != tom::fingerprint_v<std::uint32_t>);
+    CHECK(tom::fingerprint_v<std::int32_t> != tom::fingerprint_v<std::int64_t>);
+    CHECK(tom::fingerprint_v<std::int32_t> != tom::fingerprint_v<float>);
+    CHECK(tom::fingerprint_v<std::vector<int>> != tom::fingerprint_v<std::list<int>>);
+    CHECK(tom::fingerprint_v<std::array<int, 2>> != tom::fingerprint_v<std::array<int, 3>>);
+    CHECK(tom::fingerprint_v<nested> != tom::fingerprint_v<std::pair<std::vector<version_1>, version_1>>);
+}
+
+TEST_CASE("Fingerprint check") {
+    std::vector<std::byte> bytes(8);
+    tom::output_span<> out{ bytes.data(), bytes.size() };
+    tom::write_fingerprint<version_1>(out);
+    {
+        tom::input_span<> in{ bytes.data(), bytes.size() };
+        CHECK(tom::check_fingerprint<version_1>(in));
+    }
+    {
+        tom::input_span<tom::span_policy::error> in{ bytes.data(), bytes.size() };
+        CHECK(!tom::check_fingerprint<version_2>(in));
+        CHECK(in.failed());
+    }
+    {
+        tom::input_span<> in{ bytes.data(), bytes.size() };
+        CHECK_THROWS_AS(tom::check_fingerprint<version_2>(in), tom::serialization_error);
+    }
+}
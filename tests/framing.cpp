@@ -0,0 +1,110 @@
+#include "catch.hpp"
+
+#include <framing.hpp>
+#include <evolution.hpp>
+#include <decode_limits.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+    struct entry {
+        std::uint64_t key;
+        std::string value;
+        std::vector<float> weights;
+    };
+
+    std::vector<entry> make_entries(size_t count) {
+        std::vector<entry> entries(count);
+        for (size_t i = 0; i < count; ++i) {
+            entries[i].key = i * 31;
+            entries[i].value = std::string(i % 17, 'a' + i % 26);
+            entries[i].weights.assign(i % 5, static_cast<float>(i));
+        }
+        return entries;
+    }
+}
+
+TEST_CASE("CRC32C") {
+    char const check[] = "123456789";
+    CHECK(tom::crc32c(0, check, 9) == 0xE3069283);
+    CHECK(tom::crc32c(0, check, 0) == 0);
+
+    std::vector<std::uint8_t> bytes(1000);
+    for (size_t i = 0; i < bytes.size(); ++i) bytes[i] = static_cast<std::uint8_t>(i * 7 + i / 13);
+
+    // Chunked updates, on any alignment.
+    auto const crc = tom::crc32c(0, bytes.data(), bytes.size());
+    for (size_t split : { 1, 3, 8, 13, 512, 999 }) {
+        CHECK(tom::crc32c(tom::crc32c(0, bytes.data(), split), bytes.data() + split, bytes.size() - split) == crc);
+    }
+    // Both implementations agree.
+    namespace impl = tom::detail::crc32c;
+    for (size_t offset : { 0, 1, 5 }) {
+        auto const data = bytes.data() + offset;
+        auto const size = bytes.size() - offset;
+        CHECK(impl::software(~0u, data, size) == impl::hardware(~0u, data, size));
+    }
+}
+
+TEST_CASE("Frames") {
+    auto const entries = make_entries(500);
+    std::vector<std::byte> bytes(tom::framed_size(entries));
+    REQUIRE(bytes.size() > 4096 * 2);
+    {
+        tom::output_span<> span{ bytes.data(), bytes.size() };
+        tom::serialize_framed(span, entries);
+        CHECK(span.size() == 0);
+    }
+    {
+        tom::input_span<> span{ bytes.data(), bytes.size() };
+        std::vector<entry> result;
+        tom::deserialize_framed(span, result);
+        CHECK(tom::serialized_equal(result, entries));
+    }
+    // Any flipped bit is detected.
+    for (size_t offset : { size_t{ 0 }, size_t{ 5 }, tom::frame_header_size, bytes.size() / 2, bytes.size() - 1 }) {
+        auto copy = bytes;
+        copy[offset] ^= std::byte{ 0x10 };
+        tom::input_span<tom::span_policy::error> span{ copy.data(), copy.size() };
+        std::vector<entry> result;
+        tom::deserialize_framed(span, result);
+        CHECK(span.failed());
+    }
+}
+
+TEST_CASE("Frames of patched payloads") {
+    auto const entries = make_entries(300);
+    std::vector<std::byte> bytes(tom::frame_header_size + tom::evolvable_size(entries));
+    tom::output_span<> out{ bytes.data(), bytes.size() };
+    tom::write_frame(out, [&] (auto& payload) {
+        tom::serialize_evolvable(payload, entries);
+        // The patched lengths are released, the payload is hashed as it is written.
+        CHECK(payload.pending() < 4096);
+    });
+    CHECK(out.size() == 0);
+
+    tom::input_span<> in{ bytes.data(), bytes.size() };
+    tom::input_span<> payload;
+    REQUIRE(tom::read_frame(in, payload));
+    std::vector<entry> result;
+    tom::deserialize_evolvable(payload, result);
+    CHECK(tom::serialized_equal(result, entries));
+}
+
+TEST_CASE("Frames within limits") {
+    entry const value{ 1, std::string(1000, 'x'), {} };
+    std::vector<std::byte> bytes(tom::framed_size(value));
+    tom::output_span<> out{ bytes.data(), bytes.size() };
+    tom::serialize_framed(out, value);
+
+    using error_span = tom::input_span<tom::span_policy::error>;
+    auto const decode = [&] (tom::decode_limits const& limits) {
+        tom::limited_span span{ error_span{ bytes.data(), bytes.size() }, limits };
+        entry result;
+        tom::deserialize_framed(span, result);
+        CHECK(span.allocated() == (span.failed() ? 0 : 1000));
+        return !span.failed();
+    };
+    CHECK(decode({}));
+    CHECK(!decode({ 10 }));
+}
@@ -0,0 +1,46 @@
+
+#pragma once
+
+#include "catch.hpp"
+#include <evolution.hpp>
+#include <vector>
+
+/*
+    Helpers shared by the tests of the encodings.
+*/
+
+// Serializes a value in a buffer of it's serialized size, which must be filled.
+template <class T>
+std::vector<std::byte> to_bytes(T const& value) {
+    std::vector<std::byte> bytes(tom::serialized_size(value));
+    tom::output_span<> span{ bytes.data(), bytes.size() };
+    tom::serialize(span, value);
+    CHECK(span.size() == 0);
+    return bytes;
+}
+
+// The same with 'serialize_evolvable'.
+template <class T>
+std::vector<std::byte> evolvable_bytes(T const& value) {
+    std::vector<std::byte> bytes(tom::evolvable_size(value));
+    tom::output_span<> span{ bytes.data(), bytes.size() };
+    tom::serialize_evolvable(span, value);
+    CHECK(span.size() == 0);
+    return bytes;
+}
+
+// Serializes a value and reads it back, checking that 'skip' and 'deserialize' consume all the bytes.
+template <class T>
+T round_trip(T const& value) {
+    auto const bytes = to_bytes(value);
+
+    tom::input_span<> skipped{ bytes.data(), bytes.size() };
+    tom::skip<T>(skipped);
+    CHECK(skipped.size() == 0);
+
+    tom::input_span<> in{ bytes.data(), bytes.size() };
+    T result;
+    tom::deserialize(in, result);
+    CHECK(in.size() == 0);
+    return result;
+}
@@ -0,0 +1,118 @@
+#include "catch.hpp"
+
+#include <key_encoding.hpp>
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    enum class level : std::int8_t { low = -1, mid = 0, high = 1 };
+
+    struct event_key {
+        std::int32_t shard;
+        std::string host;
+        double time;
+        std::optional<std::uint16_t> port;
+        std::vector<std::int8_t> path;
+        level severity;
+    };
+
+    bool operator<(event_key const& lhs, event_key const& rhs) {
+        return std::tie(lhs.shard, lhs.host, lhs.time, lhs.port, lhs.path, lhs.severity) <
+               std::tie(rhs.shard, rhs.host, rhs.time, rhs.port, rhs.path, rhs.severity);
+    }
+    bool operator==(event_key const& lhs, event_key const& rhs) {
+        return std::tie(lhs.shard, lhs.host, lhs.time, lhs.port, lhs.path, lhs.severity) ==
+               std::tie(rhs.shard, rhs.host, rhs.time, rhs.port, rhs.path, rhs.severity);
+    }
+
+    template <class T>
+    std::vector<std::byte> to_key(T const& value) {
+        std::vector<std::byte> bytes(tom::serialized_key_size(value));
+        tom::output_span<> span{ bytes.data(), bytes.size() };
+        tom::serialize_key(span, value);
+        CHECK(span.size() == 0);
+        return bytes;
+    }
+
+    template <class T>
+    T from_key(std::vector<std::byte> const& bytes) {
+        tom::input_span<> span{ bytes.data(), bytes.size() };
+        T value{};
+        tom::deserialize_key(span, value);
+        CHECK(span.size() == 0);
+        return value;
+    }
+
+    // The keys must be ordered as the values, and decode to them.
+    template <class T>
+    void check_order(std::vector<T> values) {
+        std::sort(values.begin(), values.end());
+        for (size_t i = 0; i < values.size(); ++i) {
+            T const value = values[i];
+            auto const key = to_key(value);
+            CHECK(from_key<T>(key) == value);
+            if (i == 0) continue;
+            T const prev_value = values[i - 1];
+            auto const prev = to_key(prev_value);
+            if (prev_value < value) CHECK(prev < key);
+            else CHECK(prev == key);
+        }
+    }
+}
+
+TEST_CASE("Key encoding of numbers") {
+    using limits = std::numeric_limits<double>;
+    check_order<std::int64_t>({ 0, -1, 1, std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int64_t>::max(), 256, -256 });
+    check_order<std::uint16_t>({ 0, 1, 255, 256, 65535 });
+    check_order<double>({ 0.0, -1.5, 1.5, limits::infinity(), -limits::infinity(), limits::denorm_min(),
+        -limits::denorm_min(), limits::max(), limits::lowest(), 1e-300, -1e300 });
+    check_order<float>({ 0.f, -0.5f, 0.5f, 3e38f, -3e38f });
+    check_order<bool>({ true, false });
+    check_order<level>({ level::high, level::low, level::mid });
+
+    // -0.0 sorts before 0.0.
+    CHECK(to_key(-0.0) < to_key(0.0));
+    CHECK(to_key(std::array<std::uint8_t, 3>{ 1, 2, 3 }).size() == 3);
+}
+
+TEST_CASE("Key encoding of strings and ranges") {
+    using namespace std::string_literals;
+    check_order<std::string>({ "", "a", "ab", "b", "a\0"s, "a\0b"s, "\0"s, "\0\0"s, "\xFF"s, "a\xFF"s, "ba" });
+    check_order<std::vector<std::int32_t>>({ {}, { 0 }, { 0, 0 }, { -1 }, { 1, -5 }, { 1 } });
+    check_order<std::vector<std::string>>({ {}, { "" }, { "", "" }, { "a" }, { "a", "b" }, { "ab" } });
+    CHECK(to_key("a\0b"s).size() == 6);
+}
+
+TEST_CASE("Key encoding of aggregates") {
+    std::mt19937 random{ 31 };
+    std::vector<event_key> keys;
+    for (int i = 0; i < 500; ++i) {
+        event_key key;
+        key.shard = static_cast<std::int32_t>(random() % 3) - 1;
+        key.host = std::string(random() % 3, static_cast<char>('a' + random() % 2));
+        key.time = static_cast<double>(static_cast<int>(random() % 5) - 2) / 4;
+        if (random() % 2) key.port = static_cast<std::uint16_t>(random() % 2 * 300);
+        for (auto n = random() % 3; n > 0; --n) key.path.push_back(static_cast<std::int8_t>(random() % 3) - 1);
+        key.severity = static_cast<level>(static_cast<int>(random() % 3) - 1);
+        keys.push_back(key);
+    }
+    check_order(keys);
+}
+
+TEST_CASE("Key decoding errors") {
+    auto const check_failure = [] (std::vector<std::uint8_t> const& bytes, auto value) {
+        tom::input_span<tom::span_policy::error> span{ reinterpret_cast<std::byte const*>(bytes.data()), bytes.size() };
+        tom::deserialize_key(span, value);
+        CHECK(span.failed());
+    };
+    check_failure({ 'a', 'b' }, std::string{});
+    check_failure({ 'a', 0 }, std::string{});
+    check_failure({ 'a', 0, 2 }, std::string{});
+    check_failure({ 1, 0, 0, 0, 1, 2 }, std::vector<std::int32_t>{});
+    check_failure({ 2 }, std::optional<int>{});
+    check_failure({ 2 }, bool{});
+}
@@ -0,0 +1,109 @@
+#include "catch.hpp"
+
+#include <parallel_compression.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+    struct sample {
+        std::uint32_t id;
+        std::string name;
+        std::vector<std::int32_t> values;
+    };
+
+    std::vector<sample> make_samples(size_t count) {
+        std::vector<sample> samples(count);
+        for (size_t i = 0; i < count; ++i) {
+            samples[i].id = static_cast<std::uint32_t>(i * 2654435761u);
+            samples[i].name = "sample_" + std::to_string(i % 100);
+            samples[i].values.assign(i % 13, static_cast<std::int32_t>(i % 7));
+        }
+        return samples;
+    }
+
+    // Encodings patching their size after writing the values, over many blocks.
+    struct catalog {
+        tom::prefix_coded<std::vector<std::string>> keys;
+        std::vector<sample> samples;
+        tom::bit_packed<std::vector<std::uint32_t>> ids;
+    };
+}
+
+TEST_CASE("Parallel block compression") {
+    tom::thread_pool pool{ 4 };
+    auto const samples = make_samples(20000);
+    auto const raw_size = tom::serialized_size(samples);
+    auto const bound = tom::compressed_bound(raw_size, 4096);
+
+    std::vector<std::byte> sequential(bound), parallel(bound);
+    tom::output_span<> sequential_out{ sequential.data(), sequential.size() };
+    tom::output_span<> parallel_out{ parallel.data(), parallel.size() };
+    tom::serialize_compressed(sequential_out, samples, 4096);
+    tom::serialize_compressed(pool, parallel_out, samples, 4096);
+
+    // The same bytes are produced.
+    auto const compressed_size = bound - parallel_out.size();
+    REQUIRE(sequential_out.size() == parallel_out.size());
+    CHECK(sequential == parallel);
+
+    tom::input_span<> in{ parallel.data(), compressed_size };
+    std::vector<sample> result;
+    tom::deserialize_compressed(pool, in, result);
+    CHECK(in.size() == 0);
+    CHECK(tom::serialized_equal(result, samples));
+
+    // A corrupted block is detected.
+    auto copy = parallel;
+    copy[compressed_size / 2] ^= std::byte{ 0x55 };
+    tom::input_span<tom::span_policy::error> corrupted{ copy.data(), compressed_size };
+    std::vector<sample> ignored;
+    tom::deserialize_compressed(pool, corrupted, ignored);
+    CHECK((corrupted.failed() || !tom::serialized_equal(ignored, samples)));
+}
+
+TEST_CASE("Parallel serialization and compression") {
+    tom::thread_pool pool{ 4 };
+    catalog value;
+    for (size_t i = 0; i < 20000; ++i) {
+        value.keys.push_back("key/" + std::to_string(100000 + i));
+        value.ids.push_back(static_cast<std::uint32_t>(i * 7 % 1000));
+    }
+    value.samples = make_samples(3000);
+
+    for (size_t block_size : { 100, 1024, 65536 }) {
+        auto const bound = tom::compressed_bound(tom::serialized_size(value), block_size);
+        std::vector<std::byte> sequential(bound), parallel(bound);
+        tom::output_span<> sequential_out{ sequential.data(), sequential.size() };
+        tom::output_span<tom::span_policy::error> parallel_out{ parallel.data(), parallel.size() };
+        tom::serialize_compressed(sequential_out, value, block_size);
+        tom::serialize_compressed(pool, parallel_out, value, block_size);
+        REQUIRE(!parallel_out.failed());
+        CHECK(sequential == parallel);
+
+        tom::input_span<> in{ parallel.data(), bound - parallel_out.size() };
+        catalog result;
+        tom::deserialize_compressed(pool, in, result);
+        CHECK(tom::serialized_equal(result, value));
+    }
+
+    // The blocks written before the span is full are not rewritten.
+    std::vector<std::byte> small(5000);
+    tom::output_span<tom::span_policy::error> small_out{ small.data(), small.size() };
+    tom::serialize_compressed(pool, small_out, value, 1024);
+    CHECK(small_out.failed());
+}
+
+TEST_CASE("Parallel compression in a small span") {
+    tom::thread_pool pool{ 3 };
+    auto const samples = make_samples(5000);
+    std::vector<std::byte> bytes(1000);
+    tom::output_span<> out{ bytes.data(), bytes.size() };
+    CHECK_THROWS_AS(tom::serialize_compressed(pool, out, samples, 1024), tom::serialization_error);
+
+    // The pool is still usable.
+    std::vector<std::byte> empty(tom::compressed_bound(0));
+    tom::output_span<> empty_out{ empty.data(), empty.size() };
+    tom::compress_blocks(pool, empty_out, nullptr, 0);
+    CHECK(empty_out.size() == 0);
+}
@@ -0,0 +1,139 @@
+#include "catch.hpp"
+#include "helpers.hpp"
+
+#include <prefix_view.hpp>
+#include <fingerprint.hpp>
+#include <decode_limits.hpp>
+#include <key_encoding.hpp>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    using keys = tom::prefix_coded<std::vector<std::string>>;
+    using sparse_keys = tom::prefix_coded<std::vector<std::string>, 4>;
+
+    template <class Keys>
+    Keys sorted_urls(size_t length, std::mt19937& random) {
+        Keys values;
+        for (size_t i = 0; i < length; ++i) {
+            values.push_back("https://example.com/users/" + std::to_string(random() % 100'000) + "/posts/" + std::to_string(random() % 1000));
+        }
+        std::sort(values.begin(), values.end());
+        return values;
+    }
+}
+
+TEST_CASE("Shared prefix") {
+    std::string const a = "abcdefghijklmnopqrstuvwxyz";
+    for (size_t i = 0; i <= a.size(); ++i) {
+        auto b = a;
+        if (i != a.size()) b[i] = '_';
+        CHECK(tom::detail::prefix::shared_prefix(a.data(), a.size(), b.data(), b.size()) == i);
+        CHECK(tom::detail::prefix::shared_prefix(a.data(), i, a.data(), a.size()) == i);
+    }
+}
+
+TEST_CASE("Prefix encoding") {
+    static_assert(tom::uses_concept_v<keys, tom::serial::concept::prefix_encoding>);
+    static_assert(!tom::uses_concept_v<tom::prefix_coded<std::vector<int>>, tom::serial::concept::prefix_encoding>);
+
+    std::mt19937 random{ 31 };
+    for (size_t length : { 0, 1, 4, 5, 16, 17, 1000 }) {
+        auto const values = sorted_urls<keys>(length, random);
+        CHECK(round_trip(values) == values);
+        auto const sparse = sorted_urls<sparse_keys>(length, random);
+        CHECK(round_trip(sparse) == sparse);
+    }
+    // Unsorted, empty and binary strings.
+    keys const mixed{ "b", "", "a\0b", std::string(1, '\0'), "zzz", "zz", "", std::string(300, 'x') };
+    CHECK(round_trip(mixed) == mixed);
+
+    auto const values = sorted_urls<keys>(10'000, random);
+    CHECK(to_bytes(values).size() * 2 < tom::serialized_size(std::vector<std::string>(values)));
+    CHECK(tom::fingerprint_v<keys> != tom::fingerprint_v<std::vector<std::string>>);
+    CHECK(tom::fingerprint_v<keys> != tom::fingerprint_v<sparse_keys>);
+}
+
+TEST_CASE("Prefix view") {
+    std::mt19937 random{ 37 };
+    for (size_t length : { 0, 1, 15, 16, 17, 2000 }) {
+        auto const values = sorted_urls<keys>(length, random);
+        auto const bytes = to_bytes(values);
+
+        tom::input_span<> span{ bytes.data(), bytes.size() };
+        tom::prefix_view<keys> view{ span };
+        CHECK(span.size() == 0);
+        REQUIRE(view.size() == values.size());
+        for (size_t i = 0; i < values.size(); ++i) {
+            CHECK(view[i] == values[i]);
+            auto const found = view.find(values[i]);
+            REQUIRE(found < values.size());
+            CHECK(values[found] == values[i]);
+        }
+        for (auto const& key : { std::string{}, std::string{ "https://example.com/users/5" }, std::string{ "zzz" } }) {
+            auto const expected = std::lower_bound(values.begin(), values.end(), key) - values.begin();
+            CHECK(view.lower_bound(key) == static_cast<size_t>(expected));
+        }
+        CHECK(!view.contains("https://example.com/users/"));
+        CHECK_THROWS_AS(view.at(values.size()), std::out_of_range);
+    }
+
+    // Memcmp-comparable keys, with zeros in them.
+    tom::prefix_coded<std::vector<std::string>, 8> encoded;
+    for (int i = -500; i < 500; ++i) {
+        std::string key(tom::serialized_key_size(std::make_pair(i % 7, i)), '\0');
+        tom::output_span<> out{ reinterpret_cast<std::byte*>(key.data()), key.size() };
+        tom::serialize_key(out, std::make_pair(i % 7, i));
+        encoded.push_back(std::move(key));
+    }
+    std::sort(encoded.begin(), encoded.end());
+    auto const bytes = to_bytes(encoded);
+    tom::input_span<> span{ bytes.data(), bytes.size() };
+    tom::prefix_view<decltype(encoded)> view{ span };
+    for (size_t i = 0; i < encoded.size(); ++i) CHECK(view.find(encoded[i]) == i);
+}
+
+TEST_CASE("Prefix encoding corruptions") {
+    sparse_keys const values{ "apple", "apricot", "banana", "band", "bandana", "cherry" };
+    auto const bytes = to_bytes(values);
+
+    auto const check_failure = [] (std::vector<std::byte> const& corrupted) {
+        tom::input_span<tom::span_policy::error> in{ corrupted.data(), corrupted.size() };
+        sparse_keys result;
+        tom::deserialize(in, result);
+        CHECK(in.failed());
+
+        tom::input_span<tom::span_policy::error> view_in{ corrupted.data(), corrupted.size() };
+        tom::prefix_view<sparse_keys> view{ view_in };
+        CHECK(view_in.failed());
+        CHECK(view.empty());
+    };
+    auto const entries = 2 * sizeof(tom::length_type);
+    auto corrupted = bytes;
+    corrupted[entries] = std::byte{ 1 }; // A shared prefix on the first entry.
+    check_failure(corrupted);
+
+    corrupted = bytes;
+    corrupted.back() = std::byte{ 1 }; // A wrong restart offset.
+    check_failure(corrupted);
+
+    corrupted = bytes;
+    corrupted[0] = std::byte{ 7 }; // More strings than entries.
+    check_failure(corrupted);
+
+    corrupted = bytes;
+    corrupted.pop_back();
+    check_failure(corrupted);
+
+    // The copies of the strings count against the allocation budget.
+    keys large(1000, std::string(1000, 'x'));
+    auto const large_bytes = to_bytes(large);
+    CHECK(large_bytes.size() < 70'000);
+    tom::limited_span limited{ tom::input_span<tom::span_policy::error>{ large_bytes.data(), large_bytes.size() },
+        tom::decode_limits{ 100'000, 1'000'000, 64 } };
+    keys result;
+    tom::deserialize(limited, result);
+    CHECK(limited.failed());
+}
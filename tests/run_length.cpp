@@ -0,0 +1,128 @@
+#include "catch.hpp"
+#include "helpers.hpp"
+
+#include <fingerprint.hpp>
+#include <array>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    struct frame {
+        std::uint32_t id;
+        tom::run_length_coded<std::vector<std::uint8_t>> occupancy;
+        tom::run_length_coded<std::vector<float>> features;
+    };
+
+    // Values dense, sparse or made of runs depending on the block.
+    template <class T>
+    void check_round_trips() {
+        std::mt19937_64 random{ sizeof(T) };
+        for (size_t length : { 0, 1, 2, 127, 128, 129, 1000 }) {
+            tom::run_length_coded<std::vector<T>> values(length);
+            for (size_t i = 0; i < length; ++i) {
+                switch (i / 128 % 3) {
+                    case 0: values[i] = static_cast<T>(random()); break;
+                    case 1: values[i] = random() % 10 == 0 ? static_cast<T>(random()) : T{}; break;
+                    case 2: values[i] = static_cast<T>(i / 20); break;
+                }
+            }
+            CHECK(round_trip(values) == values);
+        }
+    }
+}
+
+TEST_CASE("Run-length kernels") {
+    namespace impl = tom::detail::run_length;
+    std::mt19937 random{ 7 };
+    for (size_t size : { 1, 2, 3, 4, 8, 12 }) {
+        std::vector<std::uint8_t> lhs(impl::run_block * size), rhs(lhs.size());
+        for (size_t i = 0; i < lhs.size(); ++i) {
+            lhs[i] = random() % 4 == 0 ? static_cast<std::uint8_t>(random()) : 0;
+            rhs[i] = random() % 4 == 0 ? static_cast<std::uint8_t>(random()) : lhs[i];
+        }
+        for (size_t count : { 0, 1, 5, 33, 128 }) {
+            size_t equal = 0, zeros = 0;
+            for (size_t i = 0; i < count; ++i) {
+                equal += std::memcmp(&lhs[i * size], &rhs[i * size], size) == 0;
+                zeros += impl::is_zero(&lhs[i * size], size);
+            }
+            CHECK(impl::count_equal(lhs.data(), rhs.data(), count, size) == equal);
+            CHECK(impl::count_equal(lhs.data(), nullptr, count, size) == zeros);
+        }
+    }
+}
+
+TEST_CASE("Run-length encoding") {
+    static_assert(tom::uses_concept_v<tom::run_length_coded<std::vector<int>>, tom::serial::concept::run_length_encoding>);
+    static_assert(tom::uses_concept_v<tom::run_length_coded<std::vector<std::array<std::uint8_t, 3>>>, tom::serial::concept::run_length_encoding>);
+    static_assert(!tom::uses_concept_v<tom::run_length_coded<std::vector<std::string>>, tom::serial::concept::run_length_encoding>);
+
+    check_round_trips<std::uint8_t>();
+    check_round_trips<std::int16_t>();
+    check_round_trips<std::uint32_t>();
+    check_round_trips<double>();
+
+    // A grid mostly empty, and features mostly zero.
+    frame value{ 3, {}, {} };
+    std::mt19937 random{ 5 };
+    for (int i = 0; i < 10'000; ++i) {
+        value.occupancy.push_back(i % 1000 < 50 ? 1 : 0);
+        value.features.push_back(random() % 10 == 0 ? static_cast<float>(random() % 100) : 0.f);
+    }
+    CHECK(tom::serialized_size(value.occupancy) * 20 < value.occupancy.size());
+    CHECK(tom::serialized_size(value.features) * 2 < value.features.size() * sizeof(float));
+    auto const result = round_trip(value);
+    CHECK(result.occupancy == value.occupancy);
+    CHECK(result.features == value.features);
+    CHECK(tom::fingerprint_v<frame> != tom::fingerprint_v<std::tuple<std::uint32_t, std::vector<std::uint8_t>, std::vector<float>>>);
+
+    // Incompressible blocks cost one byte each.
+    tom::run_length_coded<std::vector<std::uint32_t>> noise(1000);
+    for (auto& x : noise) x = static_cast<std::uint32_t>(random()) | 1;
+    CHECK(tom::serialized_size(noise) == 4 + 1000 * 4 + 8);
+}
+
+TEST_CASE("Run-length encoding corruptions") {
+    tom::run_length_coded<std::vector<std::uint16_t>> values(200, 5);
+    std::vector<std::byte> bytes(tom::serialized_size(values));
+    tom::output_span<> out{ bytes.data(), bytes.size() };
+    tom::serialize(out, values);
+
+    // 'skip' checks the blocks like 'deserialize', so that validated buffers decode safely.
+    auto const check_failure = [] (std::vector<std::byte> const& corrupted) {
+        tom::input_span<tom::span_policy::error> in{ corrupted.data(), corrupted.size() };
+        tom::run_length_coded<std::vector<std::uint16_t>> result;
+        tom::deserialize(in, result);
+        CHECK(in.failed());
+
+        tom::input_span<tom::span_policy::error> skipped{ corrupted.data(), corrupted.size() };
+        tom::skip<tom::run_length_coded<std::vector<std::uint16_t>>>(skipped);
+        CHECK(skipped.failed());
+    };
+    auto corrupted = bytes;
+    corrupted[4] = std::byte{ 3 }; // The mode of the first block.
+    check_failure(corrupted);
+
+    corrupted = bytes;
+    corrupted[6] = std::byte{ 127 }; // The length of the first run.
+    check_failure(corrupted);
+
+    corrupted = bytes;
+    corrupted[5] = std::byte{ 200 }; // The number of runs.
+    check_failure(corrupted);
+
+    corrupted = bytes;
+    corrupted[6] = std::byte{ 100 }; // Runs not filling the block.
+    check_failure(corrupted);
+
+    tom::run_length_coded<std::vector<std::uint16_t>> sparse(100);
+    sparse[3] = 1;
+    sparse[60] = 2;
+    auto const sparse_bytes = to_bytes(sparse);
+    REQUIRE(sparse_bytes[4] == std::byte{ 2 });
+    corrupted = sparse_bytes;
+    std::swap(corrupted[6], corrupted[7]); // Indices out of order.
+    check_failure(corrupted);
+}
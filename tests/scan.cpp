@@ -0,0 +1,135 @@
+#include "catch.hpp"
+
+#include <scan.hpp>
+#include <decode_limits.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+    struct trade {
+        std::uint64_t id;
+        std::string symbol;
+        std::int32_t price;
+        std::vector<double> fills;
+    };
+
+    struct tick {
+        std::uint32_t id;
+        std::int32_t price;
+        double volume;
+    };
+
+    std::vector<trade> make_trades(size_t count) {
+        std::vector<trade> trades;
+        for (size_t i = 0; i < count; ++i) {
+            trades.push_back({ i, "SYM" + std::to_string(i % 13), static_cast<std::int32_t>(i * 37 % 1000),
+                std::vector<double>(i % 5 + 1, static_cast<double>(i)) });
+        }
+        return trades;
+    }
+
+    template <class T, class Write>
+    std::vector<std::byte> write_stream(std::vector<T> const& records, size_t size, Write&& write) {
+        std::vector<std::byte> bytes(size);
+        tom::output_span<> out{ bytes.data(), bytes.size() };
+        for (auto const& record : records) write(out, record);
+        CHECK(out.size() == 0);
+        return bytes;
+    }
+
+    std::vector<std::byte> plain_stream(std::vector<trade> const& trades) {
+        size_t size = 0;
+        for (auto const& t : trades) size += tom::serialized_size(t);
+        return write_stream(trades, size, [] (auto& out, trade const& t) { tom::serialize(out, t); });
+    }
+
+    std::vector<std::byte> framed_stream(std::vector<trade> const& trades) {
+        size_t size = 0;
+        for (auto const& t : trades) size += tom::framed_size(t);
+        return write_stream(trades, size, [] (auto& out, trade const& t) { tom::serialize_framed(out, t); });
+    }
+
+    // Rejects 99% of the trades.
+    bool selective(std::int32_t price) { return price < 10; }
+}
+
+TEST_CASE("Scan records") {
+    auto const trades = make_trades(10'000);
+    auto const bytes = plain_stream(trades);
+
+    tom::input_span<> span{ bytes.data(), bytes.size() };
+    std::vector<trade> matches;
+    auto const count = tom::scan_records<trade, 2>(span, &selective, [&] (trade&& t) { matches.push_back(std::move(t)); });
+    CHECK(span.size() == 0);
+    CHECK(count == matches.size());
+    REQUIRE(count == 100);
+    for (auto const& t : matches) {
+        auto const& expected = trades[t.id];
+        CHECK(t.symbol == expected.symbol);
+        CHECK(t.price == expected.price);
+        CHECK(t.fills == expected.fills);
+    }
+
+    // Several members, the ones between them being skipped.
+    tom::input_span<> symbols{ bytes.data(), bytes.size() };
+    auto const sym3 = tom::scan_records<trade, 0, 1>(symbols,
+        [] (std::uint64_t id, std::string const& symbol) { return id < 1000 && symbol == "SYM3"; },
+        [] (trade&& t) { CHECK(t.symbol == "SYM3"); });
+    CHECK(sym3 == 77);
+}
+
+TEST_CASE("Scan records of constant size") {
+    std::vector<tick> ticks;
+    for (std::uint32_t i = 0; i < 1000; ++i) ticks.push_back({ i, static_cast<std::int32_t>(i % 100), i * 0.5 });
+    auto const bytes = write_stream(ticks, ticks.size() * tom::constant_size_v<tick>,
+        [] (auto& out, tick const& t) { tom::serialize(out, t); });
+
+    tom::input_span<> span{ bytes.data(), bytes.size() };
+    std::vector<tick> matches;
+    tom::scan_records<tick, 1>(span, [] (std::int32_t price) { return price == 42; }, [&] (tick&& t) { matches.push_back(t); });
+    REQUIRE(matches.size() == 10);
+    CHECK(matches[3].id == 342);
+    CHECK(matches[3].volume == 171.0);
+}
+
+TEST_CASE("Scan frames") {
+    auto const trades = make_trades(10'000);
+    auto const bytes = framed_stream(trades);
+
+    tom::input_span<> span{ bytes.data(), bytes.size() };
+    std::vector<std::uint64_t> ids;
+    auto const count = tom::scan_frames<trade, 2>(span, &selective, [&] (trade&& t) {
+        CHECK(t.fills == trades[t.id].fills);
+        ids.push_back(t.id);
+    });
+    CHECK(span.size() == 0);
+    CHECK(count == 100);
+
+    // The checksums are only verified on the matches.
+    auto corrupted = bytes;
+    corrupted[tom::framed_size(trades[0]) + tom::frame_header_size + 20] ^= std::byte{ 1 }; // In the fills of trade 1.
+    tom::input_span<tom::span_policy::error> rejected{ corrupted.data(), corrupted.size() };
+    CHECK(tom::scan_frames<trade, 2>(rejected, &selective, [] (trade&&) {}) == 100);
+    CHECK(!rejected.failed());
+
+    corrupted = bytes;
+    corrupted[tom::frame_header_size + 20] ^= std::byte{ 1 }; // In the fills of trade 0, which matches.
+    tom::input_span<tom::span_policy::error> matched{ corrupted.data(), corrupted.size() };
+    CHECK(tom::scan_frames<trade, 2>(matched, &selective, [] (trade&&) {}) == 0);
+    CHECK(matched.failed());
+}
+
+TEST_CASE("Scan rejects without decoding") {
+    auto const trades = make_trades(10'000);
+    auto const bytes = plain_stream(trades);
+
+    using limited = tom::limited_span<tom::input_span<tom::span_policy::error>>;
+    limited all{ tom::input_span<tom::span_policy::error>{ bytes.data(), bytes.size() }, tom::decode_limits{} };
+    tom::scan_records<trade, 2>(all, [] (std::int32_t) { return true; }, [] (trade&&) {});
+
+    limited filtered{ tom::input_span<tom::span_policy::error>{ bytes.data(), bytes.size() }, tom::decode_limits{} };
+    tom::scan_records<trade, 2>(filtered, &selective, [] (trade&&) {});
+    CHECK(filtered.size() == 0);
+    // The strings and vectors of the rejected records are never allocated.
+    CHECK(filtered.allocated() * 50 < all.allocated());
+}
@@ -1,2 +1,212 @@
 
 #include "catch.hpp"
+#include "helpers.hpp"
+
+#include <field_mask.hpp>
+#include <serialized_view.hpp>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+    struct point {
+        float x;
+        float y;
+    };
+
+    struct item {
+        int id;
+        std::string name;
+        std::vector<point> points;
+        std::optional<int> weight;
+        std::map<std::string, int> counts;
+        std::list<std::string> tags;
+        std::unique_ptr<point> origin;
+        std::pair<int, char> pair;
+    };
+}
+
+TEST_CASE("Constant size detection") {
+    CHECK( tom::has_constant_size_v<int>);
+    CHECK( tom::has_constant_size_v<point>);
+    CHECK( tom::has_constant_size_v<std::pair<int, point>>);
+    CHECK(!tom::has_constant_size_v<std::string>);
+    CHECK(!tom::has_constant_size_v<item>);
+    CHECK(tom::constant_size_v<point> == 8);
+    CHECK(tom::constant_size_v<std::pair<int, point>> == 12);
+}
+
+TEST_CASE("Serialization round-trip") {
+    item const src{ 1, "hello", {{1, 2}, {3, 4}}, 5, {{"a", 1}}, {"x", "yy"},
+        std::make_unique<point>(point{ 7, 8 }), {3, 'c'} };
+    auto const bytes = to_bytes(src);
+
+    tom::input_span<> span{ bytes.data(), bytes.size() };
+    auto const dst = tom::deserialize<item>(span);
+    CHECK(span.size() == 0);
+    CHECK(dst.id == 1);
+    CHECK(dst.name == "hello");
+    CHECK(dst.points.size() == 2);
+    CHECK(dst.points[1].y == 4);
+    CHECK(dst.weight == 5);
+    CHECK(dst.counts.at("a") == 1);
+    CHECK(dst.tags.back() == "yy");
+    CHECK(dst.origin->x == 7);
+    CHECK(dst.pair.second == 'c');
+}
+
+TEST_CASE("Span policies") {
+    std::vector<std::byte> buffer(3);
+    std::vector<int> const values{ 1, 2, 3 };
+    {
+        tom::output_span<tom::span_policy::throwing> span{ buffer.data(), buffer.size() };
+        CHECK_THROWS_AS(tom::serialize(span, values), tom::serialization_error);
+    }
+    {
+        tom::output_span<tom::span_policy::error> span{ buffer.data(), buffer.size() };
+        tom::serialize(span, values);
+        CHECK(span.failed());
+    }
+    {
+        tom::output_span<tom::span_policy::monadic> span{ buffer.data(), buffer.size() };
+        tom::serialize(span, values);
+        tom::serialize(span, char{ 0 });
+        CHECK(span.failed());
+        CHECK(span.size() == 3);
+    }
+}
+
+TEST_CASE("Serialized view") {
+    std::vector<point> points;
+    for (int i = 0; i < 100; ++i) {
+        points.push_back({ float(i), float(-i) });
+    }
+    auto const bytes = to_bytes(std::make_pair(points, 42));
+
+    tom::input_span<> span{ bytes.data(), bytes.size() };
+    tom::serialized_view<std::vector<point>> const view{ span };
+    CHECK(view.size() == 100);
+    CHECK(view[17].x == 17);
+    CHECK(view.back().y == -99);
+    CHECK_THROWS_AS(view.at(100), std::out_of_range);
+    CHECK(tom::deserialize<int>(span) == 42);
+
+    auto const it = std::lower_bound(view.begin(), view.end(), 50.f,
+        [] (point const& p, float x) { return p.x < x; });
+    CHECK(it - view.begin() == 50);
+    CHECK((*it).y == -50);
+
+    tom::input_span<tom::span_policy::error> truncated{ bytes.data(), 100 };
+    tom::serialized_view<std::vector<point>> const empty{ truncated };
+    CHECK(truncated.failed());
+    CHECK(empty.empty());
+}
+
+namespace {
+    struct entry {
+        std::string key;
+        std::uint32_t hits;
+        std::int64_t timestamp;
+    };
+}
+
+TEST_CASE("Skip serialized values") {
+    auto const bytes = to_bytes(std::make_tuple(
+        item{ 1, "hello", {{1, 2}}, 5, {{"a", 1}}, {"x"}, nullptr, {} }, 42));
+
+    tom::input_span<> span{ bytes.data(), bytes.size() };
+    tom::skip<item>(span);
+    CHECK(tom::deserialize<int>(span) == 42);
+    CHECK(span.size() == 0);
+}
+
+TEST_CASE("Patch fields in place") {
+    std::vector<entry> entries;
+    for (int i = 0; i < 20; ++i) {
+        entries.push_back({ std::string(i, 'k'), std::uint32_t(i), 1000 + i });
+    }
+    auto bytes = to_bytes(std::make_pair(std::string{ "header" }, entries));
+    {
+        tom::output_span<> span{ bytes.data(), bytes.size() };
+        auto const hits = tom::locate<std::pair<std::string, std::vector<entry>>>(
+            span, tom::member<1>, tom::element{ 17 }, tom::member<1>);
+        CHECK(hits.get() == 17);
+        hits.set(hits.get() + 1);
+    }
+    {
+        tom::output_span<> span{ bytes.data(), bytes.size() };
+        CHECK(tom::patch<std::pair<std::string, std::vector<entry>>>(
+            span, std::int64_t{ -1 }, tom::member<1>, tom::element{ 3 }, tom::member<2>));
+    }
+    {
+        tom::output_span<tom::span_policy::error> span{ bytes.data(), bytes.size() };
+        CHECK(!tom::locate<std::pair<std::string, std::vector<entry>>>(
+            span, tom::member<1>, tom::element{ 20 }, tom::member<1>));
+    }
+    tom::input_span<> span{ bytes.data(), bytes.size() };
+    auto const result = tom::deserialize<std::pair<std::string, std::vector<entry>>>(span);
+    CHECK(result.first == "header");
+    CHECK(result.second[17].hits == 18);
+    CHECK(result.second[3].timestamp == -1);
+    CHECK(result.second[4].timestamp == 1004);
+    CHECK(result.second[19].key == std::string(19, 'k'));
+}
+
+TEST_CASE("Read selected fields") {
+    item const src{ 7, "name", {{1, 2}, {3, 4}}, 3, {{"a", 1}}, {"x", "y"}, nullptr, {5, 'z'} };
+    std::vector<std::byte> bytes(tom::serialized_size(src) + sizeof(int));
+    tom::output_span<> out{ bytes.data(), bytes.size() };
+    tom::serialize(out, src);
+    tom::serialize(out, 42);
+
+    tom::input_span<> span{ bytes.data(), bytes.size() };
+    auto const [id, weight, pair] = tom::read_fields<item, 0, 3, 7>(span);
+    CHECK(id == 7);
+    CHECK(weight == 3);
+    CHECK(pair.second == 'z');
+    CHECK(tom::deserialize<int>(span) == 42);
+
+    tom::input_span<> other{ bytes.data(), bytes.size() };
+    auto const [points] = tom::read_fields<item, 2>(other);
+    CHECK(points.size() == 2);
+    CHECK(points[1].x == 3);
+}
+
+TEST_CASE("Serialize selected fields") {
+    entry const src{ "key", 3, 1000 };
+    {
+        std::vector<std::byte> bytes(tom::serialized_size(src, tom::fields<1, 2>));
+        CHECK(bytes.size() == 1 + 4 + 8);
+        tom::output_span<> out{ bytes.data(), bytes.size() };
+        tom::serialize_fields(out, src, tom::fields<1, 2>);
+        CHECK(out.size() == 0);
+
+        entry dst{ "old", 0, 0 };
+        tom::input_span<> in{ bytes.data(), bytes.size() };
+        auto const mask = tom::deserialize_fields(in, dst);
+        CHECK(mask.to_ulong() == 0b110);
+        CHECK(dst.key == "old");
+        CHECK(dst.hits == 3);
+        CHECK(dst.timestamp == 1000);
+    }
+    {
+        tom::field_mask<entry> mask;
+        mask[0] = true;
+        std::vector<std::byte> bytes(tom::serialized_size(src, mask));
+        tom::output_span<> out{ bytes.data(), bytes.size() };
+        tom::serialize_fields(out, src, mask);
+        CHECK(out.size() == 0);
+
+        entry dst{ "old", 5, 6 };
+        tom::input_span<> in{ bytes.data(), bytes.size() };
+        CHECK(tom::deserialize_fields(in, dst) == mask);
+        CHECK(dst.key == "key");
+        CHECK(dst.hits == 5);
+
+        bytes[0] = std::byte{ 0xFF };
+        tom::input_span<tom::span_policy::error> corrupted{ bytes.data(), bytes.size() };
+        tom::deserialize_fields(corrupted, dst);
+        CHECK(corrupted.failed());
+    }
+}
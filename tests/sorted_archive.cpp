@@ -0,0 +1,167 @@
+#include "catch.hpp"
+
+#include <sorted_archive.hpp>
+#include <serialized_view.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+    struct record {
+        std::string name;
+        std::vector<std::int32_t> samples;
+
+        friend bool operator==(record const& lhs, record const& rhs) {
+            return lhs.name == rhs.name && lhs.samples == rhs.samples;
+        }
+    };
+
+    using key_type = std::pair<std::string, std::int64_t>;
+    using archive = tom::sorted_archive<key_type, record>;
+
+    key_type key_of(size_t i) {
+        return { "tenant-" + std::to_string(i % 10), static_cast<std::int64_t>(i) * 3 - 5000 };
+    }
+    record record_of(key_type const& key) {
+        return { key.first + "/" + std::to_string(key.second), std::vector<std::int32_t>(static_cast<size_t>(key.second % 7 + 7), 42) };
+    }
+
+    // The keys of 0..count by increasing key encoding.
+    std::vector<key_type> sorted_keys(size_t count) {
+        std::vector<key_type> keys;
+        for (size_t i = 0; i < count; ++i) keys.push_back(key_of(i));
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    }
+
+    std::string write_archive(std::vector<key_type> const& keys, tom::archive_options options = {}) {
+        std::ostringstream out;
+        tom::sorted_archive_writer<key_type, record> writer{ out, options };
+        for (auto const& key : keys) writer.add(key, record_of(key));
+        writer.finish();
+        return out.str();
+    }
+
+    archive open_bytes(std::string const& bytes) {
+        return { reinterpret_cast<std::byte const*>(bytes.data()), bytes.size() };
+    }
+}
+
+TEST_CASE("Bloom filter") {
+    std::vector<std::uint8_t> filter(tom::detail::bloom::filter_size(1000, 10));
+    auto const probes = tom::detail::bloom::hash_count(10);
+    for (int i = 0; i < 1000; ++i) {
+        tom::detail::bloom::add(filter.data(), filter.size(), tom::detail::archive::key_hash(std::to_string(i)), probes);
+    }
+    size_t false_positives = 0;
+    for (int i = 0; i < 1000; ++i) {
+        CHECK(tom::detail::bloom::may_contain(filter.data(), filter.size(), tom::detail::archive::key_hash(std::to_string(i)), probes));
+        false_positives += tom::detail::bloom::may_contain(filter.data(), filter.size(),
+            tom::detail::archive::key_hash(std::to_string(i + 1000)), probes);
+    }
+    CHECK(false_positives < 30);
+}
+
+TEST_CASE("Sorted archive lookups") {
+    for (size_t count : { 0, 1, 16, 17, 5000 }) {
+        for (tom::archive_options options : { tom::archive_options{}, tom::archive_options{ 3, 0 } }) {
+            auto const keys = sorted_keys(count);
+            auto const bytes = write_archive(keys, options);
+            auto const archive = open_bytes(bytes);
+            REQUIRE(archive.size() == count);
+
+            for (auto const& key : keys) {
+                record value;
+                REQUIRE(archive.get(key, value));
+                CHECK(value == record_of(key));
+            }
+            CHECK(!archive.contains({ "tenant-0", 1 }));
+            CHECK(!archive.contains({ "", 0 }));
+            CHECK(!archive.contains({ "tenant-9", 1'000'000 }));
+            CHECK(!archive.contains({ "zzz", 0 }));
+
+            size_t i = 0;
+            archive.for_each([&] (std::string_view, archive::value_span value) {
+                record decoded;
+                tom::deserialize(value, decoded);
+                CHECK(decoded == record_of(keys[i++]));
+            });
+            CHECK(i == count);
+        }
+    }
+}
+
+TEST_CASE("Sorted archive zero-copy values") {
+    using samples_archive = tom::sorted_archive<std::uint32_t, std::vector<double>>;
+    std::ostringstream out;
+    tom::sorted_archive_writer<std::uint32_t, std::vector<double>> writer{ out };
+    for (std::uint32_t i = 0; i < 100; ++i) writer.add(i * 2, std::vector<double>(i + 1, i * 0.5));
+    writer.finish();
+    auto const bytes = out.str();
+    samples_archive const archive{ reinterpret_cast<std::byte const*>(bytes.data()), bytes.size() };
+
+    auto value = archive.find(84);
+    REQUIRE(value);
+    // The value points in the archive, it is read without being copied.
+    CHECK(value->begin() >= reinterpret_cast<std::byte const*>(bytes.data()));
+    CHECK(value->end() <= reinterpret_cast<std::byte const*>(bytes.data() + bytes.size()));
+    tom::serialized_view<std::vector<double>> view{ *value };
+    REQUIRE(view.size() == 43);
+    CHECK(view[42] == 21.0);
+    CHECK(!archive.find(85));
+}
+
+TEST_CASE("Sorted archive files") {
+    auto const keys = sorted_keys(2000);
+    auto const path = (std::filesystem::temp_directory_path() / "tapeworm_sorted_archive.twa").string();
+    {
+        std::ofstream file{ path, std::ios::binary };
+        tom::sorted_archive_writer<key_type, record> writer{ file };
+        for (auto const& key : keys) writer.add(key, record_of(key));
+        writer.finish();
+    }
+    {
+        auto archive = archive::open(path);
+        CHECK(archive.size() == keys.size());
+        record value;
+        REQUIRE(archive.get(keys[1234], value));
+        CHECK(value == record_of(keys[1234]));
+        auto moved = std::move(archive);
+        CHECK(moved.contains(keys[0]));
+    }
+    std::remove(path.c_str());
+    CHECK_THROWS_AS(archive::open(path), std::system_error);
+}
+
+TEST_CASE("Sorted archive errors") {
+    std::ostringstream out;
+    tom::sorted_archive_writer<key_type, record> writer{ out };
+    writer.add({ "b", 1 }, record_of({ "b", 1 }));
+    CHECK_THROWS_AS(writer.add({ "a", 1 }, record_of({ "a", 1 })), std::invalid_argument);
+    CHECK_THROWS_AS(writer.add({ "b", 1 }, record_of({ "b", 1 })), std::invalid_argument);
+    CHECK_THROWS_AS((tom::sorted_archive_writer<int, int>{ out, { 0, 10 } }), std::invalid_argument);
+
+    auto const bytes = write_archive(sorted_keys(100));
+    CHECK_THROWS_AS((tom::sorted_archive<key_type, std::string>{
+        reinterpret_cast<std::byte const*>(bytes.data()), bytes.size() }), tom::serialization_error);
+    CHECK_THROWS_AS(open_bytes(bytes.substr(0, bytes.size() - 1)), tom::serialization_error);
+    CHECK_THROWS_AS(open_bytes(bytes.substr(1)), tom::serialization_error);
+    for (size_t i : { 100, 300 }) {
+        auto corrupted = bytes;
+        corrupted[bytes.size() - i] ^= 0x20; // In the keys or the index : the checksum fails.
+        CHECK_THROWS_AS(open_bytes(corrupted), tom::serialization_error);
+    }
+
+    // The footer is not checksummed, the restart interval and the number of probes are bounded.
+    for (size_t i : { 16, 12 }) {
+        auto corrupted = bytes;
+        corrupted[bytes.size() - i + 3] = '\x40';
+        CHECK_THROWS_AS(open_bytes(corrupted), tom::serialization_error);
+    }
+}
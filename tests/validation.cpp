@@ -0,0 +1,151 @@
+#include "catch.hpp"
+#include "helpers.hpp"
+
+#include <validation.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+    struct item {
+        std::uint32_t id;
+        std::string name;
+        std::optional<bool> flag;
+    };
+    struct message {
+        std::vector<item> items;
+        std::vector<bool> bits;
+        std::array<bool, 2> pair;
+    };
+
+    // Encodings holding booleans.
+    struct flagged {
+        std::string name;
+        bool flag;
+        std::optional<bool> extra;
+    };
+    using flagged_records = tom::dictionary_coded<std::vector<flagged>>;
+    struct named_flag {
+        std::string name;
+        bool flag;
+    };
+    using bool_pairs = tom::run_length_coded<std::vector<std::array<bool, 2>>>;
+
+    struct encoded {
+        flagged_records records;
+        bool_pairs pairs;
+    };
+
+    template <class T>
+    std::optional<tom::validated<T>> validate_bytes(std::vector<std::byte> const& bytes) {
+        tom::input_span<tom::span_policy::error> span{ bytes.data(), bytes.size() };
+        auto validated = tom::validate<T>(span);
+        CHECK(validated.has_value() != span.failed());
+        return validated;
+    }
+}
+
+TEST_CASE("Validated decoding") {
+    message const msg{ { { 1, "one", true }, { 2, "two", std::nullopt } }, { true, false, true }, { false, true } };
+    auto const bytes = to_bytes(msg);
+
+    tom::input_span<tom::span_policy::error> span{ bytes.data(), bytes.size() };
+    auto const validated = tom::validate<message>(span);
+    REQUIRE(validated);
+    CHECK(span.size() == 0);
+    CHECK(validated->size() == bytes.size());
+
+    auto const result = validated->deserialize();
+    CHECK(tom::serialized_equal(result, msg));
+    CHECK(result.items[0].name == "one");
+    CHECK(result.bits == msg.bits);
+}
+
+TEST_CASE("Validation failures") {
+    message const msg{ { { 1, "one", true } }, { true }, { false, true } };
+    auto const bytes = to_bytes(msg);
+
+    // Every truncation is detected.
+    for (size_t size = 0; size < bytes.size(); ++size) {
+        tom::input_span<tom::span_policy::error> span{ bytes.data(), size };
+        CHECK(!tom::validate<message>(span));
+        CHECK(span.failed());
+    }
+    // Invalid booleans, optional flags and lengths.
+    auto const corrupted = [&] (size_t offset, std::uint8_t byte) {
+        auto copy = bytes;
+        copy[offset] = static_cast<std::byte>(byte);
+        tom::input_span<> span{ copy.data(), copy.size() };
+        CHECK_THROWS_AS(tom::validate<message>(span), tom::serialization_error);
+    };
+    corrupted(bytes.size() - 1, 2);  // pair[1]
+    corrupted(bytes.size() - 3, 2);  // bits[0]
+    corrupted(4 + 4 + 4 + 3, 7);     // items[0].flag
+    corrupted(4 + 4, 0xFF);          // items[0].name length
+
+    // Nesting limit.
+    tom::input_span<tom::span_policy::error> span{ bytes.data(), bytes.size() };
+    static_assert(tom::nesting_depth_v<message> == 4);
+    CHECK(!tom::validate<message>(span, 3));
+    CHECK(span.failed());
+}
+
+TEST_CASE("Validation of encoded booleans") {
+    encoded value;
+    for (int i = 0; i < 300; ++i) {
+        value.records.push_back({ "name-" + std::to_string(i % 5), i % 3 == 0, i % 4 == 0 ? std::optional<bool>{ true } : std::nullopt });
+    }
+    // Raw, runs and sparse blocks.
+    value.pairs.resize(3 * 128);
+    for (size_t i = 0; i < 128; ++i) value.pairs[i] = { i % 2 == 0, i % 3 == 0 };
+    for (size_t i = 128; i < 256; ++i) value.pairs[i] = { true, i < 200 };
+    value.pairs[300] = { false, true };
+    auto const bytes = to_bytes(value);
+
+    auto const validated = validate_bytes<encoded>(bytes);
+    REQUIRE(validated);
+    CHECK(validated->size() == bytes.size());
+    CHECK(tom::serialized_equal(validated->deserialize(), value));
+
+    // Any byte changed to an invalid boolean is either rejected or not a boolean.
+    for (size_t offset = 0; offset < bytes.size(); ++offset) {
+        auto corrupted = bytes;
+        corrupted[offset] = std::byte{ 2 };
+        if (auto const result = validate_bytes<encoded>(corrupted)) {
+            auto const decoded = result->deserialize();
+            for (auto const& record : decoded.records) {
+                CHECK(reinterpret_cast<std::uint8_t const&>(record.flag) <= 1);
+            }
+            for (auto const& pair : decoded.pairs) {
+                CHECK(reinterpret_cast<std::uint8_t const&>(pair[0]) <= 1);
+                CHECK(reinterpret_cast<std::uint8_t const&>(pair[1]) <= 1);
+            }
+        }
+    }
+    auto corrupted = bytes;
+    corrupted.back() = std::byte{ 2 };
+    CHECK(!validate_bytes<encoded>(corrupted));
+}
+
+TEST_CASE("Validation of malformed encodings") {
+    // A dictionary ending in the size of it's first string.
+    std::vector<std::byte> bytes;
+    for (int byte : { 1, 0, 0, 0, 1, 0, 0, 0, 0x7F, 1 }) bytes.push_back(static_cast<std::byte>(byte));
+    CHECK(!validate_bytes<tom::dictionary_coded<std::vector<named_flag>>>(bytes));
+
+    // Indices out of the dictionary.
+    flagged_records const records{ { "a", true, std::nullopt }, { "b", false, std::nullopt } };
+    bytes = to_bytes(records);
+    bytes[bytes.size() - 3] = std::byte{ 2 }; // The index of "b".
+    CHECK(!validate_bytes<flagged_records>(bytes));
+    tom::dictionary_coded<std::vector<std::string>> const strings{ "a", "b", "a" };
+    bytes = to_bytes(strings);
+    bytes.back() = std::byte{ 2 };
+    CHECK(!validate_bytes<tom::dictionary_coded<std::vector<std::string>>>(bytes));
+
+    // Runs not filling their block.
+    bool_pairs const pairs(100, { true, false });
+    bytes = to_bytes(pairs);
+    REQUIRE(bytes[4] == std::byte{ 1 });
+    bytes[6] = std::byte{ 99 };
+    CHECK(!validate_bytes<bool_pairs>(bytes));
+}
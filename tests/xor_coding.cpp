@@ -0,0 +1,111 @@
+#include "catch.hpp"
+#include "helpers.hpp"
+
+#include <fingerprint.hpp>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+    template <class Float>
+    void check_round_trips() {
+        using limits = std::numeric_limits<Float>;
+        std::mt19937_64 random{ sizeof(Float) };
+        std::uniform_real_distribution<Float> noise{ -1, 1 };
+        for (size_t length : { 0, 1, 2, 3, 100, 1000 }) {
+            tom::time_series<std::vector<Float>> slow(length), noisy(length);
+            Float value = 20;
+            for (size_t i = 0; i < length; ++i) {
+                if (random() % 4 == 0) value += Float(0.25);
+                slow[i] = value;
+                noisy[i] = noise(random) * static_cast<Float>(random() % 1000);
+            }
+            if (length > 8) {
+                noisy[1] = limits::quiet_NaN();
+                noisy[2] = limits::infinity();
+                noisy[3] = -limits::infinity();
+                noisy[4] = limits::denorm_min();
+                noisy[5] = -Float(0);
+                noisy[6] = limits::max();
+                noisy[7] = limits::lowest();
+            }
+            // Compared bitwise because of the NaN.
+            CHECK(tom::serialized_equal(round_trip(slow), slow));
+            CHECK(tom::serialized_equal(round_trip(noisy), noisy));
+        }
+    }
+}
+
+TEST_CASE("Bit streams") {
+    std::mt19937_64 random{ 11 };
+    std::vector<std::pair<std::uint64_t, unsigned>> fields;
+    size_t bits = 0;
+    for (int i = 0; i < 1000; ++i) {
+        auto const count = static_cast<unsigned>(random() % 65);
+        fields.emplace_back(random() & tom::detail::bits::low_mask(count), count);
+        bits += count;
+    }
+
+    std::vector<std::byte> bytes((bits + 7) / 8);
+    tom::output_span<> out{ bytes.data(), bytes.size() };
+    tom::bit_writer<decltype(out)> writer{ out };
+    for (auto const& [value, count] : fields) writer.write(value, count);
+    writer.flush();
+    CHECK(writer.size() == bytes.size());
+    CHECK(out.size() == 0);
+
+    tom::input_span<tom::span_policy::error> in{ bytes.data(), bytes.size() };
+    tom::bit_reader<decltype(in)> reader{ in };
+    for (auto const& [value, count] : fields) CHECK(reader.read(count) == value);
+    CHECK(!in.failed());
+    reader.read(8);
+    CHECK(in.failed());
+}
+
+TEST_CASE("XOR encoding") {
+    static_assert(tom::uses_concept_v<tom::time_series<std::vector<double>>, tom::serial::concept::xor_encoding>);
+    static_assert(tom::uses_concept_v<tom::time_series<std::vector<float>>, tom::serial::concept::xor_encoding>);
+    static_assert(tom::uses_concept_v<std::vector<double>, tom::serial::concept::trivial_array>);
+    static_assert(!tom::uses_concept_v<tom::time_series<std::vector<int>>, tom::serial::concept::xor_encoding>);
+
+    check_round_trips<float>();
+    check_round_trips<double>();
+
+    // Metric samples changing slowly.
+    tom::time_series<std::vector<double>> samples;
+    std::mt19937 random{ 13 };
+    double value = 12.5;
+    for (int i = 0; i < 10'000; ++i) {
+        if (random() % 8 == 0) value += 0.5;
+        samples.push_back(value);
+    }
+    CHECK(tom::serialized_size(samples) * 8 < tom::serialized_size(std::vector<double>(samples)));
+    CHECK(round_trip(samples) == samples);
+
+    CHECK(tom::fingerprint_v<tom::time_series<std::vector<double>>> != tom::fingerprint_v<std::vector<double>>);
+    CHECK(tom::fingerprint_v<tom::time_series<std::vector<double>>> != tom::fingerprint_v<tom::time_series<std::vector<float>>>);
+}
+
+TEST_CASE("XOR encoding corruptions") {
+    tom::time_series<std::vector<double>> values{ 1.0, 2.0, 3.0, 4.0 };
+    std::vector<std::byte> bytes(tom::serialized_size(values));
+    tom::output_span<> out{ bytes.data(), bytes.size() };
+    tom::serialize(out, values);
+
+    // A stream too small for the values.
+    auto truncated = bytes;
+    truncated[4] = std::byte{ 8 };
+    tom::input_span<tom::span_policy::error> in{ truncated.data(), truncated.size() };
+    decltype(values) result;
+    tom::deserialize(in, result);
+    CHECK(in.failed());
+
+    // A meaningful length overflowing the value.
+    auto invalid = bytes;
+    std::uint64_t header = 0b11 | 31 << 2 | 63 << 7;
+    for (int i = 0; i < 2; ++i) invalid[16 + i] = static_cast<std::byte>(header >> 8 * i);
+    tom::input_span<tom::span_policy::error> invalid_in{ invalid.data(), invalid.size() };
+    tom::deserialize(invalid_in, result);
+    CHECK(invalid_in.failed());
+}
@@ -0,0 +1,141 @@
+/*
+    tapeworm_sort : sorts a file of framed records (written by 'serialize_framed') with 'sort_frames'.
+
+    A program doesn't know the type of the records, so they are sorted on their leading members, given as a
+    list of types : the records of an aggregate are the serialization of it's members in order, and the key
+    is the serialization of those members with 'serialize_key'.
+
+    tapeworm_sort --key u32,i64 events.bin sorted.bin
+*/
+
+#include <external_sort.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    using payload_span = tom::input_span<tom::span_policy::error>;
+    using key_member = std::function<void(payload_span&, std::vector<std::byte>&)>;
+
+    template <class T>
+    key_member member() {
+        return [] (payload_span& payload, std::vector<std::byte>& key) {
+            T value{};
+            tom::deserialize(payload, value);
+            if (!payload.failed()) tom::append_key(key, value);
+        };
+    }
+
+    // A bool is read as a byte, as any other value would be undefined.
+    template <>
+    key_member member<bool>() {
+        return [] (payload_span& payload, std::vector<std::byte>& key) {
+            std::uint8_t value = 0;
+            tom::deserialize(payload, value);
+            if (payload.failed()) return;
+            if (value > 1) payload.fail("tapeworm : invalid boolean");
+            else tom::append_key(key, value != 0);
+        };
+    }
+
+    key_member parse_member(std::string const& type) {
+        if (type == "bool") return member<bool>();
+        if (type == "i8") return member<std::int8_t>();
+        if (type == "i16") return member<std::int16_t>();
+        if (type == "i32") return member<std::int32_t>();
+        if (type == "i64") return member<std::int64_t>();
+        if (type == "u8") return member<std::uint8_t>();
+        if (type == "u16") return member<std::uint16_t>();
+        if (type == "u32") return member<std::uint32_t>();
+        if (type == "u64") return member<std::uint64_t>();
+        if (type == "f32") return member<float>();
+        if (type == "f64") return member<double>();
+        if (type == "string") return member<std::string>();
+        throw std::invalid_argument{ "unknown key type '" + type + "'" };
+    }
+
+    std::vector<key_member> parse_key(std::string const& types) {
+        std::vector<key_member> members;
+        for (size_t begin = 0, end; begin <= types.size(); begin = end + 1) {
+            end = std::min(types.find(',', begin), types.size());
+            members.push_back(parse_member(types.substr(begin, end - begin)));
+        }
+        return members;
+    }
+
+    size_t parse_size(std::string const& value, size_t unit) {
+        size_t used = 0;
+        auto const size = std::stoull(value, &used);
+        if (used != value.size() || size == 0) throw std::invalid_argument{ "invalid size '" + value + "'" };
+        return static_cast<size_t>(size) * unit;
+    }
+
+    int usage() {
+        std::cerr << "usage : tapeworm_sort --key <types> [options] <input> <output>\n"
+            "  --key <types>      the leading members of the records, separated by commas, among\n"
+            "                     bool, i8, i16, i32, i64, u8, u16, u32, u64, f32, f64 and string\n"
+            "  --memory <MiB>     the size of the runs sorted in memory (64)\n"
+            "  --buffer <KiB>     the size of the file buffers (1024)\n"
+            "  --fan-in <count>   the number of runs merged at once (64)\n"
+            "  --temp <path>      the directory of the runs (the system temporary directory)\n"
+            "  --no-io-thread     reads and writes the files on the sorting thread\n";
+        return 2;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> args{ argv + 1, argv + argc };
+    std::vector<std::string> files;
+    std::vector<key_member> key;
+    tom::sort_options options;
+    try {
+        for (size_t i = 0; i < args.size(); ++i) {
+            auto const& arg = args[i];
+            if (arg == "--no-io-thread") {
+                options.io_thread = false;
+                continue;
+            }
+            if (arg.rfind("--", 0) != 0) {
+                files.push_back(arg);
+                continue;
+            }
+            if (i + 1 == args.size()) return usage();
+            auto const& value = args[++i];
+            if (arg == "--key") key = parse_key(value);
+            else if (arg == "--memory") options.memory_budget = parse_size(value, 1024 * 1024);
+            else if (arg == "--buffer") options.buffer_size = parse_size(value, 1024);
+            else if (arg == "--fan-in") options.max_fan_in = parse_size(value, 1);
+            else if (arg == "--temp") options.temp_directory = value;
+            else return usage();
+        }
+    }
+    catch (std::logic_error const& e) {
+        std::cerr << "tapeworm_sort : " << e.what() << '\n';
+        return usage();
+    }
+    if (key.empty() || files.size() != 2) return usage();
+
+    try {
+        std::ifstream in{ files[0], std::ios::binary };
+        if (!in) throw std::runtime_error{ "can't open '" + files[0] + "'" };
+        std::ofstream out{ files[1], std::ios::binary | std::ios::trunc };
+        if (!out) throw std::runtime_error{ "can't create '" + files[1] + "'" };
+
+        auto const count = tom::sort_frames(in, out, [&key] (payload_span& payload, std::vector<std::byte>& bytes) {
+            for (auto const& append : key) append(payload, bytes);
+        }, options);
+        out.close();
+        if (!out) throw std::runtime_error{ "can't write '" + files[1] + "'" };
+        std::cerr << "tapeworm_sort : " << count << " records\n";
+    }
+    catch (std::exception const& e) {
+        std::cerr << "tapeworm_sort : " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}